@@ -0,0 +1,113 @@
+// Shares the active cast between processes on one machine.
+//  Publisher:   SspProfileShare publish <cast file> [<cast file> ...]
+//           or  SspProfileShare watch <directory>   (publishes each cast as it is written there)
+//  Subscribers: SspProfileShare subscribe   (start as many as needed, in other terminals)
+// The publisher sends each file in turn, one per second, and the subscribers print every update
+// along with how long it took to arrive.
+#include <chrono>
+#include <mutex>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <SspCpp/DirectoryWatcher.h>
+#include <SspCpp/SharedProfile.h>
+#include <SspCpp/SoundSpeed.h>
+
+static const char* regionName = "SspCppActiveProfile";
+
+
+static int Publish(int argc, char* argv[])
+{
+    ssp::ProfilePublisher publisher;
+    if (!publisher.Open(regionName))
+        return 1;
+
+    for (int i = 2; i < argc; i++)
+    {
+        auto cast = ssp::ReadCast(argv[i]);
+        if (!cast)
+            continue;
+
+        // Stash the publish time in the description so subscribers can report the latency
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        cast->desc = std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+        publisher.Publish(*cast);
+        std::cout << "Published " << argv[i] << " (" << cast->entries.size() << " entries) as version " << publisher.Version() << "\n";
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+    std::cout << "Done, press Enter to remove the shared region\n";
+    std::cin.get();
+    return 0;
+}
+
+
+static int Watch(const std::string& directory)
+{
+    ssp::ProfilePublisher publisher;
+    if (!publisher.Open(regionName))
+        return 1;
+
+    std::mutex publishMutex;  // Files can finish parsing on several threads at once
+    ssp::DirectoryWatcher watcher;
+    auto onFile = [&](const std::string& fileName, std::vector<ssp::SCast>& casts) {
+        if (casts.empty())
+            return;
+        ssp::SCast& cast = casts.back();
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        cast.desc = std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+
+        std::lock_guard<std::mutex> lock(publishMutex);
+        publisher.Publish(cast);
+        std::cout << "Published " << fileName << " as version " << publisher.Version() << "\n";
+    };
+    if (!watcher.Start(directory, onFile))
+        return 1;
+
+    std::cout << "Watching " << directory << ", press Enter to stop\n";
+    std::cin.get();
+    return 0;
+}
+
+
+static int Subscribe()
+{
+    ssp::ProfileSubscriber subscriber;
+    while (!subscriber.Open(regionName))
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    uint64_t version = 0;
+    ssp::SCast cast;
+    for (;;)
+    {
+        if (!subscriber.WaitForUpdate(version, std::chrono::seconds(10)))
+        {
+            std::cout << "No update for 10 seconds, exiting\n";
+            return 0;
+        }
+
+        const auto now = std::chrono::steady_clock::now().time_since_epoch();
+        subscriber.Read(cast, &version);
+        const long long sent = std::stoll(cast.desc);
+        const long long latency = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() - sent;
+        std::cout << "Version " << version << ": " << cast.fileName << ", " << cast.entries.size()
+            << " entries, received after " << latency / 1000.0 << " us\n";
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    const std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "publish" && argc > 2)
+        return Publish(argc, argv);
+    if (mode == "watch" && argc > 2)
+        return Watch(argv[2]);
+    if (mode == "subscribe")
+        return Subscribe();
+
+    std::cout << "Usage: SspProfileShare publish <cast file> [<cast file> ...]\n"
+                 "       SspProfileShare watch <directory>\n"
+                 "       SspProfileShare subscribe\n";
+    return 1;
+}
@@ -0,0 +1,80 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Absorption.h
+  * \brief  Frequency dependent absorption of sound in seawater
+  */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    enum class eAbsorptionModel
+    {
+        FrancoisGarrison,  //!< Francois and Garrison (1982): boric acid, magnesium sulphate and pure water terms
+        AinslieMcColm      //!< Ainslie and McColm (1998): simpler fit, within about 10% of Francois-Garrison
+    };
+
+    /*!
+     * \brief Absorption in dB/km
+     * \param frequencyKHz Frequency in kilohertz (valid for about 0.2 to 1000 kHz)
+     * \param temp Temperature in degrees Celsius ([-2, 22] C for Francois-Garrison's boric acid term, wider for the others)
+     * \param salin Salinity in ppt
+     * \param depth Depth in meters
+     * \param pH Acidity (8 is typical for the open ocean)
+     */
+    SSPCPP_EXPORT double Absorption(double frequencyKHz, double temp, double salin, double depth, double pH = 8.0,
+        eAbsorptionModel model = eAbsorptionModel::FrancoisGarrison);
+
+    /*!
+     * \brief Absorption for count samples at each of numFrequencies frequencies
+     *
+     * The output is a depth x frequency matrix stored one frequency at a time: the values for frequency k
+     * are absorption[k * count, (k + 1) * count). The terms that only depend on temperature, salinity and
+     * depth are found once per sample and stored one column per coefficient, so the per-frequency loop reads
+     * at unit stride, has no calls, and vectorizes.
+     */
+    SSPCPP_EXPORT void Absorption(const double* temp, const double* salin, const double* depth, size_t count,
+        const double* frequenciesKHz, size_t numFrequencies, double* absorption, double pH = 8.0,
+        eAbsorptionModel model = eAbsorptionModel::FrancoisGarrison);
+
+    /*!
+     * \brief Absorption at every entry of a cast for each frequency, in the layout of the batch version
+     *
+     * Entries without a salinity (0) use 35 ppt.
+     */
+    SSPCPP_EXPORT std::vector<double> CastAbsorption(const SCast& cast, const std::vector<double>& frequenciesKHz,
+        double pH = 8.0, eAbsorptionModel model = eAbsorptionModel::FrancoisGarrison);
+
+    //! Fills SCastEntry::absorp (dB/km) at one frequency. Entries without a salinity (0) use 35 ppt.
+    SSPCPP_EXPORT void FillAbsorption(SCast& cast, double frequencyKHz, double pH = 8.0,
+        eAbsorptionModel model = eAbsorptionModel::FrancoisGarrison);
+};
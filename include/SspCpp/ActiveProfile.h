@@ -0,0 +1,194 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   ActiveProfile.h
+  * \brief  Precompiled profiles and lock-free switching of the profile in use
+  *
+  * A SCompiledProfile is built once from a cast (sorted constant-gradient layers, a depth lookup table and the
+  * travel time to each layer) and never changes afterwards. ActiveProfile holds the one that ray tracing
+  * threads should use right now. Publishing a new profile is a single pointer swap; readers pin the current
+  * profile with an epoch marker in their own slot, so they take no locks and never touch a shared reference
+  * count. Old profiles are freed once no reader can still be looking at them.
+  */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    //! Sound speed varies linearly with depth within a layer: c(z) = c0 + gradient * (z - top)
+    struct SSPCPP_EXPORT SLayer
+    {
+        double top = 0;  //!< Depth of the top of the layer in meters
+        double bottom = 0;  //!< Depth of the bottom of the layer in meters
+        double c0 = 0;  //!< Sound speed at the top of the layer in meters/second
+        double gradient = 0;  //!< Change in sound speed per meter of depth (1/s)
+    };
+
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::vector
+
+    //! Immutable, query-ready form of a cast. Create with CompileProfile.
+    struct SSPCPP_EXPORT SCompiledProfile
+    {
+        std::vector<SLayer> layers;  //!< Sorted by depth, with no gaps between them
+        std::vector<uint32_t> table;  //!< table[k] is the layer holding depth layers[0].top + k * tableStep
+        double tableStep = 1;
+        std::vector<double> travelTime;  //!< travelTime[n] is the one-way time (s) from MinDepth to layers[n].top, plus one for MaxDepth
+
+        std::string fileName;  //!< From the source cast
+        std::tm time = {};
+        double lat = 0;
+        double lon = 0;
+
+        double MinDepth() const { return layers.front().top; }
+        double MaxDepth() const { return layers.back().bottom; }
+
+        /*!
+         * \brief Index of the layer holding depth (clamped to the first or last layer)
+         *
+         * The lookup table narrows the search to the layers overlapping one table step, so this is O(1) for casts
+         * on a uniform grid and O(log n) at worst.
+         */
+        size_t Layer(double depth) const;
+
+        //! Sound speed at depth. Depths above or below the cast get the first or last sound speed.
+        double SoundSpeed(double depth) const;
+
+        /*!
+         * \brief Vertical one-way travel time in seconds from MinDepth to depth
+         *
+         * Uses the exact integral of 1/c through each constant-gradient layer. Above or below the cast the
+         * first or last sound speed continues, so the result is negative above MinDepth.
+         */
+        double TravelTime(double depth) const;
+
+        //! Vertical one-way travel time in seconds between two depths (in either order)
+        double TravelTime(double fromDepth, double toDepth) const { return std::abs(TravelTime(toDepth) - TravelTime(fromDepth)); }
+
+        //! Harmonic mean sound speed between two depths: distance over travel time (the sound speed if they are equal)
+        double HarmonicMean(double fromDepth, double toDepth) const;
+
+        //! Batch version of TravelTime between pairs of depths. The output may be one of the input arrays.
+        void TravelTime(const double* fromDepth, const double* toDepth, double* time, size_t count) const;
+
+        //! Batch version of HarmonicMean between pairs of depths. The output may be one of the input arrays.
+        void HarmonicMean(const double* fromDepth, const double* toDepth, double* c, size_t count) const;
+    };
+#pragma warning(pop)
+
+    /*!
+     * \brief Builds the layer model and lookup table for a cast
+     * \param tableStep Spacing of the depth lookup table in meters (made coarser for very deep casts)
+     * \returns nullptr if the cast has fewer than two entries with distinct depths and a positive sound speed
+     *
+     * Entries may be in any order; they are sorted by depth and repeated depths are dropped.
+     */
+    SSPCPP_EXPORT std::shared_ptr<const SCompiledProfile> CompileProfile(const SCast& cast, double tableStep = 1.0);
+
+
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::unique_ptr
+
+    /*!
+     * \brief The profile currently in use, replaceable at any time while other threads query it
+     *
+     * \code
+     *     ssp::ActiveProfile active;
+     *     active.Publish(ssp::CompileProfile(cast));
+     *
+     *     // On any thread
+     *     if (auto profile = active.Read())
+     *         c = profile->SoundSpeed(depth);  // The profile stays valid until 'profile' goes out of scope
+     * \endcode
+     *
+     * Up to maxReaderThreads threads can hold Readers at the same time; more than that wait for a free slot.
+     * A thread's slot is given back when its last open Reader closes, so any number of threads can take turns.
+     * Readers must be closed on the thread that opened them.
+     * Readers are meant to be short lived (a ray or a batch of queries); an old profile is only freed once
+     * every Reader that was open when it was replaced has closed.
+     */
+    class SSPCPP_EXPORT ActiveProfile
+    {
+    public:
+        static constexpr size_t maxReaderThreads = 256;
+
+        ActiveProfile();
+        ~ActiveProfile();
+        ActiveProfile(const ActiveProfile&) = delete;
+        ActiveProfile& operator=(const ActiveProfile&) = delete;
+
+        //! Pins the current profile for as long as it exists. Nested Readers on one thread are fine.
+        class SSPCPP_EXPORT Reader
+        {
+        public:
+            ~Reader();
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+
+            explicit operator bool() const { return profile != nullptr; }
+            const SCompiledProfile& operator*() const { return *profile; }
+            const SCompiledProfile* operator->() const { return profile; }
+            const SCompiledProfile* Get() const { return profile; }
+
+        private:
+            friend class ActiveProfile;
+            explicit Reader(const ActiveProfile& active);
+            void* slot;
+            const SCompiledProfile* profile;
+        };
+
+        //! Pins and returns the current profile (empty if nothing has been published). Lock free.
+        Reader Read() const { return Reader(*this); }
+
+        //! Makes profile the current one. Publishers are serialized with each other, but never wait for readers.
+        void Publish(std::shared_ptr<const SCompiledProfile> profile);
+
+        //! Compiles and publishes a cast. Returns false (keeping the current profile) if the cast cannot be compiled.
+        bool Publish(const SCast& cast, double tableStep = 1.0);
+
+        //! Shared ownership of the current profile, for keeping it beyond a Reader's lifetime. Takes a lock.
+        std::shared_ptr<const SCompiledProfile> Snapshot() const;
+
+        //! Number of profiles published so far
+        uint64_t Version() const;
+
+        //! Replaced profiles not yet freed because a reader may still be using them
+        size_t PendingReclaim() const;
+
+    private:
+        struct SImpl;
+        std::unique_ptr<SImpl> impl;
+    };
+#pragma warning(pop)
+};
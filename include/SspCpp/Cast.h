@@ -29,8 +29,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <ctime>
+#include <memory_resource>
 #include <string>
+#include <utility>
 #include <vector>
 #include "sspcpp_export.h"
 
@@ -39,13 +42,17 @@ namespace ssp
 {
     struct SSPCPP_EXPORT SCastEntry
     {
-        SCastEntry() { depth = 0; c = 0; temp = 0; salinity = 0; pressure = 0; absorp = 0; }
+        SCastEntry() { depth = 0; c = 0; temp = 0; salinity = 0; pressure = 0; absorp = 0; density = 0; sigmaT = 0; n2 = 0; flags = 0; }
         double depth;  //!< Depth in meters
         double c;      //!< Sound speed in meters/second
         double temp;   //!< Temperature in degrees Celsius
         double salinity;  //!< Salinity in parts per thousand (ppt)
         double pressure;  //!< Usually expressed as depth (bars???)
-        double absorp;  //!< Absorption /// @todo: Do any casts typically have this?
+        double absorp;  //!< Absorption in dB/km at some frequency (0 unless filled in with FillAbsorption)
+        double density;  //!< In situ density in kg/m^3 (0 unless filled in with FillDensity)
+        double sigmaT;  //!< Density at the surface minus 1000 kg/m^3
+        double n2;  //!< Squared buoyancy frequency in 1/s^2 (positive when stable)
+        uint32_t flags;  //!< Quality control flags (eQcFlag bits, see QualityCheck); 0 if the sample passed
     };
 
 #pragma warning(push)
@@ -61,5 +68,46 @@ namespace ssp
         double lat;  //!< Latitude
         double lon;  //!< Longitude
     };
+
+    namespace pmr
+    {
+        /*!
+         * \brief SCast with every allocation (strings, entries) coming from a memory resource
+         *
+         * Batch jobs can give each worker thread a std::pmr::monotonic_buffer_resource and read many casts
+         * into it without touching the global allocator, then release the whole batch at once.
+         * The cast is allocator-aware, so containers such as std::pmr::vector<SCast> pass their resource on
+         * to the casts they hold.
+         */
+        struct SSPCPP_EXPORT SCast
+        {
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+            explicit SCast(const allocator_type& alloc = {})
+                : desc(alloc), fileName(alloc), entries(alloc)
+            {
+                lat = 0; lon = 0; time = {};
+            }
+            SCast(const SCast& other, const allocator_type& alloc)
+                : desc(other.desc, alloc), fileName(other.fileName, alloc), entries(other.entries, alloc),
+                time(other.time), lat(other.lat), lon(other.lon) {}
+            SCast(SCast&& other, const allocator_type& alloc)
+                : desc(std::move(other.desc), alloc), fileName(std::move(other.fileName), alloc),
+                entries(std::move(other.entries), alloc), time(other.time), lat(other.lat), lon(other.lon) {}
+            SCast(const SCast& other) = default;
+            SCast(SCast&& other) = default;
+            SCast& operator=(const SCast& other) = default;
+            SCast& operator=(SCast&& other) = default;
+
+            allocator_type get_allocator() const { return entries.get_allocator(); }
+
+            std::pmr::string desc;  //!< Description of type of file read from
+            std::pmr::string fileName;  //!< Filename of this cast
+            std::pmr::vector<SCastEntry> entries;
+            std::tm time;
+            double lat;  //!< Latitude
+            double lon;  //!< Longitude
+        };
+    };
 #pragma warning(pop)
 };
@@ -0,0 +1,88 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file   CastTable.h
+ * \brief  Column-oriented storage for large numbers of casts
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::vector
+
+    /*!
+     * \brief Many casts stored as one set of columns
+     *
+     * The samples of every cast are stored back-to-back in each column, which keeps bulk processing
+     * of large archives cache-friendly. The samples of cast n are in [offsets[n], offsets[n + 1]).
+     */
+    struct SSPCPP_EXPORT SCastTable
+    {
+        SCastTable() { offsets.push_back(0); }
+
+        size_t NumCasts() const { return offsets.size() - 1; }
+        size_t NumSamples() const { return depth.size(); }
+
+        // Per-cast values
+        std::vector<size_t> offsets;  //!< Start of each cast's samples (has one more entry than there are casts)
+        std::vector<std::string> fileNames;
+        std::vector<std::tm> times;
+        std::vector<double> lats;
+        std::vector<double> lons;
+
+        // Per-sample values (same meaning and units as in SCastEntry)
+        std::vector<double> depth;
+        std::vector<double> c;
+        std::vector<double> temp;
+        std::vector<double> salinity;
+        std::vector<double> pressure;
+
+        // Derived per-sample values (see FillDensity); zero until filled in
+        std::vector<double> density;
+        std::vector<double> sigmaT;
+        std::vector<double> n2;
+        std::vector<uint32_t> flags;  //!< Quality control flags (see QualityCheck)
+    };
+#pragma warning(pop)
+
+    //! Adds a cast to the end of the table
+    SSPCPP_EXPORT void AppendCast(SCastTable& table, const SCast& cast);
+
+    //! Adds all casts from another table to the end of this one
+    SSPCPP_EXPORT void AppendTable(SCastTable& table, const SCastTable& other);
+
+    //! Creates a regular cast from entry n of the table
+    SSPCPP_EXPORT SCast GetCast(const SCastTable& table, size_t n);
+};
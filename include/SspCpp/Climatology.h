@@ -0,0 +1,91 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Climatology.h
+  * \brief  Gridded temperature/salinity climatology and extension of casts to full depth
+  *
+  * Climatology files are a simple binary grid, written by WriteClimatology (e.g., after converting World
+  * Ocean Atlas data). The layout, in native byte order, is:
+  *  - "SSPCLIM1", then uint32 numLat, numLon, numDepth and a zero uint32
+  *  - double lat0, latStep, lon0, lonStep (degrees)
+  *  - double depths[numDepth] (meters, increasing)
+  *  - float temp[numLat][numLon][numDepth], then float salinity in the same order (NaN where there is no data)
+  */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::vector
+
+    //! An in-memory climatology grid, used to create climatology files
+    struct SSPCPP_EXPORT SClimatologyGrid
+    {
+        double lat0 = 0;  //!< Latitude of the first row (degrees)
+        double latStep = 1;
+        size_t numLat = 0;
+        double lon0 = 0;  //!< Longitude of the first column (degrees)
+        double lonStep = 1;
+        size_t numLon = 0;
+        std::vector<double> depths;  //!< Depth levels in meters, increasing
+        std::vector<float> temp;  //!< Degrees Celsius, indexed [(lat * numLon + lon) * depths.size() + depth]
+        std::vector<float> salinity;  //!< Parts per thousand, same indexing as temp
+    };
+#pragma warning(pop)
+
+    //! Writes a climatology grid in the format described above
+    SSPCPP_EXPORT bool WriteClimatology(const std::string& fileName, const SClimatologyGrid& grid);
+
+    /*!
+     * \brief Temperature and salinity at a position and depth, interpolated in latitude, longitude and depth
+     *
+     * The file is memory-mapped on first use and stays cached (see ClearClimatologyCache).
+     * \returns false if the file cannot be loaded or there is no data at this point
+     */
+    SSPCPP_EXPORT bool ClimatologyAt(const std::string& fileName, double lat, double lon, double depth,
+        double& temp, double& salinity);
+
+    /*!
+     * \brief Extends a cast to the deepest climatology level at its position
+     *
+     * Entries are added every step meters below the deepest entry, with sound speed from the climatology
+     * temperature and salinity (using DepthToPressure and WongZhu). Just below the junction the climatology is
+     * shifted to match the cast's last entry, with the shift fading out linearly over blendDepth meters.
+     * The cast must be sorted by depth and have a position.
+     * \returns Number of entries added, or 0 if the climatology has no data below the cast
+     */
+    SSPCPP_EXPORT size_t ExtendCast(SCast& cast, const std::string& climatologyFile, double step = 10.0,
+        double blendDepth = 100.0);
+
+    //! Unmaps all cached climatology files
+    SSPCPP_EXPORT void ClearClimatologyCache();
+};
@@ -0,0 +1,93 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Comparison.h
+  * \brief  Differences between sound speed profiles and their effect on swath soundings
+  */
+
+#pragma once
+
+#include <optional>
+#include <vector>
+#include "ActiveProfile.h"
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    //! Geometry of the soundings used to judge a profile change
+    struct SSPCPP_EXPORT SSwathGeometry
+    {
+        double transducerDepth = 0;  //!< Meters
+        double waterDepth = 100;  //!< Depth of the seafloor in meters
+        double maxBeamAngle = 65;  //!< Outermost beam, in degrees from vertical
+        unsigned int numBeams = 14;  //!< Beams evenly spread from vertical to maxBeamAngle (one side of the swath)
+    };
+
+    //! How much a profile differs from a reference one. Values that cannot be found are NaN.
+    struct SSPCPP_EXPORT SProfileDifference
+    {
+        double maxSpeedDifference;  //!< Largest absolute sound speed difference (m/s) over the depths both cover
+        double maxSpeedDifferenceDepth;  //!< Depth of the largest difference
+        double rmsSpeedDifference;  //!< Root mean square sound speed difference (m/s)
+        double maxDepthError;  //!< Largest absolute sounding depth error (m) over the swath
+        double maxHorizontalError;  //!< Largest absolute across-track position error (m) over the swath
+    };
+
+    /*!
+     * \brief Compares a profile with the reference it might replace
+     *
+     * Sound speeds are compared every gridStep meters over the depths both profiles cover. For the swath, each beam
+     * is ray traced through the reference to the seafloor, and then through the other profile for the same travel
+     * time and launch angle. The differences in where the two rays end are the errors a sounding would have if
+     * the wrong one of the two profiles were used. Beams that turn back up before the seafloor are skipped.
+     */
+    SSPCPP_EXPORT SProfileDifference CompareProfiles(const SCompiledProfile& reference, const SCompiledProfile& profile,
+        const SSwathGeometry& swath = {}, double gridStep = 1.0);
+
+    //! Compares two casts (see the compiled profile version). Empty if either cast cannot be compiled.
+    SSPCPP_EXPORT std::optional<SProfileDifference> CompareProfiles(const SCast& reference, const SCast& cast,
+        const SSwathGeometry& swath = {}, double gridStep = 1.0);
+
+    //! One comparison from CompareWithNeighbours
+    struct SSPCPP_EXPORT SNeighbourComparison
+    {
+        size_t cast = 0;  //!< Index into the new casts
+        size_t neighbour = 0;  //!< Index into the existing casts
+        double distance = 0;  //!< Meters between the two cast positions
+        SProfileDifference difference = {};  //!< The new cast compared against the neighbour as the reference
+    };
+
+    /*!
+     * \brief Compares every new cast against all existing casts within radiusMeters of it
+     *
+     * Each cast is compiled once and new casts are handled in parallel (0 threads = one per core). Results are
+     * ordered by new cast, then by neighbour. Casts that cannot be compiled are left out.
+     */
+    SSPCPP_EXPORT std::vector<SNeighbourComparison> CompareWithNeighbours(const std::vector<SCast>& newCasts,
+        const std::vector<SCast>& existingCasts, double radiusMeters, const SSwathGeometry& swath = {},
+        double gridStep = 1.0, unsigned int numThreads = 0);
+};
@@ -0,0 +1,83 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   CtdProcessing.h
+  * \brief  Turning raw CTD time series into a single-direction, depth-binned cast
+  *
+  * Profilers that log continuously (Sea-Bird .cnv, Sea&Sun) record the surface soak, the downcast and the upcast
+  * in one series, with heave loops wherever the ship pulled the instrument back up. Sorting these by depth
+  * (Reorder) mixes the casts together, so these routines split them in time order instead.
+  */
+
+#pragma once
+
+#include <vector>
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    enum class eCastDirection
+    {
+        Down,  //!< Samples from the start of the final descent to the deepest sample
+        Up  //!< Samples from the deepest sample back to the surface
+    };
+
+    //! Settings for SplitCast
+    struct SSPCPP_EXPORT SCastSplitOptions
+    {
+        eCastDirection direction = eCastDirection::Down;
+        double soakDepth = 3;  //!< The downcast starts the last time the instrument was above this depth (m) before the turning point, dropping the soak; 0 keeps the whole descent
+        double binSize = 1;  //!< Bins (m) centered on multiples of this; 0 keeps every sample
+    };
+
+    //! Index of the deepest entry (the first one if there are ties), where the downcast turns into the upcast
+    SSPCPP_EXPORT size_t FindTurningPoint(const SCast& cast);
+
+    /*!
+     * \brief Keeps one direction of a raw cast, removes the soak and heave loops, and bin averages it
+     *
+     * Entries must be in the order they were recorded. Only samples that go deeper than every sample before them
+     * (shallower for the upcast) are kept, so loops are dropped rather than averaged in. The result is sorted by
+     * increasing depth for either direction. Entries without a finite depth are dropped. Each step is a single pass
+     * over the entries.
+     * \returns The number of entries left
+     */
+    SSPCPP_EXPORT size_t SplitCast(SCast& cast, const SCastSplitOptions& options = {});
+
+    //! Splits many casts in parallel (0 threads = one per core)
+    SSPCPP_EXPORT void SplitCasts(std::vector<SCast>& casts, const SCastSplitOptions& options = {}, unsigned int numThreads = 0);
+
+    /*!
+     * \brief Averages the entries in each depth bin of binSize meters (centered on multiples of binSize)
+     *
+     * Entries must be sorted by increasing depth, so each bin is one run of entries and no sorting or bin array
+     * is needed. Every value is averaged, depth is set to the bin center and the flags of the bin are combined.
+     * Entries without a finite depth are dropped.
+     * \returns The number of bins
+     */
+    SSPCPP_EXPORT size_t BinAverage(SCast& cast, double binSize);
+};
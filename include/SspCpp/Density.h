@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Density.h
+  * \brief  Seawater density (EOS-80) and buoyancy frequency
+  */
+
+#pragma once
+
+#include <cstddef>
+#include "Cast.h"
+#include "CastTable.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    /*!
+     * \brief In situ density from the UNESCO 1980 equation of state (EOS-80)
+     *
+     * From "Algorithms for computation of fundamental properties of seawater", Fofonoff and Millard (1983).
+     * Temperatures are ITS-90 and converted to IPTS-68 for the equation.
+     * \param temp Temperature in degrees Celsius
+     * \param salin Salinity in ppt
+     * \param pressure Pressure in bars (relative to the surface)
+     * \returns Density in kg/m^3
+     */
+    SSPCPP_EXPORT double Density(double temp, double salin, double pressure);
+
+    //! Batch version of Density for arrays of count samples. The output may be one of the input arrays.
+    SSPCPP_EXPORT void Density(const double* temp, const double* salin, const double* pressure, double* density, size_t count);
+
+    //! Density at the surface minus 1000 kg/m^3 (sigma-t)
+    SSPCPP_EXPORT double SigmaT(double temp, double salin);
+
+    /*!
+     * \brief Temperature a parcel would have if moved adiabatically from pressure to referencePressure (all in bars)
+     *
+     * Fofonoff (1977) Runge-Kutta integration of the Bryden (1973) adiabatic lapse rate.
+     */
+    SSPCPP_EXPORT double PotentialTemperature(double temp, double salin, double pressure, double referencePressure = 0);
+
+    /*!
+     * \brief Squared buoyancy (Brunt-Vaisala) frequency N^2 in 1/s^2 for a profile sorted by depth
+     *
+     * At each sample, the neighbours above and below are moved adiabatically to the sample's pressure and
+     * N^2 = g / rho * d(rho) / dz over them (one-sided at the ends). Positive values are stable. Profiles with
+     * fewer than 2 samples give 0.
+     */
+    SSPCPP_EXPORT void BuoyancyFrequency(const double* temp, const double* salin, const double* pressure, const double* depth,
+        double* n2, size_t count, double latitudeDeg);
+
+    /*!
+     * \brief Fills the density, sigmaT and n2 of each entry
+     *
+     * Entries need temperature and should be sorted by depth. Missing salinity (0) is taken as 35 ppt, and
+     * pressure is computed from depth at the cast's latitude when it is 0.
+     */
+    SSPCPP_EXPORT void FillDensity(SCast& cast);
+
+    //! Fills the density, sigmaT and n2 columns of every cast in a table, in parallel (0 threads = one per core)
+    SSPCPP_EXPORT void FillDensity(SCastTable& table, unsigned int numThreads = 0);
+};
@@ -0,0 +1,104 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   DirectoryWatcher.h
+  * \brief  Watches a directory and reads new casts as soon as they are written (Linux only)
+  *
+  * Built on inotify: a file is picked up when the writer closes it (IN_CLOSE_WRITE) or when it is renamed
+  * into the directory (IN_MOVED_TO). Each file then has to stay untouched for a short settle time, so
+  * writers that close and reopen a file while it is still being written are only read once, when done.
+  * Files are parsed on a worker pool and handed to a callback. With nothing to do, the watcher threads
+  * sleep in the kernel and use no CPU.
+  */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    struct SSPCPP_EXPORT SWatchOptions
+    {
+        //! How long a file must go without another write or rename before it is read
+        std::chrono::milliseconds settleTime{ 20 };
+        unsigned int numThreads = 0;  //!< Parsing threads (0 = one per core)
+        bool readExisting = false;  //!< Also read the files already in the directory when watching starts
+    };
+
+    struct SSPCPP_EXPORT SWatchStats
+    {
+        size_t files = 0;  //!< Files handed to the callback
+        size_t casts = 0;  //!< Casts read from them
+        size_t failures = 0;  //!< Files of a known type that held no readable cast, or whose callback threw
+    };
+
+    /*!
+     * \brief Receives every cast read from one file
+     *
+     * Called on a worker thread, possibly for several files at once. casts is empty if the file could not
+     * be read. Files with an extension DetermineFileType does not recognize (including temporary files that
+     * are later renamed) are skipped without calling it. An exception thrown by the callback is caught and
+     * counted in SWatchStats::failures, and watching continues.
+     */
+    using WatchCallback = std::function<void(const std::string& fileName, std::vector<SCast>& casts)>;
+
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::unique_ptr
+
+    class SSPCPP_EXPORT DirectoryWatcher
+    {
+    public:
+        DirectoryWatcher();
+        ~DirectoryWatcher();  //!< Stops watching
+        DirectoryWatcher(const DirectoryWatcher&) = delete;
+        DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+        /*!
+         * \brief Starts watching directory (not its subdirectories) on background threads
+         * \returns false if already running, the directory cannot be watched, or the platform is not Linux
+         */
+        bool Start(const std::string& directory, WatchCallback callback, const SWatchOptions& options = {});
+
+        //! Stops watching. Files already waiting to be read are still read before this returns.
+        void Stop();
+
+        bool IsRunning() const;
+        SWatchStats Stats() const;
+
+    private:
+        struct SImpl;
+        std::unique_ptr<SImpl> impl;
+    };
+
+#pragma warning(pop)
+};
@@ -0,0 +1,66 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Equations.h
+  * \brief  Choice of equation for computing sound speed from temperature, salinity and pressure
+  */
+
+#pragma once
+
+#include <cstddef>
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    enum class eSoundSpeedEquation
+    {
+        WongZhu,      //!< Chen-Millero refit for ITS-90 temperatures by Wong and Zhu (1995). The library default.
+        ChenMillero,  //!< UNESCO (Chen and Millero 1977, Fofonoff and Millard 1983) with its IPTS-68 coefficients
+        DelGrosso,    //!< Del Grosso (1974) with its IPTS-68 coefficients
+        Mackenzie     //!< Mackenzie (1981) nine-term equation. Uses depth, found from pressure and latitude.
+    };
+
+    /*!
+     * \brief Sound speed in meters/second with the chosen equation
+     *
+     * Temperatures are ITS-90, as from every reader. ChenMillero and DelGrosso were published for IPTS-68,
+     * so they are evaluated at T68 = 1.00024 T90, which is how Wong and Zhu (1995) refit them for ITS-90.
+     *
+     * Valid ranges:
+     *  WongZhu, ChenMillero: temp [0, 40] C, salinity [0, 40] ppt, pressure [0, 1000] bar
+     *  DelGrosso: temp [0, 30] C, salinity [30, 40] ppt, pressure [0, 1000] bar
+     *  Mackenzie: temp [-2, 30] C, salinity [25, 40] ppt, depth [0, 8000] m
+     *
+     * \param[in] pressure Pressure in bars
+     * \param[in] latitudeDeg Only used by Mackenzie, to turn pressure into depth
+     */
+    SSPCPP_EXPORT double SoundSpeed(eSoundSpeedEquation equation, double temp, double salin, double pressure,
+        double latitudeDeg = 45.0);
+
+    //! Batch version of SoundSpeed for arrays of count samples. The output may be one of the input arrays.
+    SSPCPP_EXPORT void SoundSpeed(eSoundSpeedEquation equation, const double* temp, const double* salin, const double* pressure,
+        double* c, size_t count, double latitudeDeg = 45.0);
+};
@@ -0,0 +1,78 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Features.h
+  * \brief  Summary acoustic features of casts (layer depths, sound channel, duct cutoff)
+  */
+
+#pragma once
+
+#include <vector>
+#include "Cast.h"
+#include "CastTable.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    //! Thresholds used when extracting features
+    struct SSPCPP_EXPORT SFeatureOptions
+    {
+        double referenceDepth = 10;  //!< Depth (m) of the reference temperature for the mixed layer
+        double temperatureThreshold = 0.2;  //!< Change from the reference temperature (C) that ends the mixed layer
+        double speedTolerance = 0.2;  //!< Drop below the near-surface maximum (m/s) that ends the sonic layer
+    };
+
+    /*!
+     * \brief Summary features of one cast. Features a cast does not have are NaN.
+     */
+    struct SSPCPP_EXPORT SAcousticFeatures
+    {
+        double surfaceSpeed;  //!< Sound speed (m/s) at the shallowest sample
+        double maxDepth;  //!< Depth (m) of the deepest sample
+        double mixedLayerDepth;  //!< Where the temperature first differs from the reference by the threshold (needs temperature)
+        double sonicLayerDepth;  //!< Depth of the near-surface sound speed maximum, the bottom of the surface duct
+        double ductCutoffFrequency;  //!< Lowest frequency (Hz) trapped in the surface duct (NaN without a duct)
+        double sofarDepth;  //!< Depth of the sound speed minimum (NaN if the cast ends before speeds increase again)
+        double sofarSpeed;  //!< Sound speed at the minimum
+        double criticalDepth;  //!< Depth below the minimum where the speed is back to the maximum above it
+    };
+
+    /*!
+     * \brief Finds all features in one pass over a cleaned cast (entries sorted by increasing depth, see Cleanup)
+     *
+     * The duct cutoff uses the mean gradient g = dc/dz across the sonic layer of thickness H:
+     * f = 9 c0^1.5 / (16 sqrt(2 g) H^1.5), which gives the usual 1500 / (0.008 H^1.5) for an isothermal layer.
+     */
+    SSPCPP_EXPORT SAcousticFeatures ExtractFeatures(const SCast& cast, const SFeatureOptions& options = {});
+
+    //! Features of many casts, one row per cast, found in parallel (0 threads = one per core)
+    SSPCPP_EXPORT std::vector<SAcousticFeatures> ExtractFeatures(const std::vector<SCast>& casts,
+        const SFeatureOptions& options = {}, unsigned int numThreads = 0);
+
+    //! Features of every cast in a table, one row per cast, found in parallel (0 threads = one per core)
+    SSPCPP_EXPORT std::vector<SAcousticFeatures> ExtractFeatures(const SCastTable& table,
+        const SFeatureOptions& options = {}, unsigned int numThreads = 0);
+};
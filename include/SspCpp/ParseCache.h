@@ -0,0 +1,77 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   ParseCache.h
+  * \brief  Optional on-disk cache of parsed casts, used by ReadCast
+  *
+  * When enabled, each cast read with ReadCast is stored in a compact binary file in the cache directory.
+  * Later reads of the same source file are served from a memory map of that file instead of parsing the
+  * text again. The least recently used entries are removed when the cache grows past its size limit.
+  */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    //! How a source file is matched to its cache entry
+    enum class eCacheKey
+    {
+        FileInfo,    //!< Path, size and modification time (fast, but misses changes that keep all three)
+        ContentHash  //!< Hash of the file contents (survives copies and renames, costs a read of the file)
+    };
+
+    struct SSPCPP_EXPORT SParseCacheStats
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t bytes = 0;  //!< Current size of the cache directory's entries
+    };
+
+    /*!
+     * \brief Turns on the cache for ReadCast, creating the directory if needed
+     * \param maxBytes Entries are evicted (least recently used first) when the total is larger than this
+     * \returns false if the directory cannot be created
+     */
+    SSPCPP_EXPORT bool EnableParseCache(const std::string& directory, size_t maxBytes = 256 << 20,
+        eCacheKey key = eCacheKey::FileInfo);
+
+    //! Turns off the cache. Entries stay on disk for the next time it is enabled.
+    SSPCPP_EXPORT void DisableParseCache();
+
+    //! Removes the cache entry for one source file, so the next read parses it again
+    SSPCPP_EXPORT void InvalidateParseCache(const std::string& fileName);
+
+    //! Removes every entry from the cache directory
+    SSPCPP_EXPORT void ClearParseCache();
+
+    //! Hit/miss/eviction counts since the cache was enabled
+    SSPCPP_EXPORT SParseCacheStats GetParseCacheStats();
+};
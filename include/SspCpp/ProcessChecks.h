@@ -32,8 +32,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include "LatLong.h"
 #include "Cast.h"
+#include "CastTable.h"
 #include "sspcpp_export.h"
 
 
@@ -72,4 +74,54 @@ namespace ssp
     SSPCPP_EXPORT bool CheckLimits(const SCastEntry& entry);
 
     SSPCPP_EXPORT bool Cleanup(SCast& cast);
+
+
+    //! Bits of SCastEntry::flags set by QualityCheck
+    enum eQcFlag : uint32_t
+    {
+        QcLimits = 1 << 0,  //!< Fails CheckLimits or has a NaN/infinite value (the sample is left out of the other tests)
+        QcSpeedSpike = 1 << 1,  //!< Sound speed far from the rolling median
+        QcTempSpike = 1 << 2,  //!< Temperature far from the rolling median
+        QcSalinitySpike = 1 << 3,  //!< Salinity far from the rolling median
+        QcGradient = 1 << 4,  //!< Some value changes faster than its limit from the sample above
+        QcDensityInversion = 1 << 5  //!< Denser water above, after moving both samples to the same pressure
+    };
+
+    //! Thresholds for QualityCheck. A limit of 0 turns that test off.
+    struct SSPCPP_EXPORT SQcOptions
+    {
+        size_t window = 11;  //!< Samples in the rolling median window (centered, so odd sizes are best)
+        double spikeThreshold = 5;  //!< Spikes differ from the median by more than this many robust standard deviations (1.4826 MAD)...
+        double minSpeedSpike = 0.5;  //!< ...and by at least this much (m/s), since quantized data can have a MAD of 0
+        double minTempSpike = 0.1;  //!< Degrees C
+        double minSalinitySpike = 0.1;  //!< ppt
+        double maxSpeedGradient = 5;  //!< m/s per m
+        double maxTempGradient = 2;  //!< Degrees C per m
+        double maxSalinityGradient = 2;  //!< ppt per m
+        double densityInversion = 0.03;  //!< kg/m^3 (needs temperature and salinity)
+    };
+
+    /*!
+     * \brief Rolling median and median absolute deviation over a centered window (shortened at the ends)
+     *
+     * The window is kept sorted as it slides, so each sample takes O(log window) comparisons plus moving
+     * at most window values. NaN values are left out of the windows (a window of only NaN gives NaN).
+     */
+    SSPCPP_EXPORT void RollingMedian(const double* values, size_t count, size_t window, double* median, double* mad);
+
+    /*!
+     * \brief Sets the flags of every entry from the tests in eQcFlag
+     *
+     * Entries must be sorted by depth. Samples are flagged rather than removed, so the cast can be checked again
+     * with other thresholds (each call starts from clear flags) and the flagged entries dropped with RemoveFlagged.
+     * Channels that are all 0 (not in the file) are not tested.
+     * \returns The number of flagged entries
+     */
+    SSPCPP_EXPORT size_t QualityCheck(SCast& cast, const SQcOptions& options = {});
+
+    //! Sets the flags column of every cast in the table, in parallel (0 threads = one per core). Returns the number flagged.
+    SSPCPP_EXPORT size_t QualityCheck(SCastTable& table, const SQcOptions& options = {}, unsigned int numThreads = 0);
+
+    //! Removes entries with any of the flags in mask set. Returns the number removed.
+    SSPCPP_EXPORT size_t RemoveFlagged(SCast& cast, uint32_t mask = ~uint32_t(0));
 };
@@ -0,0 +1,64 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   RayTrace.h
+  * \brief  Ray tracing through a compiled (constant-gradient layer) profile
+  */
+
+#pragma once
+
+#include <optional>
+#include "ActiveProfile.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    //! A point along a ray, relative to where it was launched
+    struct SSPCPP_EXPORT SRayPoint
+    {
+        double depth = 0;  //!< Depth in meters
+        double horizontal = 0;  //!< Horizontal distance from the launch point in meters
+        double time = 0;  //!< One-way travel time in seconds
+    };
+
+    /*!
+     * \brief Traces a downgoing ray from startDepth until it reaches depth
+     *
+     * Each layer's sound speed changes linearly, so the ray is an arc of a circle there and is traced exactly
+     * (Snell's law between layers). Above and below the cast, the first and last sound speeds continue.
+     * \param beamAngleDeg Launch angle from vertical in degrees, in [0, 90)
+     * \returns Empty if the ray turns back up before reaching depth
+     */
+    SSPCPP_EXPORT std::optional<SRayPoint> TraceRayToDepth(const SCompiledProfile& profile, double startDepth,
+        double beamAngleDeg, double depth);
+
+    /*!
+     * \brief Traces a downgoing ray from startDepth for a one-way travel time (see TraceRayToDepth)
+     * \returns Empty if the ray turns back up before the time is used
+     */
+    SSPCPP_EXPORT std::optional<SRayPoint> TraceRayForTime(const SCompiledProfile& profile, double startDepth,
+        double beamAngleDeg, double oneWayTime);
+};
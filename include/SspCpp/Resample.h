@@ -0,0 +1,99 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Resample.h
+  * \brief  Resampling of casts onto a common depth grid
+  */
+
+#pragma once
+
+#include <vector>
+#include "Cast.h"
+#include "CastTable.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    enum class eResampleMode
+    {
+        BinAverage,  //!< Average of all samples within half a step of each grid depth
+        Interpolate  //!< Linear interpolation between the samples on either side of each grid depth
+    };
+
+    //! Uniformly spaced depths: start, start + step, ..., start + (count - 1) * step
+    struct SSPCPP_EXPORT SDepthGrid
+    {
+        double start = 0;  //!< First depth in meters
+        double step = 1;  //!< Spacing in meters
+        size_t count = 0;  //!< Number of depths
+
+        double Depth(size_t n) const { return start + n * step; }
+    };
+
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::vector
+
+    /*!
+     * \brief Casts resampled onto one depth grid, as dense depth x cast matrices (one per channel)
+     *
+     * Each matrix is stored cast by cast: the values of cast n are in [n * grid.count, (n + 1) * grid.count).
+     * Grid depths a cast does not cover are NaN. Channels that no input cast has any values for are left empty.
+     */
+    struct SSPCPP_EXPORT SResampledCasts
+    {
+        SDepthGrid grid;
+        size_t numCasts = 0;
+
+        std::vector<double> c;
+        std::vector<double> temp;
+        std::vector<double> salinity;
+        std::vector<double> pressure;
+        std::vector<double> density;
+        std::vector<double> sigmaT;
+        std::vector<double> n2;
+
+        //! Start of cast n's values in one of the channels
+        const double* Column(const std::vector<double>& channel, size_t n) const { return channel.data() + n * grid.count; }
+    };
+#pragma warning(pop)
+
+    /*!
+     * \brief Resamples casts to a fixed depth grid
+     *
+     * Entries must be sorted by increasing depth for Interpolate (see Reorder or Cleanup); BinAverage
+     * accepts any order. Samples without a finite depth are skipped. A grid without a finite start and a positive
+     * step, or with more than INT_MAX depths, gives an empty result. Casts are processed in parallel on numThreads threads (0 = one per core).
+     */
+    SSPCPP_EXPORT SResampledCasts ResampleCasts(const std::vector<SCast>& casts, const SDepthGrid& grid,
+        eResampleMode mode, unsigned int numThreads = 0);
+
+    //! Resamples every cast in a table to a fixed depth grid
+    SSPCPP_EXPORT SResampledCasts ResampleCasts(const SCastTable& table, const SDepthGrid& grid,
+        eResampleMode mode, unsigned int numThreads = 0);
+
+    //! Resamples a single cast to a fixed depth grid
+    SSPCPP_EXPORT SResampledCasts ResampleCast(const SCast& cast, const SDepthGrid& grid, eResampleMode mode);
+};
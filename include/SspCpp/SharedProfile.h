@@ -0,0 +1,120 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   SharedProfile.h
+  * \brief  Publishing the current cast to other processes through shared memory
+  *
+  * One process (for example the one reading casts from the probe) publishes the active cast into a named
+  * shared memory region, and any number of real-time consumers on the same machine read it without
+  * parsing files or talking over a socket. Updates use a sequence lock: the publisher never waits for
+  * readers, and a reader that overlaps an update simply copies the cast again.
+  */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::unique_ptr
+
+    //! Writes casts into a named shared memory region. Only one publisher should use a name at a time.
+    class SSPCPP_EXPORT ProfilePublisher
+    {
+    public:
+        ProfilePublisher();
+        ~ProfilePublisher();
+
+        /*!
+         * \brief Creates the region, sized for casts of up to maxEntries entries
+         *
+         * Other users can read the region but not write to it. A region left behind with the same name is
+         * reused only if it belongs to the current user.
+         * \returns false if the region cannot be created
+         */
+        bool Open(const std::string& name, size_t maxEntries = 65536);
+
+        //! Unmaps the region and removes its name. Subscribers that already have it open keep their mapping.
+        void Close();
+
+        /*!
+         * \brief Copies the cast into the region and bumps the version
+         * \returns false if the region is not open or the cast has more than maxEntries entries
+         */
+        bool Publish(const SCast& cast);
+
+        //! Number of casts published so far
+        uint64_t Version() const;
+
+    private:
+        struct SImpl;
+        std::unique_ptr<SImpl> impl;
+    };
+
+
+    //! Reads casts from a region created by a ProfilePublisher, possibly in another process
+    class SSPCPP_EXPORT ProfileSubscriber
+    {
+    public:
+        ProfileSubscriber();
+        ~ProfileSubscriber();
+
+        //! Opens an existing region read-only. Returns false if no publisher has created it.
+        bool Open(const std::string& name);
+        void Close();
+
+        //! Number of casts published so far (0 until the first Publish)
+        uint64_t Version() const;
+
+        /*!
+         * \brief Copies the latest published cast
+         * \param version If not null, receives the version of the cast that was copied
+         * \returns false if the region is not open or nothing has been published yet
+         */
+        bool Read(SCast& cast, uint64_t* version = nullptr) const;
+
+        /*!
+         * \brief Waits until the version is newer than lastVersion
+         * \returns false on timeout
+         *
+         * Spins briefly before backing off to short sleeps, so an update is normally seen within a few
+         * microseconds without keeping a core busy while nothing changes.
+         */
+        bool WaitForUpdate(uint64_t lastVersion, std::chrono::milliseconds timeout) const;
+
+    private:
+        struct SImpl;
+        std::unique_ptr<SImpl> impl;
+    };
+
+#pragma warning(pop)
+};
@@ -29,9 +29,14 @@
 
 #pragma once
 
+#include <functional>
+#include <ostream>
 #include <optional>
 #include <string>
+#include <vector>
 #include "Cast.h"
+#include "CastTable.h"
+#include "Equations.h"
 #include "ProcessChecks.h"
 #include "sspcpp_export.h"
 
@@ -59,7 +64,125 @@ namespace ssp
         Unknown       //!< Does nothing currently - will try to determine file format in the future
     };
 
-    SSPCPP_EXPORT std::optional<SCast> ReadCast(const std::string& fileName, eCastType type = eCastType::Unknown);
+    /*!
+     * \brief Reads a cast file
+     * \param equation Used by readers that compute sound speed from temperature and salinity (AOML, Oceanscience,
+     *        Sea&Sun and simple text files without a sound speed column). Only WongZhu reads go through the parse cache.
+     */
+    SSPCPP_EXPORT std::optional<SCast> ReadCast(const std::string& fileName, eCastType type = eCastType::Unknown,
+        eSoundSpeedEquation equation = eSoundSpeedEquation::WongZhu);
+
+    /*!
+     * \brief Reads a cast, taking memory only from the cast's memory resource
+     *
+     * The file contents, temporary columns, entries and strings all come from the resource the cast was
+     * created with. The global allocator is still used for the file stream's buffer, for finding the type
+     * from the extension when it is Unknown, and for the Sea-Bird .tsv header strings. Giving each worker
+     * thread its own std::pmr::monotonic_buffer_resource avoids allocator contention, and a whole batch is
+     * freed at once by releasing the resource.
+     * \returns false if the file could not be read
+     */
+    SSPCPP_EXPORT bool ReadCast(const std::string& fileName, pmr::SCast& cast, eCastType type = eCastType::Unknown,
+        eSoundSpeedEquation equation = eSoundSpeedEquation::WongZhu);
+
+    //! Quantities that can be read from a column of a simple text-based file
+    enum class eSimpleColumn
+    {
+        Depth,        //!< Meters
+        SoundSpeed,   //!< Meters/second
+        Temperature,  //!< Degrees Celsius
+        Salinity,     //!< Parts per thousand
+        Pressure,     //!< Bars
+        Ignore        //!< Column is skipped
+    };
+
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::vector
+
+    //! Layout of a simple text-based file (eCastType::Simple)
+    struct SSPCPP_EXPORT SSimpleFormat
+    {
+        //! Field separator. With 0, any run of spaces, tabs, commas, semicolons or '|' separates fields.
+        char delimiter = 0;
+        //! What each column holds, in order. Columns past the end of this list are ignored.
+        std::vector<eSimpleColumn> columns = { eSimpleColumn::Depth, eSimpleColumn::SoundSpeed };
+        //! Whether a blank line ends the data (older behavior) rather than being skipped
+        bool stopAtBlankLine = false;
+        //! Used when there is no sound speed column
+        eSoundSpeedEquation equation = eSoundSpeedEquation::WongZhu;
+    };
+#pragma warning(pop)
+
+    /*!
+     * \brief Reads a simple text-based cast with the given column layout
+     *
+     * Lines (or the rest of a line) starting with #, % or // are comments. If there is no sound speed column,
+     * it is computed from temperature, salinity (35 ppt if missing) and pressure. A missing depth is computed
+     * from pressure and vice versa, assuming a latitude of 0.
+     */
+    SSPCPP_EXPORT std::optional<SCast> ReadSimple(const std::string& fileName, const SSimpleFormat& format);
+
+    //! Determines the file type based on the filename extension (eCastType::Unknown if not recognized)
+    SSPCPP_EXPORT eCastType DetermineFileType(const std::string& fileName);
+
+    /*!
+     * \brief Reads every cast in a file that can hold multiple profiles (e.g., Hypack .vel from MVP runs)
+     *
+     * The file is split on each format's section header line, and every section is parsed as its own cast.
+     * Casts are handed to the callback one at a time in file order, so memory use is bounded by the number
+     * of sections buffered for parsing rather than by the file size. Sections that fail to parse are skipped.
+     * Formats that only hold one cast per file are read with ReadCast.
+     *
+     * \param[in] callback Receives each cast (which may be moved from). Return false to stop reading.
+     * \param[in] numThreads Number of threads used to parse sections (0 = one per core)
+     * \returns The number of casts handed to the callback
+     */
+    SSPCPP_EXPORT size_t ReadCastsFromFile(const std::string& fileName, eCastType type, const std::function<bool(SCast&)>& callback,
+        unsigned int numThreads = 1);
+
+    //! Reads every cast in a file into a vector. See the callback version for large files.
+    SSPCPP_EXPORT std::vector<SCast> ReadCastsFromFile(const std::string& fileName, eCastType type = eCastType::Unknown);
+
+    /*!
+     * \brief Bulk reader for University of New Brunswick (.unb) records, such as World Ocean Database exports
+     *
+     * path can be a directory (every .unb file in it is read, in filename order) or a single file holding one or
+     * more concatenated records. All casts are appended to the table. Files are parsed in parallel, and a
+     * malformed record stops the reading of its file (records before it are kept).
+     *
+     * \param[in] numThreads Number of threads used to parse files (0 = one per core)
+     * \returns The number of casts appended to the table
+     */
+    SSPCPP_EXPORT size_t ReadUnbCasts(const std::string& path, SCastTable& table, unsigned int numThreads = 0);
+
+    /*!
+     * \brief Formats the cast in the given file format and appends it to the buffer
+     *
+     * Supported types are Asvp, Hypack, SeaBirdTsv, Sonardyne and Unb. Numbers are written with the shortest
+     * representation that reads back exactly, so every field a format holds round-trips through the matching
+     * reader. Fields a format cannot hold are lost: Asvp and Hypack only keep depth and sound speed, Hypack
+     * times are truncated to the minute, and Sonardyne has no position.
+     * The buffer can be reused between calls to avoid reallocating.
+     */
+    SSPCPP_EXPORT bool WriteCast(const SCast& cast, eCastType type, std::string& buffer);
+
+    //! Writes the cast in the given file format to the stream (see the buffer version for supported types)
+    SSPCPP_EXPORT bool WriteCast(const SCast& cast, eCastType type, std::ostream& out);
+
+    /*!
+     * \brief Converts many cast files to one output format, in parallel
+     *
+     * Each input is read with ReadCastsFromFile (the type comes from its extension) and written to outputDir with
+     * the same name and the new extension. If an input has several casts, they are all written to the one file for
+     * formats that allow it (Asvp, Hypack). Otherwise the extra casts go to numbered files (name_001, etc.).
+     * Inputs that share a name keep the first one's output name, and the others get their input extension
+     * added (a.asvp and a.vel give a and a_vel), then a number if that is taken too.
+     *
+     * \param[in] numThreads Number of files converted at once (0 = one per core)
+     * \returns The number of input files converted
+     */
+    SSPCPP_EXPORT size_t ConvertCasts(const std::vector<std::string>& inputFiles, const std::string& outputDir, eCastType outputType,
+        unsigned int numThreads = 0);
 
     SSPCPP_EXPORT bool PlotCast(const ssp::SCast& cast);
 
@@ -74,6 +197,9 @@ namespace ssp
      */
     SSPCPP_EXPORT double WongZhu(double temp, double salin, double pressure);
 
+    //! Batch version of WongZhu for arrays of count samples. The output may be one of the input arrays.
+    SSPCPP_EXPORT void WongZhu(const double* temp, const double* salin, const double* pressure, double* c, size_t count);
+
     SSPCPP_EXPORT double Gravity(double latitudeDeg);
 
     /*! From Leroy and Parthiot, "Depth-pressure relationships in the oceans and seas"
@@ -81,11 +207,17 @@ namespace ssp
      */
     SSPCPP_EXPORT double Depth(double pressureBar, double latitudeDeg);
 
+    //! Batch version of Depth for arrays of count samples (all at the same latitude)
+    SSPCPP_EXPORT void Depth(const double* pressureBar, double* depth, size_t count, double latitudeDeg);
+
     /*! From Leroy and Parthiot, "Depth-pressure relationships in the oceans and seas"
      *   https://doi.org/10.1121/1.421275. Returns pressure in bars (instead of MegaPascals as in the paper).
      */
     SSPCPP_EXPORT double DepthToPressure(double depth, double latitudeDeg);
 
+    //! Batch version of DepthToPressure for arrays of count samples (all at the same latitude)
+    SSPCPP_EXPORT void DepthToPressure(const double* depth, double* pressure, size_t count, double latitudeDeg);
+
     SSPCPP_EXPORT double PascalToBar(double pascals);
 
     /*!
@@ -99,4 +231,8 @@ namespace ssp
      * \returns Conductivity in parts per thousand
      */
     SSPCPP_EXPORT double ConductivityToSalinity(double conductivitySm, double pressureDbar, double tempC);
+
+    //! Batch version of ConductivityToSalinity for arrays of count samples
+    SSPCPP_EXPORT void ConductivityToSalinity(const double* conductivitySm, const double* pressureDbar, const double* tempC,
+        double* salinity, size_t count);
 };
@@ -0,0 +1,160 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   SoundSpeedTable.h
+  * \brief  Precomputed temperature/salinity/pressure grid for fast approximate sound speed
+  *
+  * For loops that evaluate sound speed millions of times (Monte Carlo runs, inversions), a table of an
+  * equation's values with trilinear interpolation replaces the polynomials with eight loads and a few
+  * multiplies. VerifySoundSpeedTable reports how far the table can be from the equation it was built from.
+  */
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <vector>
+#include "Equations.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    //! Box of temperatures, salinities and pressures covered by a table (defaults are the Wong-Zhu valid ranges)
+    struct SSPCPP_EXPORT STableRange
+    {
+        double tempMin = 0;  //!< Celsius
+        double tempMax = 40;
+        double salinMin = 0;  //!< Parts per thousand
+        double salinMax = 40;
+        double pressureMin = 0;  //!< Bars
+        double pressureMax = 1000;
+    };
+
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::vector
+
+    /*!
+     * \brief Sound speed at evenly spaced nodes, with trilinear interpolation between them
+     *
+     * Create with BuildSoundSpeedTable. Values outside the range are clamped to its edges.
+     */
+    struct SSPCPP_EXPORT SSoundSpeedTable
+    {
+        STableRange range;
+        eSoundSpeedEquation equation = eSoundSpeedEquation::WongZhu;
+        double latitudeDeg = 45;  //!< Only used by Mackenzie
+        size_t numTemp = 0;  //!< Nodes along each axis
+        size_t numSalin = 0;
+        size_t numPressure = 0;
+        double scale[3] = {};  //!< Temperature, salinity and pressure to node position: value * scale + offset
+        double offset[3] = {};
+        double lastCell[3] = {};  //!< Largest node position that is still inside the last cell
+        std::vector<double> c;  //!< Index (t * numSalin + s) * numPressure + p
+
+        size_t Bytes() const { return c.size() * sizeof(double); }
+
+        /*!
+         * \brief Approximate sound speed in meters/second
+         *
+         * The table must have been built (c is not empty). A NaN input gives NaN.
+         */
+        double SoundSpeed(double temp, double salin, double pressure) const
+        {
+            const double pt = Position(temp, 0);
+            const double ps = Position(salin, 1);
+            const double pp = Position(pressure, 2);
+            const size_t t = static_cast<size_t>(pt), s = static_cast<size_t>(ps), p = static_cast<size_t>(pp);
+            const double ft = pt - t, fs = ps - s, fp = pp - p;
+
+            const double* c00 = c.data() + (t * numSalin + s) * numPressure + p;  // Corners at t, s
+            const double* c01 = c00 + numPressure;  // t, s + 1
+            const double* c10 = c00 + numSalin * numPressure;  // t + 1, s
+            const double* c11 = c10 + numPressure;  // t + 1, s + 1
+
+            const double a00 = c00[0] + fp * (c00[1] - c00[0]);
+            const double a01 = c01[0] + fp * (c01[1] - c01[0]);
+            const double a10 = c10[0] + fp * (c10[1] - c10[0]);
+            const double a11 = c11[0] + fp * (c11[1] - c11[0]);
+            const double b0 = a00 + fs * (a01 - a00);
+            const double b1 = a10 + fs * (a11 - a10);
+            const double result = b0 + ft * (b1 - b0);
+            return (std::isnan(temp) || std::isnan(salin) || std::isnan(pressure)) ? std::numeric_limits<double>::quiet_NaN() : result;
+        }
+
+        //! Node position along an axis, clamped to the table. NaN goes to 0 so it cannot index outside the table.
+        double Position(double value, size_t axis) const
+        {
+            const double pos = value * scale[axis] + offset[axis];
+            return (pos >= 0) ? std::min(pos, lastCell[axis]) : 0.0;
+        }
+    };
+#pragma warning(pop)
+
+    //! Largest difference found between a table and its equation, and where it was found
+    struct SSPCPP_EXPORT STableError
+    {
+        double maxError = 0;  //!< Meters/second
+        double temp = 0;
+        double salin = 0;
+        double pressure = 0;
+    };
+
+    /*!
+     * \brief Builds a table with the given number of nodes along each axis
+     * \param numThreads Threads used to fill the table (0 = one per core)
+     * \returns Nothing if an axis has fewer than 2 nodes or an empty range
+     */
+    SSPCPP_EXPORT std::optional<SSoundSpeedTable> BuildSoundSpeedTable(const STableRange& range, size_t numTemp, size_t numSalin,
+        size_t numPressure, eSoundSpeedEquation equation = eSoundSpeedEquation::WongZhu, double latitudeDeg = 45,
+        unsigned int numThreads = 0);
+
+    /*!
+     * \brief Builds the most accurate table that fits in maxBytes
+     *
+     * Nodes are shared between the axes so that each contributes about the same interpolation error (more
+     * nodes along temperature, where sound speed curves most; few along salinity, where it is nearly linear).
+     * \returns Nothing if the range is empty or maxBytes cannot hold 2 nodes along each axis
+     */
+    SSPCPP_EXPORT std::optional<SSoundSpeedTable> BuildSoundSpeedTable(const STableRange& range, size_t maxBytes,
+        eSoundSpeedEquation equation = eSoundSpeedEquation::WongZhu, double latitudeDeg = 45, unsigned int numThreads = 0);
+
+    //! Batch version of SSoundSpeedTable::SoundSpeed. The output may be one of the input arrays. An empty table gives NaN.
+    SSPCPP_EXPORT void SoundSpeed(const SSoundSpeedTable& table, const double* temp, const double* salin,
+        const double* pressure, double* c, size_t count);
+
+    /*!
+     * \brief Maximum error of a table against an equation over its whole range
+     *
+     * Checks samplesPerCell evenly spaced points along each axis of every cell (2 = the nodes and the cell
+     * centers, where trilinear interpolation error peaks), so the worst case is found closely.
+     * \param equation Reference equation, normally the one the table was built from (WongZhu for the default table)
+     */
+    SSPCPP_EXPORT STableError VerifySoundSpeedTable(const SSoundSpeedTable& table,
+        eSoundSpeedEquation equation = eSoundSpeedEquation::WongZhu, size_t samplesPerCell = 2, unsigned int numThreads = 0);
+};
@@ -0,0 +1,140 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   SurfaceMonitor.h
+  * \brief  Streaming comparison of a surface sound speed probe with the profile in use
+  *
+  * Hull-mounted probes report sound speed at the transducer many times a second. The monitor keeps rolling
+  * statistics of the difference between those readings and the profile's value at the transducer depth,
+  * and raises an event when the mean difference stays beyond a threshold for long enough. Samples go into
+  * a ring buffer allocated up front, so adding one is O(1) and never allocates.
+  */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include "ActiveProfile.h"
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    struct SSPCPP_EXPORT SSurfaceMonitorOptions
+    {
+        double transducerDepth = 0;  //!< Depth (m) where the probe measures, and where the profile is sampled
+        double window = 10;  //!< Length (s) of the rolling window
+        double threshold = 1.0;  //!< Mean difference (m/s) beyond which the profile no longer agrees
+        double persistence = 5;  //!< How long (s) the mean must stay beyond the threshold before the event
+        size_t maxSamples = 1024;  //!< Ring buffer size; the window is also cut short when it holds this many
+    };
+
+    enum class eSurfaceEvent
+    {
+        Diverged,  //!< The mean difference has been beyond the threshold for the persistence time
+        Recovered  //!< The mean difference is back within the threshold after a Diverged event
+    };
+
+    struct SSPCPP_EXPORT SSurfaceEvent
+    {
+        eSurfaceEvent type = eSurfaceEvent::Diverged;
+        double time = 0;  //!< Time of the sample that raised the event
+        double since = 0;  //!< When the mean difference first went beyond the threshold
+        double meanDifference = 0;  //!< Measured minus profile (m/s) over the window
+    };
+
+    //! Rolling state of the monitor. Differences are measured minus profile sound speed.
+    struct SSPCPP_EXPORT SSurfaceStats
+    {
+        double profileSpeed = 0;  //!< Profile sound speed at the transducer depth (0 without a profile)
+        double lastTime = 0;  //!< Time of the latest sample
+        double lastMeasured = 0;  //!< Latest measured sound speed
+        double meanDifference = 0;  //!< Over the samples in the window
+        double stdDifference = 0;  //!< Standard deviation of the difference over the window
+        size_t count = 0;  //!< Samples in the window
+        size_t rejected = 0;  //!< Samples ignored (not finite, not positive, or older than the latest one)
+        bool diverged = false;  //!< Between a Diverged event and the next Recovered event
+    };
+
+    //! Receives threshold events, on the thread that called Add
+    using SurfaceCallback = std::function<void(const SSurfaceEvent& event)>;
+
+#pragma warning(push)
+#pragma warning(disable : 4251)  // Warning about using std::unique_ptr
+
+    /*!
+     * \brief Online check of probe readings against the profile's surface sound speed
+     *
+     * \code
+     *     ssp::SurfaceMonitor monitor(options, [](const ssp::SSurfaceEvent& e) { ... });
+     *     monitor.SetProfile(cast);
+     *     monitor.Add(time, cSurface);  // For every probe reading
+     * \endcode
+     *
+     * Not thread safe; feed it from one thread.
+     */
+    class SSPCPP_EXPORT SurfaceMonitor
+    {
+    public:
+        explicit SurfaceMonitor(const SSurfaceMonitorOptions& options = {}, SurfaceCallback callback = nullptr);
+        ~SurfaceMonitor();
+        SurfaceMonitor(const SurfaceMonitor&) = delete;
+        SurfaceMonitor& operator=(const SurfaceMonitor&) = delete;
+
+        /*!
+         * \brief Uses the cast's sound speed at the transducer depth, interpolated between the entries around it
+         *
+         * Entries must be sorted by depth; above the first entry its sound speed is used. Statistics are recomputed
+         * for the samples already in the window, and any divergence starts over.
+         * \returns false (keeping the current profile) if the cast has no entry with a positive sound speed
+         */
+        bool SetProfile(const SCast& cast);
+
+        //! Uses a compiled profile's sound speed at the transducer depth (see the cast version)
+        void SetProfile(const SCompiledProfile& profile);
+
+        //! Uses a sound speed directly as the profile value (see the cast version)
+        void SetProfileSpeed(double c);
+
+        /*!
+         * \brief Adds a probe reading, dropping samples that have left the window, and raises any event
+         * \param time Seconds on any clock, increasing
+         * \param c Measured sound speed in m/s
+         */
+        void Add(double time, double c);
+
+        SSurfaceStats Stats() const;
+
+        //! Drops all samples and any divergence (the profile is kept)
+        void Reset();
+
+    private:
+        struct SImpl;
+        std::unique_ptr<SImpl> impl;
+    };
+#pragma warning(pop)
+};
@@ -0,0 +1,76 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Thinning.h
+  * \brief  Reduction of the number of points in a cast
+  *
+  * Acquisition systems often limit how many points a sound speed profile can have. These routines remove
+  * points while keeping the profile close to the original, and report the largest resulting change in the
+  * vertical one-way travel time. All of them expect the cast to be sorted by depth (see Reorder or Cleanup),
+  * drop entries with a non-finite depth, and always keep the first and last of the remaining entries.
+  */
+
+#pragma once
+
+#include "Cast.h"
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    /*!
+     * \brief Douglas-Peucker thinning on (depth, sound speed)
+     *
+     * Keeps just enough entries that linear interpolation between them is never more than tolerance (m/s)
+     * away from any removed entry's sound speed. Takes O(n log n) time for typical casts, but O(n^2) in the
+     * worst case (when each kept entry is next to one end of the segment it splits).
+     * \returns The maximum one-way travel time error (seconds) compared to the original cast
+     */
+    SSPCPP_EXPORT double ThinDouglasPeucker(SCast& cast, double tolerance);
+
+    /*!
+     * \brief Thins to at most maxPoints entries, greedily keeping the points that reduce the error the most
+     *
+     * Starts with the end points and repeatedly adds the entry that is farthest (in sound speed) from the
+     * current thinned profile, so the result for each count is the same as Douglas-Peucker would pick.
+     * Takes O(n * maxPoints) time in the worst case.
+     * \returns The maximum one-way travel time error (seconds) compared to the original cast
+     */
+    SSPCPP_EXPORT double ThinToCount(SCast& cast, size_t maxPoints);
+
+    /*!
+     * \brief Keeps one entry per depth bin of binSize meters (the one closest to the bin center)
+     * \returns The maximum one-way travel time error (seconds) compared to the original cast
+     */
+    SSPCPP_EXPORT double ThinDepthBins(SCast& cast, double binSize);
+
+    /*!
+     * \brief Maximum difference in vertical one-way travel time from the top of the casts to any depth in full
+     *
+     * Sound speed is taken as linear between entries. Both casts must be sorted by depth. Entries of full
+     * with a non-finite depth are skipped.
+     */
+    SSPCPP_EXPORT double MaxTravelTimeError(const SCast& full, const SCast& thinned);
+};
@@ -0,0 +1,81 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Xbt.h
+  * \brief  Expendable bathythermograph (XBT) fall-rate equations
+  *
+  * XBTs do not measure depth. It is found from the time since the probe hit the water with a fall-rate
+  * equation of the form z = a*t - b*t^2, where the coefficients depend on the probe type.
+  */
+
+#pragma once
+
+#include <string>
+#include "sspcpp_export.h"
+
+
+namespace ssp
+{
+    //! XBT probe types with known fall-rate coefficients
+    enum class eXbtProbe
+    {
+        T4,        //!< Sippican T-4 (Hanawa et al. 1995)
+        T5,        //!< Sippican T-5
+        T6,        //!< Sippican T-6 (Hanawa et al. 1995)
+        T7,        //!< Sippican T-7 (Hanawa et al. 1995)
+        DeepBlue,  //!< Sippican Deep Blue (Hanawa et al. 1995)
+        FastDeep,  //!< Sippican Fast Deep
+        T10,       //!< Sippican T-10
+        T11,       //!< Sippican T-11 (fine structure)
+        Axbt,      //!< Air-launched XBT (constant descent rate)
+        Unknown    //!< Uses the T-7 / Deep Blue coefficients
+    };
+
+    //! Coefficients for z = a*t - b*t^2 (z in meters, t in seconds)
+    struct SFallRate
+    {
+        double a;
+        double b;
+    };
+
+    //! Fall-rate coefficients for the probe type
+    SSPCPP_EXPORT SFallRate FallRateCoefficients(eXbtProbe probe);
+
+    /*!
+     * \brief Determines the probe type from its name as written in file headers
+     *
+     * Case, spaces and dashes are ignored, so "T-7", "t7" and "DEEP BLUE" are all recognized.
+     */
+    SSPCPP_EXPORT eXbtProbe XbtProbeFromName(const std::string& name);
+
+    //! Depth (meters) of the probe after the elapsed time (seconds) since it hit the water
+    SSPCPP_EXPORT double XbtDepth(double elapsedSec, eXbtProbe probe);
+
+    //! Converts a batch of elapsed times (seconds) to depths (meters). The arrays may be the same.
+    SSPCPP_EXPORT void XbtDepth(const double* elapsedSec, double* depth, size_t count, eXbtProbe probe);
+
+    //! Same as XbtDepth, but with user-supplied coefficients (e.g., from a probe-specific calibration)
+    SSPCPP_EXPORT void XbtDepth(const double* elapsedSec, double* depth, size_t count, const SFallRate& fallRate);
+};
@@ -0,0 +1,184 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Absorption.cpp
+  * \brief  Frequency dependent absorption of sound in seawater
+  *
+  * Both models have the same shape: two relaxation terms a f1 f^2 / (f1^2 + f^2) (boric acid and magnesium
+  * sulphate) plus a pure water term a f^2. SRelaxation holds the coefficients for one sample, so evaluating
+  * many frequencies only repeats that last step. The batch version keeps them in SRelaxationColumns, so the
+  * per-frequency loop reads each coefficient at unit stride and vectorizes.
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/Absorption.h"
+#include <cmath>
+#include <vector>
+
+
+namespace ssp
+{
+namespace absorption
+{
+    //! Frequency independent part of the absorption for one sample (frequencies in kHz, results in dB/km)
+    struct SRelaxation
+    {
+        double a1, f1;  //!< Boric acid
+        double a2, f2;  //!< Magnesium sulphate
+        double a3;  //!< Pure water
+    };
+
+    //! SRelaxation for many samples, one column per coefficient
+    struct SRelaxationColumns
+    {
+        explicit SRelaxationColumns(size_t count) : a1(count), f1(count), a2(count), f2(count), a3(count) {}
+
+        std::vector<double> a1, f1;
+        std::vector<double> a2, f2;
+        std::vector<double> a3;
+    };
+
+    static SRelaxation FrancoisGarrison(double T, double S, double D, double pH)
+    {
+        SRelaxation r;
+        const double c = 1412.0 + 3.21 * T + 1.19 * S + 0.0167 * D;
+        const double theta = 273.0 + T;
+
+        r.a1 = 8.86 / c * std::pow(10.0, 0.78 * pH - 5.0);
+        r.f1 = 2.8 * std::sqrt(S / 35.0) * std::pow(10.0, 4.0 - 1245.0 / theta);
+
+        const double P2 = 1.0 - 1.37e-4 * D + 6.2e-9 * D * D;
+        r.a2 = 21.44 * S / c * (1.0 + 0.025 * T) * P2;
+        r.f2 = 8.17 * std::pow(10.0, 8.0 - 1990.0 / theta) / (1.0 + 0.0018 * (S - 35.0));
+
+        const double P3 = 1.0 - 3.83e-5 * D + 4.9e-10 * D * D;
+        const double A3 = T <= 20.0
+            ? 4.937e-4 + T * (-2.59e-5 + T * (9.11e-7 - T * 1.50e-8))
+            : 3.964e-4 + T * (-1.146e-5 + T * (1.45e-7 - T * 6.5e-10));
+        r.a3 = A3 * P3;
+        return r;
+    }
+
+    static SRelaxation AinslieMcColm(double T, double S, double D, double pH)
+    {
+        SRelaxation r;
+        const double z = D / 1000.0;  // km
+
+        r.f1 = 0.78 * std::sqrt(S / 35.0) * std::exp(T / 26.0);
+        r.a1 = 0.106 * std::exp((pH - 8.0) / 0.56);
+        r.f2 = 42.0 * std::exp(T / 17.0);
+        r.a2 = 0.52 * (1.0 + T / 43.0) * (S / 35.0) * std::exp(-z / 6.0);
+        r.a3 = 0.00049 * std::exp(-(T / 27.0 + z / 17.0));
+        return r;
+    }
+
+    static SRelaxation Relaxation(eAbsorptionModel model, double T, double S, double D, double pH)
+    {
+        return model == eAbsorptionModel::AinslieMcColm ? AinslieMcColm(T, S, D, pH) : FrancoisGarrison(T, S, D, pH);
+    }
+
+    //! Absorption from the coefficients of one sample and the squared frequency
+    inline double Evaluate(double a1, double f1, double a2, double f2, double a3, double fSq)
+    {
+        return a1 * f1 * fSq / (f1 * f1 + fSq) + a2 * f2 * fSq / (f2 * f2 + fSq) + a3 * fSq;
+    }
+
+    inline double Evaluate(const SRelaxation& r, double f)
+    {
+        return Evaluate(r.a1, r.f1, r.a2, r.f2, r.a3, f * f);
+    }
+
+    //! Salinity to use for a cast entry, since 0 means the file had none
+    inline double EntrySalinity(const SCastEntry& entry)
+    {
+        return entry.salinity > 0 ? entry.salinity : 35.0;
+    }
+};  // End namespace absorption
+
+
+using namespace absorption;
+
+double Absorption(double frequencyKHz, double temp, double salin, double depth, double pH, eAbsorptionModel model)
+{
+    return Evaluate(Relaxation(model, temp, salin, depth, pH), frequencyKHz);
+}
+
+
+void Absorption(const double* temp, const double* salin, const double* depth, size_t count,
+    const double* frequenciesKHz, size_t numFrequencies, double* absorption, double pH, eAbsorptionModel model)
+{
+    SRelaxationColumns r(count);
+    for (size_t n = 0; n < count; ++n)
+    {
+        const SRelaxation sample = Relaxation(model, temp[n], salin[n], depth[n], pH);
+        r.a1[n] = sample.a1;
+        r.f1[n] = sample.f1;
+        r.a2[n] = sample.a2;
+        r.f2[n] = sample.f2;
+        r.a3[n] = sample.a3;
+    }
+
+    const double* a1 = r.a1.data();
+    const double* f1 = r.f1.data();
+    const double* a2 = r.a2.data();
+    const double* f2 = r.f2.data();
+    const double* a3 = r.a3.data();
+    for (size_t k = 0; k < numFrequencies; ++k)
+    {
+        const double fSq = frequenciesKHz[k] * frequenciesKHz[k];
+        double* column = absorption + k * count;
+        for (size_t n = 0; n < count; ++n)
+            column[n] = Evaluate(a1[n], f1[n], a2[n], f2[n], a3[n], fSq);
+    }
+    return;
+}
+
+
+std::vector<double> CastAbsorption(const SCast& cast, const std::vector<double>& frequenciesKHz, double pH, eAbsorptionModel model)
+{
+    const size_t count = cast.entries.size();
+    std::vector<double> temp(count), salin(count), depth(count);
+    for (size_t n = 0; n < count; ++n)
+    {
+        temp[n] = cast.entries[n].temp;
+        salin[n] = EntrySalinity(cast.entries[n]);
+        depth[n] = cast.entries[n].depth;
+    }
+
+    std::vector<double> absorption(count * frequenciesKHz.size());
+    Absorption(temp.data(), salin.data(), depth.data(), count, frequenciesKHz.data(), frequenciesKHz.size(),
+        absorption.data(), pH, model);
+    return absorption;
+}
+
+
+void FillAbsorption(SCast& cast, double frequencyKHz, double pH, eAbsorptionModel model)
+{
+    for (auto& entry : cast.entries)
+        entry.absorp = Absorption(frequencyKHz, entry.temp, EntrySalinity(entry), entry.depth, pH, model);
+    return;
+}
+
+};  // End namespace ssp
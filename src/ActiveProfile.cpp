@@ -0,0 +1,357 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   ActiveProfile.cpp
+  * \brief  Precompiled profiles and lock-free switching of the profile in use
+  *
+  * Epoch based reclamation: each thread with a Reader open owns a slot in every ActiveProfile. Opening a Reader stores
+  * the current global epoch in the slot, then loads the profile pointer; closing it sets the slot back to 0.
+  * Publishing swaps the pointer, then advances the epoch, tagging the old profile with the epoch it was
+  * replaced in. A replaced profile is freed once every busy slot holds a later epoch. All of these steps are
+  * sequentially consistent, so either the publisher sees a reader's slot, or that reader sees the new pointer.
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/ActiveProfile.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <thread>
+#include "TravelTime.h"
+
+
+namespace ssp
+{
+namespace active
+{
+    constexpr size_t maxTableSize = 1 << 22;
+
+    struct alignas(64) SReaderSlot
+    {
+        std::atomic<uint64_t> epoch{ 0 };  //!< 0 when the owning thread holds no Reader
+        uint32_t depth = 0;  //!< Nesting level of Readers, only touched by the owning thread
+    };
+
+    /*!
+     * \brief Gives each thread holding Readers an index below maxReaderThreads, taken back when its last Reader closes
+     *
+     * Claiming is a compare-exchange on a flag, starting with the index the thread had last time, so a thread
+     * opening and closing Readers over and over usually gets its old index back on the first try.
+     */
+    class ThreadIndices
+    {
+    public:
+        size_t Claim(size_t hint)
+        {
+            for (;;)
+            {
+                for (size_t k = 0; k < ActiveProfile::maxReaderThreads; ++k)
+                {
+                    const size_t index = (hint + k) % ActiveProfile::maxReaderThreads;
+                    bool expected = false;
+                    if (!used[index].load(std::memory_order_relaxed) &&
+                        used[index].compare_exchange_strong(expected, true, std::memory_order_acquire))
+                        return index;
+                }
+                std::this_thread::yield();  // Every index is held by a thread with an open Reader
+            }
+        }
+
+        void Release(size_t index)
+        {
+            used[index].store(false, std::memory_order_release);
+            return;
+        }
+
+    private:
+        std::atomic<bool> used[ActiveProfile::maxReaderThreads] = {};
+    };
+
+    static ThreadIndices& Indices()
+    {
+        static ThreadIndices indices;
+        return indices;
+    }
+
+    //! The calling thread's index while it has Readers open (on any ActiveProfile)
+    struct SThreadReaders
+    {
+        size_t index = 0;
+        uint32_t open = 0;
+    };
+    thread_local SThreadReaders threadReaders;
+
+    static size_t OpenReader()
+    {
+        if (threadReaders.open++ == 0)
+            threadReaders.index = Indices().Claim(threadReaders.index);
+        return threadReaders.index;
+    }
+
+    static void CloseReader()
+    {
+        if (--threadReaders.open == 0)
+            Indices().Release(threadReaders.index);
+        return;
+    }
+
+    struct SRetired
+    {
+        uint64_t epoch;  //!< Global epoch at the time the profile was replaced
+        std::shared_ptr<const SCompiledProfile> profile;
+    };
+};  // End namespace active
+
+
+using namespace active;
+
+size_t SCompiledProfile::Layer(double depth) const
+{
+    const double top = layers.front().top;
+    if (!(depth > top))  // Also catches NaN
+        return 0;
+
+    const double k = (depth - top) / tableStep;
+    if (k >= table.size())
+        return layers.size() - 1;
+
+    // The layer is between the ones holding this table depth and the next
+    const size_t cell = static_cast<size_t>(k);
+    const size_t first = table[cell];
+    const size_t last = (cell + 1 < table.size()) ? table[cell + 1] : layers.size() - 1;
+    if (first == last || layers[first].bottom > depth)
+        return first;
+    auto above = std::upper_bound(layers.begin() + first, layers.begin() + last, depth,
+        [](double d, const SLayer& layer) { return d < layer.bottom; });
+    return above - layers.begin();
+}
+
+
+double SCompiledProfile::SoundSpeed(double depth) const
+{
+    const SLayer& layer = layers[Layer(depth)];
+    const double z = std::clamp(depth, layer.top, layer.bottom);
+    return layer.c0 + layer.gradient * (z - layer.top);
+}
+
+
+double SCompiledProfile::TravelTime(double depth) const
+{
+    const size_t n = Layer(depth);
+    const SLayer& layer = layers[n];
+    if (depth <= layer.top)
+        return travelTime[n] - (layer.top - depth) / layer.c0;
+    if (depth >= layer.bottom)
+        return travelTime[n + 1] + (depth - layer.bottom) / (layer.c0 + layer.gradient * (layer.bottom - layer.top));
+
+    const double dz = depth - layer.top;
+    return travelTime[n] + travel::LayerTime(dz, layer.c0, layer.c0 + layer.gradient * dz);
+}
+
+
+double SCompiledProfile::HarmonicMean(double fromDepth, double toDepth) const
+{
+    const double time = TravelTime(fromDepth, toDepth);
+    return (time > 0) ? std::abs(toDepth - fromDepth) / time : SoundSpeed(fromDepth);
+}
+
+
+void SCompiledProfile::TravelTime(const double* fromDepth, const double* toDepth, double* time, size_t count) const
+{
+    for (size_t n = 0; n < count; ++n)
+        time[n] = TravelTime(fromDepth[n], toDepth[n]);
+    return;
+}
+
+
+void SCompiledProfile::HarmonicMean(const double* fromDepth, const double* toDepth, double* c, size_t count) const
+{
+    for (size_t n = 0; n < count; ++n)
+        c[n] = HarmonicMean(fromDepth[n], toDepth[n]);
+    return;
+}
+
+
+std::shared_ptr<const SCompiledProfile> CompileProfile(const SCast& cast, double tableStep)
+{
+    std::vector<std::pair<double, double>> points;  // Depth and sound speed
+    points.reserve(cast.entries.size());
+    for (const auto& entry : cast.entries)
+    {
+        if (std::isfinite(entry.depth) && std::isfinite(entry.c) && entry.c > 0)
+            points.emplace_back(entry.depth, entry.c);
+    }
+    std::stable_sort(points.begin(), points.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    points.erase(std::unique(points.begin(), points.end(), [](const auto& a, const auto& b) { return a.first == b.first; }), points.end());
+    if (points.size() < 2)
+        return nullptr;
+
+    auto profile = std::make_shared<SCompiledProfile>();
+    profile->fileName = cast.fileName;
+    profile->time = cast.time;
+    profile->lat = cast.lat;
+    profile->lon = cast.lon;
+
+    profile->layers.resize(points.size() - 1);
+    for (size_t n = 0; n + 1 < points.size(); ++n)
+    {
+        SLayer& layer = profile->layers[n];
+        layer.top = points[n].first;
+        layer.bottom = points[n + 1].first;
+        layer.c0 = points[n].second;
+        layer.gradient = (points[n + 1].second - points[n].second) / (layer.bottom - layer.top);
+    }
+
+    // Prefix sums of the time through each layer, so travel time between any two depths is a difference
+    profile->travelTime.resize(points.size());
+    profile->travelTime[0] = 0.0;
+    for (size_t n = 0; n + 1 < points.size(); ++n)
+    {
+        profile->travelTime[n + 1] = profile->travelTime[n] +
+            travel::LayerTime(points[n + 1].first - points[n].first, points[n].second, points[n + 1].second);
+    }
+
+    // Lookup table from evenly spaced depths to layers, so finding a layer is a table read plus a short scan
+    const double range = profile->MaxDepth() - profile->MinDepth();
+    if (!(tableStep > 0))
+        tableStep = 1;
+    tableStep = std::max(tableStep, range / (maxTableSize - 1));
+    profile->tableStep = tableStep;
+    profile->table.resize(static_cast<size_t>(range / tableStep) + 1);
+    uint32_t layer = 0;
+    for (size_t k = 0; k < profile->table.size(); ++k)
+    {
+        const double depth = profile->MinDepth() + k * tableStep;
+        while (layer + 1 < profile->layers.size() && profile->layers[layer].bottom <= depth)
+            ++layer;
+        profile->table[k] = layer;
+    }
+
+    return profile;
+}
+
+
+struct ActiveProfile::SImpl
+{
+    SReaderSlot slots[maxReaderThreads];
+    std::atomic<const SCompiledProfile*> current{ nullptr };
+    std::atomic<uint64_t> epoch{ 1 };
+    std::atomic<uint64_t> version{ 0 };
+
+    // Only touched by publishers, under the mutex
+    mutable std::mutex mutex;
+    std::shared_ptr<const SCompiledProfile> owner;  //!< Keeps current alive
+    std::vector<SRetired> retired;
+
+    //! Frees replaced profiles that no open Reader can be using
+    void Reclaim()
+    {
+        uint64_t oldestReader = UINT64_MAX;
+        for (const auto& slot : slots)
+        {
+            const uint64_t epoch = slot.epoch.load();
+            if (epoch != 0)
+                oldestReader = std::min(oldestReader, epoch);
+        }
+
+        retired.erase(std::remove_if(retired.begin(), retired.end(),
+            [oldestReader](const SRetired& r) { return r.epoch < oldestReader; }), retired.end());
+        return;
+    }
+};
+
+
+ActiveProfile::ActiveProfile() : impl(std::make_unique<SImpl>()) {}
+ActiveProfile::~ActiveProfile() = default;
+
+
+ActiveProfile::Reader::Reader(const ActiveProfile& active)
+{
+    SReaderSlot& readerSlot = active.impl->slots[OpenReader()];
+    if (readerSlot.depth++ == 0)
+        readerSlot.epoch.store(active.impl->epoch.load());
+    slot = &readerSlot;
+    profile = active.impl->current.load();
+}
+
+
+ActiveProfile::Reader::~Reader()
+{
+    SReaderSlot& readerSlot = *static_cast<SReaderSlot*>(slot);
+    if (--readerSlot.depth == 0)
+        readerSlot.epoch.store(0, std::memory_order_release);
+    CloseReader();
+}
+
+
+void ActiveProfile::Publish(std::shared_ptr<const SCompiledProfile> profile)
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+
+    std::shared_ptr<const SCompiledProfile> old = std::move(impl->owner);
+    impl->owner = std::move(profile);
+    impl->current.exchange(impl->owner.get());
+    const uint64_t replacedIn = impl->epoch.fetch_add(1);
+    if (old)
+        impl->retired.push_back({ replacedIn, std::move(old) });
+    ++impl->version;
+
+    impl->Reclaim();
+    return;
+}
+
+
+bool ActiveProfile::Publish(const SCast& cast, double tableStep)
+{
+    auto profile = CompileProfile(cast, tableStep);
+    if (!profile)
+        return false;
+    Publish(std::move(profile));
+    return true;
+}
+
+
+std::shared_ptr<const SCompiledProfile> ActiveProfile::Snapshot() const
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    return impl->owner;
+}
+
+
+uint64_t ActiveProfile::Version() const
+{
+    return impl->version.load(std::memory_order_relaxed);
+}
+
+
+size_t ActiveProfile::PendingReclaim() const
+{
+    std::lock_guard<std::mutex> lock(impl->mutex);
+    impl->Reclaim();
+    return impl->retired.size();
+}
+
+};  // End namespace ssp
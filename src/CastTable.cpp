@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   CastTable.cpp
+  * \brief  Column-oriented storage for large numbers of casts
+  */
+
+#include "pch.h"
+#include <SspCpp/CastTable.h>
+
+
+namespace ssp
+{
+
+void AppendCast(SCastTable& table, const SCast& cast)
+{
+    table.fileNames.push_back(cast.fileName);
+    table.times.push_back(cast.time);
+    table.lats.push_back(cast.lat);
+    table.lons.push_back(cast.lon);
+
+    for (const auto& entry : cast.entries)
+    {
+        table.depth.push_back(entry.depth);
+        table.c.push_back(entry.c);
+        table.temp.push_back(entry.temp);
+        table.salinity.push_back(entry.salinity);
+        table.pressure.push_back(entry.pressure);
+        table.density.push_back(entry.density);
+        table.sigmaT.push_back(entry.sigmaT);
+        table.n2.push_back(entry.n2);
+        table.flags.push_back(entry.flags);
+    }
+    table.offsets.push_back(table.depth.size());
+
+    return;
+}
+
+
+void AppendTable(SCastTable& table, const SCastTable& other)
+{
+    const size_t base = table.NumSamples();
+    for (size_t n = 1; n < other.offsets.size(); ++n)
+        table.offsets.push_back(base + other.offsets[n]);
+
+    table.fileNames.insert(end(table.fileNames), begin(other.fileNames), end(other.fileNames));
+    table.times.insert(end(table.times), begin(other.times), end(other.times));
+    table.lats.insert(end(table.lats), begin(other.lats), end(other.lats));
+    table.lons.insert(end(table.lons), begin(other.lons), end(other.lons));
+
+    table.depth.insert(end(table.depth), begin(other.depth), end(other.depth));
+    table.c.insert(end(table.c), begin(other.c), end(other.c));
+    table.temp.insert(end(table.temp), begin(other.temp), end(other.temp));
+    table.salinity.insert(end(table.salinity), begin(other.salinity), end(other.salinity));
+    table.pressure.insert(end(table.pressure), begin(other.pressure), end(other.pressure));
+    table.density.insert(end(table.density), begin(other.density), end(other.density));
+    table.sigmaT.insert(end(table.sigmaT), begin(other.sigmaT), end(other.sigmaT));
+    table.n2.insert(end(table.n2), begin(other.n2), end(other.n2));
+    table.flags.insert(end(table.flags), begin(other.flags), end(other.flags));
+
+    return;
+}
+
+
+SCast GetCast(const SCastTable& table, size_t n)
+{
+    SCast cast;
+    cast.fileName = table.fileNames[n];
+    cast.time = table.times[n];
+    cast.lat = table.lats[n];
+    cast.lon = table.lons[n];
+
+    const size_t first = table.offsets[n], last = table.offsets[n + 1];
+    cast.entries.resize(last - first);
+    for (size_t m = first; m < last; ++m)
+    {
+        SCastEntry& entry = cast.entries[m - first];
+        entry.depth = table.depth[m];
+        entry.c = table.c[m];
+        entry.temp = table.temp[m];
+        entry.salinity = table.salinity[m];
+        entry.pressure = table.pressure[m];
+        entry.density = table.density[m];
+        entry.sigmaT = table.sigmaT[m];
+        entry.n2 = table.n2[m];
+        entry.flags = table.flags[m];
+    }
+
+    return cast;
+}
+
+};  // End namespace ssp
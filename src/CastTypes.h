@@ -0,0 +1,60 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   CastTypes.h
+  * \brief  Helpers for readers that fill either an SCast or a pmr::SCast
+  *
+  * Readers are written as templates on the cast type. Temporary buffers are created with the same
+  * allocator as the cast's entries, so that reading into a pmr::SCast only uses its memory resource.
+  */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <SspCpp/Cast.h>
+
+namespace ssp
+{
+    //! Allocator of the cast's entries, rebound to T
+    template <class Cast, class T>
+    using CastAllocator = typename std::allocator_traits<typename decltype(Cast::entries)::allocator_type>::template rebind_alloc<T>;
+
+    //! Vector sharing the cast's allocator. Construct with cast.entries.get_allocator().
+    template <class Cast, class T>
+    using CastVector = std::vector<T, CastAllocator<Cast, T>>;
+
+    //! String sharing the cast's allocator. Construct with cast.entries.get_allocator().
+    template <class Cast>
+    using CastString = std::basic_string<char, std::char_traits<char>, CastAllocator<Cast, char>>;
+
+    //! Copies a string into one of the cast's strings, whatever their allocators
+    template <class String>
+    void AssignString(String& dest, const std::string& src)
+    {
+        dest.assign(src.data(), src.size());
+    }
+};
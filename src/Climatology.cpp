@@ -0,0 +1,344 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Climatology.cpp
+  * \brief  Gridded temperature/salinity climatology and extension of casts to full depth
+  */
+
+#include "pch.h"
+#include <SspCpp/Climatology.h>
+#include <SspCpp/SoundSpeed.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "MappedFile.h"
+
+
+namespace ssp::climatology
+{
+    constexpr char Magic[8] = { 'S', 'S', 'P', 'C', 'L', 'I', 'M', '1' };
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    struct SFileHeader
+    {
+        char magic[8];
+        uint32_t numLat;
+        uint32_t numLon;
+        uint32_t numDepth;
+        uint32_t reserved;
+        double lat0;
+        double latStep;
+        double lon0;
+        double lonStep;
+    };
+    static_assert(sizeof(SFileHeader) == 56, "Climatology header must match the file layout");
+
+
+    //! A mapped climatology file, with pointers to its parts
+    struct SGrid
+    {
+        MappedFile file;
+        SFileHeader header;
+        const double* depths = nullptr;
+        const float* temp = nullptr;
+        const float* salinity = nullptr;
+        bool wrapLon = false;  //!< Grid covers all longitudes
+
+        bool Load(const std::string& fileName);
+
+        /*!
+         * Bilinear interpolation of every depth level at one position, skipping corners with no data.
+         * Levels with no valid corners are NaN.
+         */
+        bool Column(double lat, double lon, std::vector<double>& colTemp, std::vector<double>& colSal) const;
+    };
+
+
+    bool SGrid::Load(const std::string& fileName)
+    {
+        if (!file.Open(fileName))
+        {
+            std::cout << "Cannot open climatology file " << fileName << "\n";
+            return false;
+        }
+
+        if (file.Size() < sizeof(SFileHeader))
+            return false;
+        std::memcpy(&header, file.Data(), sizeof(header));
+        if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.numDepth == 0 || header.latStep <= 0
+            || header.lonStep <= 0)
+        {
+            std::cout << fileName << " is not a climatology file\n";
+            return false;
+        }
+
+        const size_t numValues = size_t(header.numLat) * header.numLon * header.numDepth;
+        const size_t expected = sizeof(SFileHeader) + header.numDepth * sizeof(double) + 2 * numValues * sizeof(float);
+        if (file.Size() < expected)
+        {
+            std::cout << "Climatology file " << fileName << " is truncated\n";
+            return false;
+        }
+
+        depths = reinterpret_cast<const double*>(file.Data() + sizeof(SFileHeader));
+        temp = reinterpret_cast<const float*>(depths + header.numDepth);
+        salinity = temp + numValues;
+        wrapLon = header.numLon * header.lonStep >= 360.0 - 1e-6;
+        return true;
+    }
+
+
+    bool SGrid::Column(double lat, double lon, std::vector<double>& colTemp, std::vector<double>& colSal) const
+    {
+        const double row = (lat - header.lat0) / header.latStep;
+        if (row < 0 || row > header.numLat - 1.0)
+            return false;
+
+        if (wrapLon)
+            lon = header.lon0 + std::fmod(std::fmod(lon - header.lon0, 360.0) + 360.0, 360.0);
+        const double col = (lon - header.lon0) / header.lonStep;
+        if (col < 0 || (!wrapLon && col > header.numLon - 1.0))
+            return false;
+
+        const size_t r0 = std::min<size_t>(static_cast<size_t>(row), header.numLat - 1);
+        const size_t r1 = std::min<size_t>(r0 + 1, header.numLat - 1);
+        const size_t c0 = std::min<size_t>(static_cast<size_t>(col), header.numLon - 1);
+        const size_t c1 = (c0 + 1 < header.numLon) ? c0 + 1 : (wrapLon ? 0 : c0);
+        const double fr = row - r0, fc = col - c0;
+
+        const size_t numDepth = header.numDepth;
+        const size_t corners[4] = { (r0 * header.numLon + c0) * numDepth, (r0 * header.numLon + c1) * numDepth,
+            (r1 * header.numLon + c0) * numDepth, (r1 * header.numLon + c1) * numDepth };
+        const double weights[4] = { (1 - fr) * (1 - fc), (1 - fr) * fc, fr * (1 - fc), fr * fc };
+
+        colTemp.resize(numDepth);
+        colSal.resize(numDepth);
+        bool any = false;
+        for (size_t n = 0; n < numDepth; ++n)
+        {
+            double sumT = 0, sumS = 0, sumW = 0;
+            for (int k = 0; k < 4; ++k)
+            {
+                const double t = temp[corners[k] + n], s = salinity[corners[k] + n];
+                if (std::isnan(t) || std::isnan(s) || weights[k] == 0)
+                    continue;
+                sumT += weights[k] * t;
+                sumS += weights[k] * s;
+                sumW += weights[k];
+            }
+            colTemp[n] = (sumW > 0) ? sumT / sumW : NaN;
+            colSal[n] = (sumW > 0) ? sumS / sumW : NaN;
+            any |= (sumW > 0);
+        }
+
+        return any;
+    }
+
+
+    //! Linear interpolation of a column at a depth. NaN outside the levels or next to a level with no data.
+    double InterpolateLevel(const double* depths, const std::vector<double>& values, double depth)
+    {
+        const size_t count = values.size();
+        const double* upper = std::upper_bound(depths, depths + count, depth);
+        if (upper == depths)
+            return NaN;
+        if (upper == depths + count)
+            return (depth == depths[count - 1]) ? values[count - 1] : NaN;
+
+        const size_t n = upper - depths;
+        const double t = (depth - depths[n - 1]) / (depths[n] - depths[n - 1]);
+        return values[n - 1] + t * (values[n] - values[n - 1]);
+    }
+
+
+    std::mutex cacheMutex;
+    std::map<std::string, std::shared_ptr<const SGrid>> cache;
+
+    //! Loads a grid, or returns the one already mapped for this file name
+    std::shared_ptr<const SGrid> GetGrid(const std::string& fileName)
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = cache.find(fileName);
+        if (it != cache.end())
+            return it->second;
+
+        auto grid = std::make_shared<SGrid>();
+        if (!grid->Load(fileName))
+            return nullptr;
+        cache[fileName] = grid;
+        return grid;
+    }
+};  // End namespace ssp::climatology
+
+
+namespace ssp
+{
+
+bool WriteClimatology(const std::string& fileName, const SClimatologyGrid& grid)
+{
+    using namespace climatology;
+
+    const size_t numValues = grid.numLat * grid.numLon * grid.depths.size();
+    if (grid.depths.empty() || grid.temp.size() != numValues || grid.salinity.size() != numValues)
+    {
+        std::cout << "Climatology grid sizes do not match\n";
+        return false;
+    }
+
+    SFileHeader header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.numLat = static_cast<uint32_t>(grid.numLat);
+    header.numLon = static_cast<uint32_t>(grid.numLon);
+    header.numDepth = static_cast<uint32_t>(grid.depths.size());
+    header.lat0 = grid.lat0;
+    header.latStep = grid.latStep;
+    header.lon0 = grid.lon0;
+    header.lonStep = grid.lonStep;
+
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Cannot create climatology file " << fileName << "\n";
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(grid.depths.data()), grid.depths.size() * sizeof(double));
+    file.write(reinterpret_cast<const char*>(grid.temp.data()), numValues * sizeof(float));
+    file.write(reinterpret_cast<const char*>(grid.salinity.data()), numValues * sizeof(float));
+    return file.good();
+}
+
+
+bool ClimatologyAt(const std::string& fileName, double lat, double lon, double depth, double& temp, double& salinity)
+{
+    auto grid = climatology::GetGrid(fileName);
+    if (!grid)
+        return false;
+
+    std::vector<double> colTemp, colSal;
+    if (!grid->Column(lat, lon, colTemp, colSal))
+        return false;
+
+    temp = climatology::InterpolateLevel(grid->depths, colTemp, depth);
+    salinity = climatology::InterpolateLevel(grid->depths, colSal, depth);
+    return !std::isnan(temp) && !std::isnan(salinity);
+}
+
+
+size_t ExtendCast(SCast& cast, const std::string& climatologyFile, double step, double blendDepth)
+{
+    using namespace climatology;
+
+    if (cast.entries.empty() || step <= 0)
+        return 0;
+    auto grid = GetGrid(climatologyFile);
+    if (!grid)
+        return 0;
+
+    std::vector<double> colTemp, colSal;
+    if (!grid->Column(cast.lat, cast.lon, colTemp, colSal))
+    {
+        std::cout << "No climatology at " << cast.lat << ", " << cast.lon << "\n";
+        return 0;
+    }
+
+    // Deepest level with data at this position
+    size_t deepest = colTemp.size();
+    while (deepest > 0 && std::isnan(colTemp[deepest - 1]))
+        --deepest;
+    if (deepest == 0)
+        return 0;
+    const double bottom = grid->depths[deepest - 1];
+
+    // Index 0 is the junction (the cast's last entry), used to match the climatology to the cast
+    const SCastEntry last = cast.entries.back();
+    const size_t count = (bottom > last.depth) ? static_cast<size_t>(std::ceil((bottom - last.depth) / step)) + 1 : 0;
+    if (count < 2)
+        return 0;
+
+    std::vector<double> depth(count), temp(count), salinity(count), pressure(count), c(count), blend(count);
+    for (size_t n = 0; n < count; ++n)
+    {
+        depth[n] = std::min(last.depth + n * step, bottom);
+        temp[n] = InterpolateLevel(grid->depths, colTemp, depth[n]);
+        salinity[n] = InterpolateLevel(grid->depths, colSal, depth[n]);
+        blend[n] = (blendDepth > 0) ? std::max(0.0, 1.0 - (depth[n] - last.depth) / blendDepth) : 0.0;
+    }
+    if (std::isnan(temp[0]) || std::isnan(salinity[0]))
+    {
+        std::cout << "Climatology does not cover the bottom of the cast (" << last.depth << " m)\n";
+        return 0;
+    }
+
+    // Shift temperature and salinity (when the cast has them) to meet the cast, then sound speed
+    //  (checked over the whole cast, since 0 C is a real temperature at the junction)
+    const bool bHasTemp = std::any_of(cast.entries.begin(), cast.entries.end(), [](const SCastEntry& e) { return e.temp != 0; });
+    const bool bHasSalinity = std::any_of(cast.entries.begin(), cast.entries.end(), [](const SCastEntry& e) { return e.salinity != 0; });
+    const double tempShift = bHasTemp ? last.temp - temp[0] : 0.0;
+    const double salShift = bHasSalinity ? last.salinity - salinity[0] : 0.0;
+    for (size_t n = 0; n < count; ++n)
+    {
+        temp[n] += blend[n] * tempShift;
+        salinity[n] += blend[n] * salShift;
+    }
+
+    DepthToPressure(depth.data(), pressure.data(), count, cast.lat);
+    WongZhu(temp.data(), salinity.data(), pressure.data(), c.data(), count);
+
+    const double cShift = last.c - c[0];
+    for (size_t n = 0; n < count; ++n)
+        c[n] += blend[n] * cShift;
+
+    for (size_t n = 1; n < count; ++n)
+    {
+        SCastEntry entry;
+        entry.depth = depth[n];
+        entry.c = c[n];
+        entry.temp = temp[n];
+        entry.salinity = salinity[n];
+        entry.pressure = pressure[n];
+        cast.entries.push_back(entry);
+    }
+
+    return count - 1;
+}
+
+
+void ClearClimatologyCache()
+{
+    std::lock_guard<std::mutex> lock(climatology::cacheMutex);
+    climatology::cache.clear();
+    return;
+}
+
+};  // End namespace ssp
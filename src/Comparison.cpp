@@ -0,0 +1,167 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Comparison.cpp
+  * \brief  Differences between sound speed profiles and their effect on swath soundings
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/Comparison.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "../include/SspCpp/RayTrace.h"
+#include "Parallel.h"
+
+
+namespace ssp::compare
+{
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    //! Great circle distance in meters (haversine, on a spherical earth)
+    double Distance(double lat0, double lon0, double lat1, double lon1)
+    {
+        constexpr double degToRad = 0.017453292519943295;
+        constexpr double earthRadius = 6371008.8;
+        const double sinLat = std::sin(0.5 * (lat1 - lat0) * degToRad);
+        const double sinLon = std::sin(0.5 * (lon1 - lon0) * degToRad);
+        const double h = sinLat * sinLat + std::cos(lat0 * degToRad) * std::cos(lat1 * degToRad) * sinLon * sinLon;
+        return 2.0 * earthRadius * std::asin(std::min(1.0, std::sqrt(h)));
+    }
+
+    //! Compiles every cast in parallel (nullptr for casts that cannot be compiled)
+    std::vector<std::shared_ptr<const SCompiledProfile>> CompileAll(const std::vector<SCast>& casts, unsigned int numThreads)
+    {
+        std::vector<std::shared_ptr<const SCompiledProfile>> profiles(casts.size());
+        ParallelFor(casts.size(), numThreads, [&](size_t n)
+            {
+                profiles[n] = CompileProfile(casts[n]);
+            });
+        return profiles;
+    }
+};  // End namespace ssp::compare
+
+
+namespace ssp
+{
+
+SProfileDifference CompareProfiles(const SCompiledProfile& reference, const SCompiledProfile& profile,
+    const SSwathGeometry& swath, double gridStep)
+{
+    using compare::NaN;
+    SProfileDifference result = { NaN, NaN, NaN, NaN, NaN };
+
+    // Sound speeds on a common grid
+    const double top = std::max(reference.MinDepth(), profile.MinDepth());
+    const double bottom = std::min(reference.MaxDepth(), profile.MaxDepth());
+    if (gridStep > 0 && bottom >= top)
+    {
+        const size_t count = static_cast<size_t>((bottom - top) / gridStep) + 1;
+        double maxDiff = -1.0, sumSquares = 0.0;
+        for (size_t n = 0; n < count; ++n)
+        {
+            const double depth = top + n * gridStep;
+            const double diff = std::abs(profile.SoundSpeed(depth) - reference.SoundSpeed(depth));
+            sumSquares += diff * diff;
+            if (diff > maxDiff)
+            {
+                maxDiff = diff;
+                result.maxSpeedDifferenceDepth = depth;
+            }
+        }
+        result.maxSpeedDifference = maxDiff;
+        result.rmsSpeedDifference = std::sqrt(sumSquares / count);
+    }
+
+    // Soundings across the swath
+    if (swath.waterDepth > swath.transducerDepth && swath.numBeams > 0)
+    {
+        const double angleStep = (swath.numBeams > 1) ? swath.maxBeamAngle / (swath.numBeams - 1) : 0.0;
+        for (unsigned int beam = 0; beam < swath.numBeams; ++beam)
+        {
+            const double angle = beam * angleStep;
+            auto truth = TraceRayToDepth(reference, swath.transducerDepth, angle, swath.waterDepth);
+            if (!truth)
+                continue;
+            auto sounding = TraceRayForTime(profile, swath.transducerDepth, angle, truth->time);
+            if (!sounding)
+                continue;
+
+            const double depthError = std::abs(sounding->depth - truth->depth);
+            const double horizontalError = std::abs(sounding->horizontal - truth->horizontal);
+            result.maxDepthError = std::isnan(result.maxDepthError) ? depthError : std::max(result.maxDepthError, depthError);
+            result.maxHorizontalError = std::isnan(result.maxHorizontalError) ? horizontalError : std::max(result.maxHorizontalError, horizontalError);
+        }
+    }
+
+    return result;
+}
+
+
+std::optional<SProfileDifference> CompareProfiles(const SCast& reference, const SCast& cast, const SSwathGeometry& swath, double gridStep)
+{
+    auto referenceProfile = CompileProfile(reference);
+    auto profile = CompileProfile(cast);
+    if (!referenceProfile || !profile)
+        return {};
+    return CompareProfiles(*referenceProfile, *profile, swath, gridStep);
+}
+
+
+std::vector<SNeighbourComparison> CompareWithNeighbours(const std::vector<SCast>& newCasts, const std::vector<SCast>& existingCasts,
+    double radiusMeters, const SSwathGeometry& swath, double gridStep, unsigned int numThreads)
+{
+    const auto newProfiles = compare::CompileAll(newCasts, numThreads);
+    const auto existingProfiles = compare::CompileAll(existingCasts, numThreads);
+
+    std::vector<std::vector<SNeighbourComparison>> perCast(newCasts.size());
+    ParallelFor(newCasts.size(), numThreads, [&](size_t n)
+        {
+            if (!newProfiles[n])
+                return;
+            for (size_t m = 0; m < existingCasts.size(); ++m)
+            {
+                if (!existingProfiles[m])
+                    continue;
+                const double distance = compare::Distance(newCasts[n].lat, newCasts[n].lon, existingCasts[m].lat, existingCasts[m].lon);
+                if (distance > radiusMeters)
+                    continue;
+
+                SNeighbourComparison comparison;
+                comparison.cast = n;
+                comparison.neighbour = m;
+                comparison.distance = distance;
+                comparison.difference = CompareProfiles(*existingProfiles[m], *newProfiles[n], swath, gridStep);
+                perCast[n].push_back(comparison);
+            }
+        });
+
+    std::vector<SNeighbourComparison> result;
+    for (auto& comparisons : perCast)
+        result.insert(result.end(), comparisons.begin(), comparisons.end());
+    return result;
+}
+
+};  // End namespace ssp
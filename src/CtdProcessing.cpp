@@ -0,0 +1,190 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   CtdProcessing.cpp
+  * \brief  Turning raw CTD time series into a single-direction, depth-binned cast
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/CtdProcessing.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "Parallel.h"
+
+
+namespace ssp::ctd
+{
+    //! Adds every value of entry to sum, combining the flags
+    inline void Accumulate(SCastEntry& sum, const SCastEntry& entry)
+    {
+        sum.c += entry.c;
+        sum.temp += entry.temp;
+        sum.salinity += entry.salinity;
+        sum.pressure += entry.pressure;
+        sum.absorp += entry.absorp;
+        sum.density += entry.density;
+        sum.sigmaT += entry.sigmaT;
+        sum.n2 += entry.n2;
+        sum.flags |= entry.flags;
+        return;
+    }
+
+
+    //! Turns a sum of count entries into their average at depth
+    inline SCastEntry Average(const SCastEntry& sum, size_t count, double depth)
+    {
+        const double scale = 1.0 / count;
+        SCastEntry entry = sum;
+        entry.depth = depth;
+        entry.c *= scale;
+        entry.temp *= scale;
+        entry.salinity *= scale;
+        entry.pressure *= scale;
+        entry.absorp *= scale;
+        entry.density *= scale;
+        entry.sigmaT *= scale;
+        entry.n2 *= scale;
+        return entry;
+    }
+
+
+    //! Start of the final descent: the last entry above soakDepth before the turning point
+    size_t DescentStart(const std::vector<SCastEntry>& entries, size_t turn, double soakDepth)
+    {
+        if (soakDepth <= 0)
+            return 0;
+        for (size_t n = turn + 1; n-- > 0; )
+        {
+            if (entries[n].depth < soakDepth)
+                return n;
+        }
+        return 0;  // Switched on below the soak depth
+    }
+};  // End namespace ssp::ctd
+
+
+namespace ssp
+{
+
+size_t FindTurningPoint(const SCast& cast)
+{
+    const auto& entries = cast.entries;
+    size_t turn = 0;
+    double deepest = -std::numeric_limits<double>::infinity();
+    for (size_t n = 0; n < entries.size(); ++n)
+    {
+        if (std::isfinite(entries[n].depth) && entries[n].depth > deepest)
+        {
+            deepest = entries[n].depth;
+            turn = n;
+        }
+    }
+    return turn;
+}
+
+
+size_t SplitCast(SCast& cast, const SCastSplitOptions& options)
+{
+    using namespace ctd;
+
+    auto& entries = cast.entries;
+    if (entries.empty())
+        return 0;
+
+    const size_t turn = FindTurningPoint(cast);
+    const bool down = (options.direction == eCastDirection::Down);
+    const size_t first = down ? DescentStart(entries, turn, options.soakDepth) : turn;
+    const size_t last = down ? turn + 1 : entries.size();
+
+    // Keep the samples that reach new depths in the direction of travel (compacted in place, since out <= n)
+    size_t out = 0;
+    for (size_t n = first; n < last; ++n)
+    {
+        const double depth = entries[n].depth;
+        if (!std::isfinite(depth) || depth < 0)
+            continue;  // Bad sample or out of the water
+        if (out > 0 && (down ? depth <= entries[out - 1].depth : depth >= entries[out - 1].depth))
+            continue;  // Soak, heave loop or still at the turning point
+        entries[out++] = entries[n];
+    }
+    entries.resize(out);
+
+    if (!down)
+        std::reverse(begin(entries), end(entries));
+
+    if (options.binSize > 0)
+        return BinAverage(cast, options.binSize);
+    return entries.size();
+}
+
+
+void SplitCasts(std::vector<SCast>& casts, const SCastSplitOptions& options, unsigned int numThreads)
+{
+    ParallelFor(casts.size(), numThreads, [&](size_t n)
+    {
+        SplitCast(casts[n], options);
+    });
+    return;
+}
+
+
+size_t BinAverage(SCast& cast, double binSize)
+{
+    using namespace ctd;
+
+    auto& entries = cast.entries;
+    if (entries.empty() || binSize <= 0)
+        return entries.size();
+
+    const double invSize = 1.0 / binSize;
+    size_t out = 0;
+    size_t n = 0;
+    while (n < entries.size())
+    {
+        if (!std::isfinite(entries[n].depth))
+        {
+            ++n;  // Dropped, as it has no bin
+            continue;
+        }
+
+        // Entries are sorted, so the bin is the run of entries with the same index (always at least this one)
+        const double bin = std::floor(entries[n].depth * invSize + 0.5);
+        SCastEntry sum;
+        size_t count = 0;
+        do
+        {
+            Accumulate(sum, entries[n]);
+            ++n;
+            ++count;
+        } while (n < entries.size() && std::floor(entries[n].depth * invSize + 0.5) == bin);
+        entries[out++] = Average(sum, count, bin * binSize);  // out < n, so nothing unread is overwritten
+    }
+    entries.resize(out);
+
+    return out;
+}
+
+};  // End namespace ssp
@@ -0,0 +1,254 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Density.cpp
+  * \brief  Seawater density (EOS-80) and buoyancy frequency
+  *
+  * Equations and coefficients from "Algorithms for computation of fundamental properties of seawater",
+  * Unesco report by N.P. Fofonoff and R.C. Millard Jr. (1983). http://dx.doi.org/10.25607/OBP-1450
+  * They use IPTS-68 temperatures, pressure in bars for the equation of state and decibars for the lapse rate.
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/Density.h"
+#include <cmath>
+#include "EquationKernels.h"
+#include "Parallel.h"
+
+
+namespace ssp
+{
+namespace density
+{
+    using equation::Horner;
+
+    constexpr double T68PerT90 = 1.00024;
+
+    //! Density of pure water (SMOW) at one atmosphere
+    constexpr double SMOW[] = { 999.842594, 6.793952e-2, -9.095290e-3, 1.001685e-4, -1.120083e-6, 6.536332e-9 };
+    //! Salinity terms of the one atmosphere density
+    constexpr double B[] = { 8.24493e-1, -4.0899e-3, 7.6438e-5, -8.2467e-7, 5.3875e-9 };
+    constexpr double C[] = { -5.72466e-3, 1.0227e-4, -1.6546e-6 };
+    constexpr double D0 = 4.8314e-4;
+
+    //! Secant bulk modulus of pure water
+    constexpr double KW[] = { 19652.21, 148.4206, -2.327105, 1.360477e-2, -5.155288e-5 };
+    constexpr double AW[] = { 3.239908, 1.43713e-3, 1.16092e-4, -5.77905e-7 };
+    constexpr double BW[] = { 8.50935e-5, -6.12293e-6, 5.2787e-8 };
+    //! Salinity terms of the secant bulk modulus
+    constexpr double F[] = { 54.6746, -0.603459, 1.09987e-2, -6.1670e-5 };
+    constexpr double G[] = { 7.944e-2, 1.6483e-2, -5.3009e-4 };
+    constexpr double I[] = { 2.2838e-3, -1.0981e-5, -1.6078e-6 };
+    constexpr double J0 = 1.91075e-4;
+    constexpr double M[] = { -9.9348e-7, 2.0816e-8, 9.1697e-10 };
+
+    //! Density at one atmosphere (T in IPTS-68)
+    inline double SurfaceDensity(double T, double S)
+    {
+        return Horner(SMOW, T) + Horner(B, T) * S + Horner(C, T) * S * std::sqrt(S) + D0 * S * S;
+    }
+
+    //! In situ density (T in IPTS-68, P in bars)
+    inline double InSituDensity(double T, double S, double P)
+    {
+        const double sqrtS = std::sqrt(S);
+        const double K0 = Horner(KW, T) + (Horner(F, T) + Horner(G, T) * sqrtS) * S;
+        const double A = Horner(AW, T) + (Horner(I, T) + J0 * sqrtS) * S;
+        const double Bk = Horner(BW, T) + Horner(M, T) * S;
+        const double K = K0 + (A + Bk * P) * P;
+        return SurfaceDensity(T, S) / (1.0 - P / K);
+    }
+
+    //! Adiabatic lapse rate in degrees C/decibar (T in IPTS-68, P in decibars)
+    inline double LapseRate(double T, double S, double P)
+    {
+        const double dS = S - 35.0;
+        return 3.5803e-5 + T * (8.5258e-6 + T * (-6.836e-8 + T * 6.6228e-10))
+            + (1.8932e-6 - 4.2393e-8 * T) * dS
+            + ((1.8741e-8 + T * (-6.7795e-10 + T * (8.733e-12 - T * 5.4481e-14))) + (-1.1351e-10 + 2.7759e-12 * T) * dS) * P
+            + (-4.6206e-13 + T * (1.8676e-14 - T * 2.1687e-16)) * P * P;
+    }
+
+    //! Potential temperature (IPTS-68) from P to reference pressure PR (decibars)
+    inline double PotentialTemperature68(double T, double S, double P, double PR)
+    {
+        const double sqrt2 = std::sqrt(2.0);
+        const double dP = PR - P;
+
+        double dTheta = dP * LapseRate(T, S, P);
+        double theta = T + 0.5 * dTheta;
+        double q = dTheta;
+
+        dTheta = dP * LapseRate(theta, S, P + 0.5 * dP);
+        theta += (1.0 - 1.0 / sqrt2) * (dTheta - q);
+        q = (2.0 - sqrt2) * dTheta + (-2.0 + 3.0 / sqrt2) * q;
+
+        dTheta = dP * LapseRate(theta, S, P + 0.5 * dP);
+        theta += (1.0 + 1.0 / sqrt2) * (dTheta - q);
+        q = (2.0 + sqrt2) * dTheta + (-2.0 - 3.0 / sqrt2) * q;
+
+        dTheta = dP * LapseRate(theta, S, P + dP);
+        return theta + (dTheta - 2.0 * q) / 6.0;
+    }
+
+    //! Density of a sample after moving it adiabatically to the reference pressure (bars)
+    inline double LeveledDensity(double T, double S, double P, double referenceP)
+    {
+        const double theta = PotentialTemperature68(T * T68PerT90, S, P * 10.0, referenceP * 10.0);
+        return InSituDensity(theta, S, referenceP);
+    }
+
+
+    //! Per-sample inputs of a cast with missing values filled in, in per-thread buffers
+    struct SInputs
+    {
+        std::vector<double> temp, salin, pressure, depth;
+
+        void Gather(const SCast& cast)
+        {
+            const size_t count = cast.entries.size();
+            temp.resize(count);
+            salin.resize(count);
+            pressure.resize(count);
+            depth.resize(count);
+            for (size_t n = 0; n < count; ++n)
+            {
+                const auto& entry = cast.entries[n];
+                temp[n] = entry.temp;
+                salin[n] = entry.salinity > 0 ? entry.salinity : 35.0;
+                pressure[n] = entry.pressure != 0 ? entry.pressure : DepthToPressure(entry.depth, cast.lat);
+                depth[n] = entry.depth;
+            }
+        }
+    };
+};  // End namespace density
+
+
+using namespace density;
+
+double Density(double temp, double salin, double pressure)
+{
+    return InSituDensity(temp * T68PerT90, salin, pressure);
+}
+
+
+void Density(const double* temp, const double* salin, const double* pressure, double* density, size_t count)
+{
+    for (size_t n = 0; n < count; ++n)
+        density[n] = InSituDensity(temp[n] * T68PerT90, salin[n], pressure[n]);
+    return;
+}
+
+
+double SigmaT(double temp, double salin)
+{
+    return SurfaceDensity(temp * T68PerT90, salin) - 1000.0;
+}
+
+
+double PotentialTemperature(double temp, double salin, double pressure, double referencePressure)
+{
+    return PotentialTemperature68(temp * T68PerT90, salin, pressure * 10.0, referencePressure * 10.0) / T68PerT90;
+}
+
+
+void BuoyancyFrequency(const double* temp, const double* salin, const double* pressure, const double* depth,
+    double* n2, size_t count, double latitudeDeg)
+{
+    const double g = Gravity(latitudeDeg);
+    for (size_t n = 0; n < count; ++n)
+    {
+        const size_t above = n > 0 ? n - 1 : n;
+        const size_t below = n + 1 < count ? n + 1 : n;
+        const double dz = depth[below] - depth[above];
+        if (!(dz > 0))
+        {
+            n2[n] = 0.0;
+            continue;
+        }
+
+        const double P = pressure[n];
+        const double rhoAbove = LeveledDensity(temp[above], salin[above], pressure[above], P);
+        const double rhoBelow = LeveledDensity(temp[below], salin[below], pressure[below], P);
+        n2[n] = 2.0 * g * (rhoBelow - rhoAbove) / ((rhoBelow + rhoAbove) * dz);
+    }
+    return;
+}
+
+
+void FillDensity(SCast& cast)
+{
+    thread_local SInputs in;
+    in.Gather(cast);
+
+    const size_t count = cast.entries.size();
+    thread_local std::vector<double> n2;
+    n2.resize(count);
+    BuoyancyFrequency(in.temp.data(), in.salin.data(), in.pressure.data(), in.depth.data(), n2.data(), count, cast.lat);
+
+    for (size_t n = 0; n < count; ++n)
+    {
+        auto& entry = cast.entries[n];
+        entry.density = Density(in.temp[n], in.salin[n], in.pressure[n]);
+        entry.sigmaT = SigmaT(in.temp[n], in.salin[n]);
+        entry.n2 = n2[n];
+    }
+    return;
+}
+
+
+void FillDensity(SCastTable& table, unsigned int numThreads)
+{
+    const size_t numSamples = table.NumSamples();
+    table.density.resize(numSamples);
+    table.sigmaT.resize(numSamples);
+    table.n2.resize(numSamples);
+
+    ParallelFor(table.NumCasts(), numThreads, [&](size_t n)
+        {
+            const size_t first = table.offsets[n], count = table.offsets[n + 1] - first;
+            thread_local SInputs in;
+            in.temp.assign(table.temp.data() + first, table.temp.data() + first + count);
+            in.depth.assign(table.depth.data() + first, table.depth.data() + first + count);
+            in.salin.resize(count);
+            in.pressure.resize(count);
+            for (size_t k = 0; k < count; ++k)
+            {
+                const double salinity = table.salinity[first + k], pressure = table.pressure[first + k];
+                in.salin[k] = salinity > 0 ? salinity : 35.0;
+                in.pressure[k] = pressure != 0 ? pressure : DepthToPressure(in.depth[k], table.lats[n]);
+            }
+
+            Density(in.temp.data(), in.salin.data(), in.pressure.data(), table.density.data() + first, count);
+            for (size_t k = 0; k < count; ++k)
+                table.sigmaT[first + k] = SigmaT(in.temp[k], in.salin[k]);
+            BuoyancyFrequency(in.temp.data(), in.salin.data(), in.pressure.data(), in.depth.data(),
+                table.n2.data() + first, count, table.lats[n]);
+        });
+
+    return;
+}
+
+};  // End namespace ssp
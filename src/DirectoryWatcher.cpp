@@ -0,0 +1,361 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   DirectoryWatcher.cpp
+  * \brief  Watches a directory and reads new casts as soon as they are written (Linux only)
+  *
+  * One event thread waits in poll() on the inotify descriptor and an eventfd used to stop it. Files that
+  * were closed after writing or renamed into the directory go into a pending map with a settle deadline,
+  * which further writes push back. The poll timeout is the nearest deadline (or infinite when nothing is
+  * pending), and settled files are queued for the worker threads.
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/DirectoryWatcher.h"
+#include "../include/SspCpp/SoundSpeed.h"
+#include "Parallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+
+namespace ssp
+{
+
+struct DirectoryWatcher::SImpl
+{
+    std::string directory;
+    WatchCallback callback;
+    SWatchOptions options;
+
+    int inotifyFd = -1;
+    int stopFd = -1;
+    std::thread eventThread;
+    std::vector<std::thread> workers;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<std::string> queue;
+    bool stopping = false;
+
+    std::atomic<bool> running{ false };
+    std::atomic<size_t> files{ 0 };
+    std::atomic<size_t> casts{ 0 };
+    std::atomic<size_t> failures{ 0 };
+
+    void Enqueue(std::string fileName)
+    {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back(std::move(fileName));
+        }
+        queueReady.notify_one();
+        return;
+    }
+
+    void EventLoop();
+    void Worker();
+};
+
+
+void DirectoryWatcher::SImpl::Worker()
+{
+    for (;;)
+    {
+        std::string fileName;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+            fileName = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        // An exception from a reader or the callback must not escape the pool thread, which would terminate
+        //  the whole process. It is counted as a failure and the worker moves on to the next file.
+        std::vector<SCast> fileCasts;
+        try
+        {
+            fileCasts = ReadCastsFromFile(fileName, DetermineFileType(fileName));
+        }
+        catch (const std::exception& e)
+        {
+            fmt::print("Could not read {}: {}\n", fileName, e.what());
+        }
+        catch (...)
+        {
+            fmt::print("Could not read {}: unknown exception\n", fileName);
+        }
+
+        ++files;
+        casts += fileCasts.size();
+        if (fileCasts.empty())
+            ++failures;
+
+        try
+        {
+            callback(fileName, fileCasts);
+        }
+        catch (const std::exception& e)
+        {
+            fmt::print("Watch callback failed for {}: {}\n", fileName, e.what());
+            if (!fileCasts.empty())
+                ++failures;
+        }
+        catch (...)
+        {
+            fmt::print("Watch callback failed for {}: unknown exception\n", fileName);
+            if (!fileCasts.empty())
+                ++failures;
+        }
+    }
+}
+
+
+#ifdef __linux__
+
+void DirectoryWatcher::SImpl::EventLoop()
+{
+    using Clock = std::chrono::steady_clock;
+    std::unordered_map<std::string, Clock::time_point> pending;  // File name and when it will have settled
+    alignas(inotify_event) char buffer[64 * 1024];
+
+    for (;;)
+    {
+        int timeout = -1;  // Sleep until something happens when no files are waiting to settle
+        if (!pending.empty())
+        {
+            auto next = Clock::time_point::max();
+            for (const auto& file : pending)
+                next = std::min(next, file.second);
+            const auto wait = std::chrono::ceil<std::chrono::milliseconds>(next - Clock::now());
+            timeout = static_cast<int>(std::max<long long>(0, wait.count()));
+        }
+
+        pollfd fds[2] = { { inotifyFd, POLLIN, 0 }, { stopFd, POLLIN, 0 } };
+        if (poll(fds, 2, timeout) < 0 && errno != EINTR)
+        {
+            fmt::print("Stopped watching {}: poll failed ({})\n", directory, errno);
+            break;
+        }
+        if (fds[1].revents & POLLIN)
+            break;
+
+        bool removed = false;
+        if (fds[0].revents & POLLIN)
+        {
+            const ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            const auto settled = Clock::now() + options.settleTime;
+            for (ssize_t offset = 0; offset < length; )
+            {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW)
+                    fmt::print("Too many changes in {} at once, some files were missed\n", directory);
+                if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+                    removed = true;
+                if (event->len == 0 || (event->mask & IN_ISDIR))
+                    continue;
+
+                std::string fileName = (std::filesystem::path(directory) / event->name).string();
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    if (DetermineFileType(fileName) != eCastType::Unknown)
+                        pending[std::move(fileName)] = settled;
+                }
+                else if (event->mask & IN_MODIFY)
+                {
+                    // Still being written after it was closed once, so wait for it to settle again
+                    auto file = pending.find(fileName);
+                    if (file != pending.end())
+                        file->second = settled;
+                }
+            }
+        }
+
+        const auto now = Clock::now();
+        for (auto file = pending.begin(); file != pending.end(); )
+        {
+            if (file->second <= now)
+            {
+                Enqueue(file->first);
+                file = pending.erase(file);
+            }
+            else
+                ++file;
+        }
+
+        if (removed)
+        {
+            fmt::print("Stopped watching {}: the directory was removed or moved\n", directory);
+            break;
+        }
+    }
+
+    // Files still settling when watching stops are read anyway, so none are lost
+    for (auto& file : pending)
+        Enqueue(file.first);
+    return;
+}
+
+
+bool DirectoryWatcher::Start(const std::string& directory, WatchCallback callback, const SWatchOptions& options)
+{
+    if (impl->running)
+        return false;
+
+    const int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+        return false;
+    if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MODIFY | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR) < 0)
+    {
+        fmt::print("Unable to watch directory {}\n", directory);
+        close(inotifyFd);
+        return false;
+    }
+    const int stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd < 0)
+    {
+        close(inotifyFd);
+        return false;
+    }
+
+    impl->directory = directory;
+    impl->callback = std::move(callback);
+    impl->options = options;
+    impl->inotifyFd = inotifyFd;
+    impl->stopFd = stopFd;
+    impl->stopping = false;
+    impl->files = 0;
+    impl->casts = 0;
+    impl->failures = 0;
+
+    // The watch is already in place, so nothing written from here on is missed
+    if (options.readExisting)
+    {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+        {
+            if (entry.is_regular_file(error) && DetermineFileType(entry.path().string()) != eCastType::Unknown)
+                impl->queue.push_back(entry.path().string());
+        }
+    }
+
+    const unsigned int numThreads = ResolveThreadCount(options.numThreads, SIZE_MAX);
+    for (unsigned int t = 0; t < numThreads; ++t)
+        impl->workers.emplace_back(&SImpl::Worker, impl.get());
+    impl->eventThread = std::thread(&SImpl::EventLoop, impl.get());
+    impl->running = true;
+    return true;
+}
+
+
+void DirectoryWatcher::Stop()
+{
+    if (!impl->running)
+        return;
+
+    const uint64_t one = 1;
+    if (write(impl->stopFd, &one, sizeof(one)) != sizeof(one))
+        fmt::print("Unable to signal the directory watcher to stop\n");
+    impl->eventThread.join();
+
+    {
+        std::lock_guard<std::mutex> lock(impl->queueMutex);
+        impl->stopping = true;
+    }
+    impl->queueReady.notify_all();
+    for (auto& worker : impl->workers)
+        worker.join();
+    impl->workers.clear();
+
+    close(impl->inotifyFd);
+    close(impl->stopFd);
+    impl->inotifyFd = -1;
+    impl->stopFd = -1;
+    impl->running = false;
+    return;
+}
+
+#else
+
+void DirectoryWatcher::SImpl::EventLoop()
+{
+    return;
+}
+
+
+bool DirectoryWatcher::Start(const std::string& directory, WatchCallback callback, const SWatchOptions& options)
+{
+    fmt::print("Directory watching is only supported on Linux\n");
+    return false;
+}
+
+
+void DirectoryWatcher::Stop()
+{
+    return;
+}
+
+#endif
+
+
+DirectoryWatcher::DirectoryWatcher() : impl(std::make_unique<SImpl>()) {}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+    Stop();
+}
+
+
+bool DirectoryWatcher::IsRunning() const
+{
+    return impl->running;
+}
+
+
+SWatchStats DirectoryWatcher::Stats() const
+{
+    SWatchStats stats;
+    stats.files = impl->files;
+    stats.casts = impl->casts;
+    stats.failures = impl->failures;
+    return stats;
+}
+
+};  // End namespace ssp
@@ -0,0 +1,177 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   EquationKernels.h
+  * \brief  Sound speed equations as inlinable kernels, one type per equation
+  *
+  * Each kernel is built once per batch (so anything that depends only on latitude is computed once) and
+  * then called for every sample. Coefficients are constexpr tables and polynomials are evaluated with
+  * Horner's rule. Batches are vectorized across samples, which gives more parallelism than Estrin's
+  * scheme would within a single polynomial, so Horner's fewer operations win. The files that include this
+  * header are built with -fno-math-errno on GCC and Clang (see src/CMakeLists.txt); otherwise the errno
+  * branch in std::sqrt keeps the Chen-Millero kernels (WongZhu and UNESCO) from vectorizing.
+  */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include "../include/SspCpp/SoundSpeed.h"
+
+
+namespace ssp
+{
+namespace equation
+{
+    //! a[0] + a[1] x + a[2] x^2 + ...
+    template <size_t N>
+    constexpr double Horner(const double (&a)[N], double x)
+    {
+        double result = a[N - 1];
+        for (size_t n = N - 1; n-- > 0; )
+            result = result * x + a[n];
+        return result;
+    }
+
+    //! Leroy and Parthiot depth in meters from pressure in bars, with gravity already found for the latitude
+    inline double LeroyParthiotDepth(double pressureBar, double g)
+    {
+        const double P = pressureBar * 0.1;  // Bars to MegaPascal
+        const double Z = P * (9.72659e2 + P * (-2.2512e-1 + P * (2.279e-4 - P * 1.82e-7)));
+        return Z / (g + 1.092e-4 * P);
+    }
+
+
+    //! IPTS-68 temperature from ITS-90 (Saunders 1990), for the equations published before ITS-90
+    constexpr double ipts68PerIts90 = 1.00024;
+
+
+    //! Coefficients of the Chen-Millero form as refit by Wong and Zhu for ITS-90
+    struct SWongZhuCoefficients
+    {
+        static constexpr double tempScale = 1.0;  //!< Already ITS-90
+        static constexpr double C0[] = { 1402.388, 5.03830, -5.81090e-2, 3.3432e-4, -1.47797e-6, 3.1419e-9 };
+        static constexpr double C1[] = { 0.153563, 6.8999e-4, -8.1829e-6, 1.3632e-7, -6.1260e-10 };
+        static constexpr double C2[] = { 3.1260e-5, -1.7111e-6, 2.5986e-8, -2.5353e-10, 1.0415e-12 };
+        static constexpr double C3[] = { -9.7729e-9, 3.8513e-10, -2.3654e-12 };
+        static constexpr double A0[] = { 1.389, -1.262e-2, 7.166e-5, 2.008e-6, -3.21e-8 };
+        static constexpr double A1[] = { 9.4742e-5, -1.2583e-5, -6.4928e-8, 1.0515e-8, -2.0142e-10 };
+        static constexpr double A2[] = { -3.9064e-7, 9.1061e-9, -1.6009e-10, 7.994e-12 };
+        static constexpr double A3[] = { 1.100e-10, 6.651e-12, -3.391e-13 };
+        static constexpr double B0[] = { -1.922e-2, -4.42e-5 };
+        static constexpr double B1[] = { 7.3637e-5, 1.7950e-7 };
+        static constexpr double D[] = { 1.727e-3, -7.9836e-6 };
+    };
+
+    //! Original UNESCO coefficients (Fofonoff and Millard 1983), for IPTS-68 temperatures
+    struct SUnescoCoefficients
+    {
+        static constexpr double tempScale = ipts68PerIts90;
+        static constexpr double C0[] = { 1402.388, 5.03711, -5.80852e-2, 3.3420e-4, -1.47800e-6, 3.1464e-9 };
+        static constexpr double C1[] = { 0.153563, 6.8982e-4, -8.1788e-6, 1.3621e-7, -6.1185e-10 };
+        static constexpr double C2[] = { 3.1260e-5, -1.7107e-6, 2.5974e-8, -2.5335e-10, 1.0405e-12 };
+        static constexpr double C3[] = { -9.7729e-9, 3.8504e-10, -2.3643e-12 };
+        static constexpr double A0[] = { 1.389, -1.262e-2, 7.164e-5, 2.006e-6, -3.21e-8 };
+        static constexpr double A1[] = { 9.4742e-5, -1.2580e-5, -6.4885e-8, 1.0507e-8, -2.0122e-10 };
+        static constexpr double A2[] = { -3.9064e-7, 9.1041e-9, -1.6002e-10, 7.988e-12 };
+        static constexpr double A3[] = { 1.100e-10, 6.649e-12, -3.389e-13 };
+        static constexpr double B0[] = { -1.922e-2, -4.42e-5 };
+        static constexpr double B1[] = { 7.3637e-5, 1.7945e-7 };
+        static constexpr double D[] = { 1.727e-3, -7.9836e-6 };
+    };
+
+    //! c = Cw(T, P) + A(T, P) S + B(T, P) S^1.5 + D(P) S^2, with ITS-90 temperature and pressure in bars
+    template <class K>
+    struct SChenMilleroKernel
+    {
+        explicit SChenMilleroKernel(double /*latitudeDeg*/) {}
+
+        double operator()(double T90, double S, double P) const
+        {
+            const double T = T90 * K::tempScale;
+            const double Cw[] = { Horner(K::C0, T), Horner(K::C1, T), Horner(K::C2, T), Horner(K::C3, T) };
+            const double A[] = { Horner(K::A0, T), Horner(K::A1, T), Horner(K::A2, T), Horner(K::A3, T) };
+            const double B[] = { Horner(K::B0, T), Horner(K::B1, T) };
+            return Horner(Cw, P) + Horner(A, P) * S + Horner(B, P) * S * std::sqrt(S) + Horner(K::D, P) * S * S;
+        }
+    };
+
+    using SWongZhuKernel = SChenMilleroKernel<SWongZhuCoefficients>;
+    using SUnescoKernel = SChenMilleroKernel<SUnescoCoefficients>;
+
+
+    //! Del Grosso (1974 IPTS-68 coefficients) with pressure in kg/cm^2, converted from ITS-90 temperature and bars
+    struct SDelGrossoKernel
+    {
+        static constexpr double C000 = 1402.392;
+        static constexpr double CT[] = { 0, 0.501109398873e1, -0.550946843172e-1, 0.221535969240e-3 };
+        static constexpr double CS[] = { 0, 0.132952290781e1, 0.128955756844e-3 };
+        static constexpr double CP[] = { 0, 0.156059257041e0, 0.244998688441e-4, -0.883392332513e-8 };
+        static constexpr double kgcm2PerBar = 1.0197162;
+
+        explicit SDelGrossoKernel(double /*latitudeDeg*/) {}
+
+        double operator()(double T90, double S, double pressureBar) const
+        {
+            const double T = T90 * ipts68PerIts90;
+            const double P = pressureBar * kgcm2PerBar;
+            const double STP =
+                T * (S * (-0.127562783426e-1 + T * 0.968403156410e-4 + P * (-0.340597039004e-3 + S * 0.485639620015e-5))
+                     + P * (0.635191613389e-2 + P * (-0.159349479045e-5 + P * 0.522116437235e-9 + T * 0.265484716608e-7)
+                            - T * T * 0.438031096213e-6))
+                - 0.161674495909e-8 * S * S * P * P;
+            return C000 + Horner(CT, T) + Horner(CS, S) + Horner(CP, P) + STP;
+        }
+    };
+
+
+    //! Mackenzie, which is defined on depth rather than pressure
+    struct SMackenzieKernel
+    {
+        static constexpr double CT[] = { 1448.96, 4.591, -5.304e-2, 2.374e-4 };
+
+        explicit SMackenzieKernel(double latitudeDeg) : g(Gravity(latitudeDeg)) {}
+
+        double operator()(double T, double S, double pressureBar) const
+        {
+            const double D = LeroyParthiotDepth(pressureBar, g);
+            const double dS = S - 35.0;
+            return Horner(CT, T) + 1.340 * dS + D * (1.630e-2 + D * 1.675e-7) - 1.025e-2 * T * dS - 7.139e-13 * T * D * D * D;
+        }
+
+        double g;
+    };
+
+
+    template <class Kernel>
+    void Evaluate(const double* temp, const double* salin, const double* pressure, double* c, size_t count, double latitudeDeg)
+    {
+        const Kernel kernel(latitudeDeg);
+        for (size_t n = 0; n < count; ++n)
+            c[n] = kernel(temp[n], salin[n], pressure[n]);
+        return;
+    }
+};  // End namespace equation
+};  // End namespace ssp
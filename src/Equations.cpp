@@ -0,0 +1,97 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Equations.cpp
+  * \brief  Runtime choice of sound speed equation, dispatching to the kernels in EquationKernels.h
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/Equations.h"
+#include <SspCpp/SoundSpeed.h>
+#include "EquationKernels.h"
+
+
+namespace ssp
+{
+
+using namespace equation;
+
+double WongZhu(double temp, double salin, double pressure)
+{
+    // Temp: [0, 40] Celsius
+    // Salinity: [0, 40] parts per thousand (ppt)
+    // Pressure: [0, 1000] bar
+    return SWongZhuKernel(0)(temp, salin, pressure);
+}
+
+
+void WongZhu(const double* temp, const double* salin, const double* pressure, double* c, size_t count)
+{
+    // The kernel is inlined here, and this file is built without errno for sqrt, so this loop vectorizes
+    Evaluate<SWongZhuKernel>(temp, salin, pressure, c, count, 0);
+    return;
+}
+
+
+double SoundSpeed(eSoundSpeedEquation equation, double temp, double salin, double pressure, double latitudeDeg)
+{
+    switch (equation)
+    {
+        case eSoundSpeedEquation::ChenMillero:
+            return SUnescoKernel(latitudeDeg)(temp, salin, pressure);
+        case eSoundSpeedEquation::DelGrosso:
+            return SDelGrossoKernel(latitudeDeg)(temp, salin, pressure);
+        case eSoundSpeedEquation::Mackenzie:
+            return SMackenzieKernel(latitudeDeg)(temp, salin, pressure);
+        case eSoundSpeedEquation::WongZhu:
+        default:
+            return SWongZhuKernel(latitudeDeg)(temp, salin, pressure);
+    }
+}
+
+
+void SoundSpeed(eSoundSpeedEquation equation, const double* temp, const double* salin, const double* pressure,
+    double* c, size_t count, double latitudeDeg)
+{
+    switch (equation)
+    {
+        case eSoundSpeedEquation::ChenMillero:
+            Evaluate<SUnescoKernel>(temp, salin, pressure, c, count, latitudeDeg);
+            break;
+        case eSoundSpeedEquation::DelGrosso:
+            Evaluate<SDelGrossoKernel>(temp, salin, pressure, c, count, latitudeDeg);
+            break;
+        case eSoundSpeedEquation::Mackenzie:
+            Evaluate<SMackenzieKernel>(temp, salin, pressure, c, count, latitudeDeg);
+            break;
+        case eSoundSpeedEquation::WongZhu:
+        default:
+            Evaluate<SWongZhuKernel>(temp, salin, pressure, c, count, latitudeDeg);
+            break;
+    }
+    return;
+}
+
+};  // End namespace ssp
@@ -0,0 +1,195 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Features.cpp
+  * \brief  Summary acoustic features of casts (layer depths, sound channel, duct cutoff)
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/Features.h"
+#include <cmath>
+#include <limits>
+#include "Parallel.h"
+
+
+namespace ssp::features
+{
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    //! Depth where value crosses target between two samples
+    inline double Crossing(double d0, double v0, double d1, double v1, double target)
+    {
+        return (v1 == v0) ? d1 : d0 + (target - v0) / (v1 - v0) * (d1 - d0);
+    }
+
+
+    /*!
+     * \brief Accumulates every feature as samples are added in depth order
+     *
+     * Each feature only needs a few running values (extremes so far, the previous sample), so casts and
+     * table columns are both scanned once without copying.
+     */
+    class FeatureScan
+    {
+    public:
+        explicit FeatureScan(const SFeatureOptions& options) : options(options) {}
+
+        void Add(double depth, double c, double temp)
+        {
+            if (count == 0)
+            {
+                result.surfaceSpeed = c;
+                surfaceDepth = depth;
+                layerMax = c;
+                layerMaxDepth = depth;
+            }
+
+            // Sonic layer: the running maximum until the speed falls clearly below it
+            if (inLayer)
+            {
+                if (c > layerMax)
+                {
+                    layerMax = c;
+                    layerMaxDepth = depth;
+                }
+                else if (c < layerMax - options.speedTolerance)
+                    inLayer = false;
+            }
+
+            // Mixed layer: the reference is the first sample at or below the reference depth
+            hasTemp |= (temp != 0);
+            if (!haveRefTemp && depth >= options.referenceDepth)
+            {
+                refTemp = temp;
+                haveRefTemp = true;
+            }
+            else if (haveRefTemp && std::isnan(result.mixedLayerDepth) && std::abs(temp - refTemp) > options.temperatureThreshold)
+            {
+                const double target = refTemp + std::copysign(options.temperatureThreshold, temp - refTemp);
+                result.mixedLayerDepth = Crossing(prevDepth, prevTemp, depth, temp, target);
+            }
+
+            // Sound channel: a new minimum restarts the search for the critical depth (none for a minimum at the surface)
+            if (count == 0 || c < minSpeed)
+            {
+                minSpeed = c;
+                minDepth = depth;
+                maxAboveMin = std::max(maxSoFar, c);
+                result.criticalDepth = NaN;
+            }
+            else if (minDepth > surfaceDepth && std::isnan(result.criticalDepth) && c >= maxAboveMin)
+                result.criticalDepth = Crossing(prevDepth, prevSpeed, depth, c, maxAboveMin);
+
+            maxSoFar = (count == 0) ? c : std::max(maxSoFar, c);
+            prevDepth = depth;
+            prevSpeed = c;
+            prevTemp = temp;
+            ++count;
+        }
+
+        SAcousticFeatures Finish()
+        {
+            if (count == 0)
+                return result;
+
+            result.maxDepth = prevDepth;
+            if (!hasTemp)
+                result.mixedLayerDepth = NaN;
+            else if (haveRefTemp && std::isnan(result.mixedLayerDepth))
+                result.mixedLayerDepth = prevDepth;  // Mixed to the bottom of the cast
+
+            result.sonicLayerDepth = layerMaxDepth;
+            const double thickness = layerMaxDepth - surfaceDepth;
+            const double gradient = (thickness > 0) ? (layerMax - result.surfaceSpeed) / thickness : 0.0;
+            if (gradient > 0)
+            {
+                const double c0 = result.surfaceSpeed;
+                result.ductCutoffFrequency = 9.0 * c0 * std::sqrt(c0) / (16.0 * std::sqrt(2.0 * gradient) * thickness * std::sqrt(thickness));
+            }
+
+            if (minDepth < prevDepth && prevSpeed > minSpeed)
+            {
+                result.sofarDepth = minDepth;
+                result.sofarSpeed = minSpeed;
+            }
+            return result;
+        }
+
+    private:
+        const SFeatureOptions& options;
+        SAcousticFeatures result = { NaN, NaN, NaN, NaN, NaN, NaN, NaN, NaN };
+        size_t count = 0;
+
+        double prevDepth = 0, prevSpeed = 0, prevTemp = 0;
+        double surfaceDepth = 0;
+
+        bool inLayer = true;
+        double layerMax = 0, layerMaxDepth = 0;
+
+        bool hasTemp = false, haveRefTemp = false;
+        double refTemp = 0;
+
+        double maxSoFar = 0, minSpeed = 0, minDepth = 0, maxAboveMin = 0;
+    };
+};  // End namespace ssp::features
+
+
+namespace ssp
+{
+
+SAcousticFeatures ExtractFeatures(const SCast& cast, const SFeatureOptions& options)
+{
+    features::FeatureScan scan(options);
+    for (const auto& entry : cast.entries)
+        scan.Add(entry.depth, entry.c, entry.temp);
+    return scan.Finish();
+}
+
+
+std::vector<SAcousticFeatures> ExtractFeatures(const std::vector<SCast>& casts, const SFeatureOptions& options, unsigned int numThreads)
+{
+    std::vector<SAcousticFeatures> result(casts.size());
+    ParallelFor(casts.size(), numThreads, [&](size_t n)
+        {
+            result[n] = ExtractFeatures(casts[n], options);
+        });
+    return result;
+}
+
+
+std::vector<SAcousticFeatures> ExtractFeatures(const SCastTable& table, const SFeatureOptions& options, unsigned int numThreads)
+{
+    std::vector<SAcousticFeatures> result(table.NumCasts());
+    ParallelFor(table.NumCasts(), numThreads, [&](size_t n)
+        {
+            features::FeatureScan scan(options);
+            for (size_t k = table.offsets[n]; k < table.offsets[n + 1]; ++k)
+                scan.Add(table.depth[k], table.c[k], table.temp[k]);
+            result[n] = scan.Finish();
+        });
+    return result;
+}
+
+};  // End namespace ssp
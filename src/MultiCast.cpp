@@ -0,0 +1,176 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   MultiCast.cpp
+  * \brief  Reading of files that hold more than one cast
+  *
+  * Some formats (notably Hypack .vel files from moving vessel profiler runs) can contain thousands of
+  * casts, each starting with its own header line. The file is split on those headers and each section
+  * is parsed separately, so only a bounded number of sections is ever held in memory.
+  */
+
+#include "pch.h"
+#include <fstream>
+#include <functional>
+#include <SspCpp/SoundSpeed.h>
+#include "Parallel.h"
+#include "Readers/Asvp.h"
+#include "Readers/Hypack.h"
+
+
+namespace ssp::multicast
+{
+    //! Number of sections buffered per worker thread before they are parsed
+    constexpr size_t SectionsPerThread = 16;
+
+    //! Whether the line begins a new cast. Formats without a splitter return false for every line.
+    bool IsSectionHeader(eCastType type, const std::string& line)
+    {
+        switch (type)
+        {
+            case eCastType::Asvp:
+                return asvp::IsSectionHeader(line);
+            case eCastType::Hypack:
+                return hypack::IsSectionHeader(line);
+            default:
+                return false;
+        }
+    }
+
+    bool HasSections(eCastType type)
+    {
+        return type == eCastType::Asvp || type == eCastType::Hypack;
+    }
+
+    std::optional<SCast> ParseSection(eCastType type, const std::string& section, const std::string& fileName)
+    {
+        SCast cast;
+        bool ok = false;
+        switch (type)
+        {
+            case eCastType::Asvp:
+                ok = ParseAsvp(section, fileName, cast);
+                break;
+            case eCastType::Hypack:
+                ok = ParseHypack(section, fileName, cast);
+                break;
+            default:
+                break;
+        }
+
+        if (!ok)
+            return {};
+        return cast;
+    }
+
+    /*!
+     * \brief Parses the buffered sections and hands the casts to the callback in file order
+     * \returns false if the callback asked to stop
+     */
+    bool FlushSections(eCastType type, std::vector<std::string>& sections, const std::string& fileName,
+        const std::function<bool(SCast&)>& callback, unsigned int numThreads, size_t& numCasts)
+    {
+        std::vector<std::optional<SCast>> casts(sections.size());
+        ParallelFor(sections.size(), numThreads, [&](size_t n)
+        {
+            casts[n] = ParseSection(type, sections[n], fileName);
+        });
+        sections.clear();
+
+        for (auto& cast : casts)
+        {
+            if (!cast)
+                continue;  // The reader has already reported the problem
+            ++numCasts;
+            if (!callback(*cast))
+                return false;
+        }
+        return true;
+    }
+};  // End namespace ssp::multicast
+
+
+size_t ssp::ReadCastsFromFile(const std::string& fileName, eCastType type, const std::function<bool(SCast&)>& callback, unsigned int numThreads)
+{
+    if (type == eCastType::Unknown)
+        type = DetermineFileType(fileName);
+
+    // Formats that only ever hold a single cast go through the normal reader
+    if (!multicast::HasSections(type))
+    {
+        auto cast = ReadCast(fileName, type);
+        if (!cast)
+            return 0;
+        callback(*cast);
+        return 1;
+    }
+
+    std::ifstream inFile(fileName);
+    if (!inFile)
+    {
+        std::cout << "Could not open file " << fileName << "\n";
+        return 0;
+    }
+
+    numThreads = ResolveThreadCount(numThreads, ~size_t(0));
+    const size_t maxSections = numThreads * multicast::SectionsPerThread;
+
+    std::vector<std::string> sections;
+    sections.reserve(maxSections);
+    std::string line, current;
+    size_t numCasts = 0;
+
+    while (std::getline(inFile, line))
+    {
+        if (multicast::IsSectionHeader(type, line) && !current.empty())
+        {
+            sections.push_back(std::move(current));
+            current.clear();
+
+            if (sections.size() == maxSections)
+            {
+                if (!multicast::FlushSections(type, sections, fileName, callback, numThreads, numCasts))
+                    return numCasts;
+            }
+        }
+
+        current += line;
+        current += '\n';
+    }
+
+    if (!current.empty())
+        sections.push_back(std::move(current));
+    multicast::FlushSections(type, sections, fileName, callback, numThreads, numCasts);
+
+    return numCasts;
+}
+
+
+std::vector<ssp::SCast> ssp::ReadCastsFromFile(const std::string& fileName, eCastType type)
+{
+    std::vector<SCast> casts;
+    ReadCastsFromFile(fileName, type, [&casts](SCast& cast) { casts.push_back(std::move(cast)); return true; });
+    return casts;
+}
@@ -0,0 +1,81 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Parallel.h
+  * \brief  Minimal thread helpers for batch processing of casts.
+  */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ssp
+{
+    //! Number of worker threads to use when 0 (automatic) is requested
+    inline unsigned int ResolveThreadCount(unsigned int numThreads, size_t numItems)
+    {
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        if (numItems < numThreads)
+            numThreads = static_cast<unsigned int>(std::max<size_t>(1, numItems));
+        return numThreads;
+    }
+
+    /*!
+     * \brief Calls func(n) for every n in [0, count), spread across numThreads threads (0 = one per core)
+     *
+     * Items are handed out dynamically, so uneven per-item work (e.g., casts of very different lengths)
+     * still balances well. func must be safe to call concurrently for different n.
+     */
+    template <class Func>
+    void ParallelFor(size_t count, unsigned int numThreads, Func&& func)
+    {
+        numThreads = ResolveThreadCount(numThreads, count);
+        if (numThreads <= 1)
+        {
+            for (size_t n = 0; n < count; ++n)
+                func(n);
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]()
+        {
+            for (size_t n = next++; n < count; n = next++)
+                func(n);
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(numThreads - 1);
+        for (unsigned int t = 1; t < numThreads; ++t)
+            threads.emplace_back(worker);
+        worker();  // This thread does its share too
+        for (auto& thread : threads)
+            thread.join();
+    }
+};
@@ -0,0 +1,465 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   ParseCache.cpp
+  * \brief  Optional on-disk cache of parsed casts, used by ReadCast
+  *
+  * Each entry is one file named after the 64-bit FNV-1a hash of its key. It holds a fixed header, the
+  * description string and then the entries exactly as they are laid out in memory, so a hit is a memory
+  * map and a copy. Entries are written to a temporary file and renamed, so concurrent readers never see a
+  * partial entry. The modification time of an entry is updated on each hit and used for LRU eviction.
+  */
+
+#include "pch.h"
+#include "ParseCache.h"
+#include <SspCpp/ParseCache.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <type_traits>
+#include "MappedFile.h"
+#include "Scanner.h"
+
+#ifdef _WIN32
+    #include <process.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+
+namespace ssp::cache
+{
+    constexpr char Magic[8] = { 'S', 'S', 'P', 'C', 'A', 'S', 'T', '3' };  // Last digit changes with the SCastEntry layout
+    constexpr const char* Extension = ".sspc";
+
+    struct SEntryHeader
+    {
+        char magic[8];
+        uint32_t type;  //!< eCastType the source was read as
+        uint32_t numEntries;
+        uint64_t sourceSize;
+        int64_t sourceTime;  //!< Modification time (FileInfo keys only)
+        uint64_t contentHash;  //!< Hash of the source (ContentHash keys only)
+        int32_t time[9];  //!< std::tm fields, in declaration order
+        uint32_t descLength;
+        uint32_t reserved;
+        double lat;
+        double lon;
+    };
+    static_assert(sizeof(SEntryHeader) == 104, "Cache entry header must have a fixed layout");
+    static_assert(std::is_trivially_copyable<SCastEntry>::value, "Entries are stored as raw bytes");
+
+    //! Entries start at the next multiple of 8 bytes after the description
+    constexpr size_t EntriesOffset(size_t descLength)
+    {
+        return (sizeof(SEntryHeader) + descLength + 7) & ~size_t(7);
+    }
+
+
+    //! 64-bit FNV-1a, continuing from a previous hash
+    uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+    {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t n = 0; n < size; ++n)
+        {
+            hash ^= p[n];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+
+    struct SState
+    {
+        std::mutex mutex;  //!< Guards everything except the counters and enabled
+        std::atomic<bool> enabled{ false };
+        fs::path directory;
+        size_t maxBytes = 0;
+        eCacheKey key = eCacheKey::FileInfo;
+        size_t bytes = 0;
+
+        std::atomic<size_t> hits{ 0 };
+        std::atomic<size_t> misses{ 0 };
+        std::atomic<size_t> evictions{ 0 };
+    };
+
+    SState& State()
+    {
+        static SState state;
+        return state;
+    }
+
+
+    //! What identifies the source file, and what is checked against the stored entry
+    struct SSourceKey
+    {
+        uint64_t hash = 0;  //!< Hash of the key material, combined with the cast type to name the entry
+        uint64_t size = 0;
+        int64_t time = 0;
+        uint64_t contentHash = 0;
+    };
+
+
+    bool MakeKey(const std::string& fileName, eCacheKey keyType, SSourceKey& key)
+    {
+        std::error_code ec;
+        key.size = fs::file_size(fileName, ec);
+        if (ec)
+            return false;
+
+        if (keyType == eCacheKey::FileInfo)
+        {
+            auto writeTime = fs::last_write_time(fileName, ec);
+            if (ec)
+                return false;
+            key.time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+
+            const std::string path = fs::absolute(fileName, ec).string();
+            key.hash = Fnv1a(path.data(), path.size());
+            key.hash = Fnv1a(&key.size, sizeof(key.size), key.hash);
+            key.hash = Fnv1a(&key.time, sizeof(key.time), key.hash);
+        }
+        else
+        {
+            std::string contents;
+            if (!scan::ReadFile(fileName, contents))
+                return false;
+            key.contentHash = Fnv1a(contents.data(), contents.size());
+            key.hash = key.contentHash;
+        }
+
+        return true;
+    }
+
+
+    //! Cache file for a source read as a given type
+    fs::path EntryPath(const fs::path& directory, const SSourceKey& key, eCastType type)
+    {
+        const uint32_t typeValue = static_cast<uint32_t>(type);
+        const uint64_t hash = Fnv1a(&typeValue, sizeof(typeValue), key.hash);
+        return directory / (fmt::format("{:016x}", hash) + Extension);
+    }
+
+
+    //! Loads a cast from a cache entry if it exists and matches the source
+    bool Load(const fs::path& path, const SSourceKey& key, eCastType type, SCast& cast)
+    {
+        MappedFile file;
+        if (!file.Open(path.string()) || file.Size() < sizeof(SEntryHeader))
+            return false;
+
+        SEntryHeader header;
+        std::memcpy(&header, file.Data(), sizeof(header));
+        if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.type != static_cast<uint32_t>(type)
+            || header.sourceSize != key.size || header.sourceTime != key.time || header.contentHash != key.contentHash)
+            return false;
+
+        const size_t offset = EntriesOffset(header.descLength);
+        if (file.Size() < offset + size_t(header.numEntries) * sizeof(SCastEntry))
+            return false;
+
+        cast.desc.assign(file.Data() + sizeof(SEntryHeader), header.descLength);
+        cast.entries.resize(header.numEntries);
+        if (header.numEntries > 0)
+            std::memcpy(cast.entries.data(), file.Data() + offset, header.numEntries * sizeof(SCastEntry));
+
+        int* fields[9] = { &cast.time.tm_sec, &cast.time.tm_min, &cast.time.tm_hour, &cast.time.tm_mday,
+            &cast.time.tm_mon, &cast.time.tm_year, &cast.time.tm_wday, &cast.time.tm_yday, &cast.time.tm_isdst };
+        for (int n = 0; n < 9; ++n)
+            *fields[n] = header.time[n];
+        cast.lat = header.lat;
+        cast.lon = header.lon;
+
+        return true;
+    }
+
+
+    /*!
+     * \brief Name for a temporary file next to path that no other writer uses
+     *
+     * The process id keeps processes sharing a cache directory apart, and the counter keeps threads apart.
+     */
+    fs::path TempPath(const fs::path& path)
+    {
+        static std::atomic<uint64_t> counter{ 0 };
+#ifdef _WIN32
+        const long long pid = _getpid();
+#else
+        const long long pid = getpid();
+#endif
+        fs::path temp = path;
+        temp += fmt::format(".{}.{}.tmp", pid, counter.fetch_add(1, std::memory_order_relaxed));
+        return temp;
+    }
+
+
+    //! Writes an entry (through a temporary file) and returns its size, or 0 on failure
+    size_t Store(const fs::path& path, const SSourceKey& key, eCastType type, const SCast& cast)
+    {
+        SEntryHeader header = {};
+        std::memcpy(header.magic, Magic, sizeof(Magic));
+        header.type = static_cast<uint32_t>(type);
+        header.numEntries = static_cast<uint32_t>(cast.entries.size());
+        header.sourceSize = key.size;
+        header.sourceTime = key.time;
+        header.contentHash = key.contentHash;
+        const int fields[9] = { cast.time.tm_sec, cast.time.tm_min, cast.time.tm_hour, cast.time.tm_mday,
+            cast.time.tm_mon, cast.time.tm_year, cast.time.tm_wday, cast.time.tm_yday, cast.time.tm_isdst };
+        for (int n = 0; n < 9; ++n)
+            header.time[n] = fields[n];
+        header.descLength = static_cast<uint32_t>(cast.desc.size());
+        header.lat = cast.lat;
+        header.lon = cast.lon;
+
+        const size_t offset = EntriesOffset(cast.desc.size());
+        const size_t total = offset + cast.entries.size() * sizeof(SCastEntry);
+        std::string buffer(total, '\0');
+        std::memcpy(&buffer[0], &header, sizeof(header));
+        std::memcpy(&buffer[sizeof(header)], cast.desc.data(), cast.desc.size());
+        if (!cast.entries.empty())
+            std::memcpy(&buffer[offset], cast.entries.data(), cast.entries.size() * sizeof(SCastEntry));
+
+        const fs::path temp = TempPath(path);
+        std::error_code ec;
+        {
+            std::ofstream out(temp, std::ios::binary);
+            if (!out.write(buffer.data(), buffer.size()))
+            {
+                out.close();
+                fs::remove(temp, ec);
+                return 0;
+            }
+        }
+
+        fs::rename(temp, path, ec);
+        if (ec)
+        {
+            fs::remove(temp, ec);
+            return 0;
+        }
+        return total;
+    }
+
+
+    //! Total size of the entries in a directory
+    size_t DirectoryBytes(const fs::path& directory)
+    {
+        size_t bytes = 0;
+        std::error_code ec;
+        for (const auto& item : fs::directory_iterator(directory, ec))
+        {
+            if (item.path().extension() == Extension)
+                bytes += static_cast<size_t>(item.file_size(ec));
+        }
+        return bytes;
+    }
+
+
+    //! Removes the least recently used entries until the cache fits. Call with the state locked.
+    void Evict(SState& state)
+    {
+        struct SItem
+        {
+            fs::file_time_type time;
+            size_t size;
+            fs::path path;
+        };
+        std::vector<SItem> items;
+
+        std::error_code ec;
+        for (const auto& item : fs::directory_iterator(state.directory, ec))
+        {
+            if (item.path().extension() != Extension)
+                continue;
+            items.push_back({ item.last_write_time(ec), static_cast<size_t>(item.file_size(ec)), item.path() });
+        }
+        std::sort(begin(items), end(items), [](const SItem& a, const SItem& b) { return a.time < b.time; });
+
+        state.bytes = 0;
+        for (const auto& item : items)
+            state.bytes += item.size;
+
+        for (const auto& item : items)
+        {
+            if (state.bytes <= state.maxBytes)
+                break;
+            if (fs::remove(item.path, ec))
+            {
+                state.bytes -= item.size;
+                ++state.evictions;
+            }
+        }
+    }
+
+
+    bool IsEnabled()
+    {
+        return State().enabled;
+    }
+
+
+    std::optional<SCast> ReadThrough(const std::string& fileName, eCastType type, ParseFunc parse)
+    {
+        SState& state = State();
+        fs::path directory;
+        eCacheKey keyType;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            directory = state.directory;
+            keyType = state.key;
+        }
+
+        SSourceKey key;
+        if (!MakeKey(fileName, keyType, key))
+            return parse(fileName, type);  // The reader will report the problem
+
+        const fs::path path = EntryPath(directory, key, type);
+        SCast cast;
+        if (Load(path, key, type, cast))
+        {
+            ++state.hits;
+            cast.fileName = fileName;
+            std::error_code ec;
+            fs::last_write_time(path, fs::file_time_type::clock::now(), ec);  // Most recently used
+            return cast;
+        }
+
+        ++state.misses;
+        auto parsed = parse(fileName, type);
+        if (!parsed)
+            return parsed;
+
+        const size_t size = Store(path, key, type, *parsed);
+        if (size > 0)
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.bytes += size;
+            if (state.bytes > state.maxBytes)
+                Evict(state);
+        }
+
+        return parsed;
+    }
+};  // End namespace ssp::cache
+
+
+namespace ssp
+{
+
+bool EnableParseCache(const std::string& directory, size_t maxBytes, eCacheKey key)
+{
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (!fs::is_directory(directory, ec))
+    {
+        std::cout << "Could not create cache directory " << directory << "\n";
+        return false;
+    }
+
+    auto& state = cache::State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.directory = directory;
+    state.maxBytes = maxBytes;
+    state.key = key;
+    state.bytes = cache::DirectoryBytes(state.directory);
+    state.hits = state.misses = state.evictions = 0;
+    if (state.bytes > state.maxBytes)
+        cache::Evict(state);
+    state.enabled = true;
+
+    return true;
+}
+
+
+void DisableParseCache()
+{
+    cache::State().enabled = false;
+    return;
+}
+
+
+void InvalidateParseCache(const std::string& fileName)
+{
+    auto& state = cache::State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.directory.empty())
+        return;
+
+    cache::SSourceKey key;
+    if (!cache::MakeKey(fileName, state.key, key))
+        return;
+
+    // Entries are per cast type, so remove whichever types this file was read as
+    for (int type = 0; type < static_cast<int>(eCastType::Unknown); ++type)
+    {
+        std::error_code ec;
+        const fs::path path = cache::EntryPath(state.directory, key, static_cast<eCastType>(type));
+        const auto size = fs::file_size(path, ec);
+        if (!ec && fs::remove(path, ec))
+            state.bytes -= std::min(state.bytes, static_cast<size_t>(size));
+    }
+
+    return;
+}
+
+
+void ClearParseCache()
+{
+    auto& state = cache::State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.directory.empty())
+        return;
+
+    std::error_code ec;
+    for (const auto& item : fs::directory_iterator(state.directory, ec))
+    {
+        if (item.path().extension() == cache::Extension)
+            fs::remove(item.path(), ec);
+    }
+    state.bytes = 0;
+
+    return;
+}
+
+
+SParseCacheStats GetParseCacheStats()
+{
+    auto& state = cache::State();
+    SParseCacheStats stats;
+    stats.hits = state.hits;
+    stats.misses = state.misses;
+    stats.evictions = state.evictions;
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    stats.bytes = state.bytes;
+    return stats;
+}
+
+};  // End namespace ssp
@@ -30,6 +30,7 @@
 #include "pch.h"
 #include <SspCpp/SoundSpeed.h>
 #include <cmath>
+#include "EquationKernels.h"
 
 
 template <class T>
@@ -53,13 +54,17 @@ double Gravity(double latitudeDeg)
 
 double Depth(double pressureBar, double latitudeDeg)
 {
-    const double g = Gravity(latitudeDeg);
+    return equation::LeroyParthiotDepth(pressureBar, Gravity(latitudeDeg));
+}
 
-    double P = pressureBar * 0.1;  // Bars to MegaPascal
-    double Z = 9.72659e2 * P - 2.2512e-1 * P*P + 2.279e-4 * P*P*P - 1.82e-7 * P*P*P*P;
-    Z /= (g + 1.092e-4 * P);
 
-    return Z;
+void Depth(const double* pressureBar, double* depth, size_t count, double latitudeDeg)
+{
+    const double g = Gravity(latitudeDeg);
+
+    for (size_t n = 0; n < count; ++n)
+        depth[n] = equation::LeroyParthiotDepth(pressureBar[n], g);
+    return;
 }
 
 
@@ -79,6 +84,22 @@ double DepthToPressure(double depth, double latitudeDeg)
 }
 
 
+void DepthToPressure(const double* depth, double* pressure, size_t count, double latitudeDeg)
+{
+    // Same as the single value version, but gravity only has to be found once
+    const double g = Gravity(latitudeDeg);
+
+    for (size_t n = 0; n < count; ++n)
+    {
+        const double z = depth[n];
+        const double hZ45 = z * (1.00818e-2 + z * (2.465e-8 + z * (-1.25e-13 + z * 2.8e-19)));
+        const double k = (g - 2e-5 * z) / (9.80612 - 2e-5 * z);
+        pressure[n] = 10.0 * hZ45 * k;
+    }
+    return;
+}
+
+
 double PascalToBar(double pascals)
 {
     return 1e-5 * pascals;
@@ -155,4 +176,14 @@ double ConductivityToSalinity(double conductivitySm, double pressureDbar, double
     return S;
 }
 
+
+void ConductivityToSalinity(const double* conductivitySm, const double* pressureDbar, const double* tempC, double* salinity, size_t count)
+{
+    // Defined in this file, so the scalar version is inlined here rather than called for every sample. The
+    //  loop only vectorizes because this file is built with -fno-math-errno (see src/CMakeLists.txt).
+    for (size_t n = 0; n < count; ++n)
+        salinity[n] = ConductivityToSalinity(conductivitySm[n], pressureDbar[n], tempC[n]);
+    return;
+}
+
 };  // End namespace ssp
@@ -31,9 +31,183 @@
   */
 
 #include "pch.h"
+#include <SspCpp/Density.h>
 #include <SspCpp/LatLong.h>
 #include <SspCpp/ProcessChecks.h>
+#include <SspCpp/SoundSpeed.h>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include "Parallel.h"
+
+
+namespace ssp::qc
+{
+    /*!
+     * \brief k-th smallest (from 0) distance from the median, with the sorted window split at the median
+     *
+     * The distances below the median (read backwards) and above it are each sorted, so this is the k-th
+     * element of two merged sorted runs, found by binary search on how many come from the lower run.
+     */
+    double KthDeviation(const std::vector<double>& sorted, size_t mid, size_t k)
+    {
+        const double median = sorted[mid];
+        const size_t numBelow = mid, numAbove = sorted.size() - mid - 1;
+        const auto Below = [&](size_t i) { return median - sorted[mid - 1 - i]; };
+        const auto Above = [&](size_t j) { return sorted[mid + 1 + j] - median; };
+
+        // Take 'take' values from the two runs in total: i from below and take - i from above
+        const size_t take = k;  // The median itself is the 0th
+        if (take == 0)
+            return 0.0;
+        size_t lo = (take > numAbove) ? take - numAbove : 0;
+        size_t hi = std::min(take, numBelow);
+        for (;;)
+        {
+            const size_t i = lo + (hi - lo) / 2;
+            const size_t j = take - i;
+            if (i < numBelow && j > 0 && Above(j - 1) > Below(i))
+                lo = i + 1;
+            else if (i > 0 && j < numAbove && Below(i - 1) > Above(j))
+                hi = i - 1;
+            else
+            {
+                const double fromBelow = (i > 0) ? Below(i - 1) : 0.0;
+                const double fromAbove = (j > 0) ? Above(j - 1) : 0.0;
+                return std::max(fromBelow, fromAbove);
+            }
+        }
+    }
+
+
+    //! Per-sample inputs of one cast as columns, with pressure filled in from depth where missing
+    struct SColumns
+    {
+        const double* depth;
+        const double* c;
+        const double* temp;
+        const double* salinity;
+        const double* pressure;
+        size_t count;
+        double lat;
+    };
+
+
+    //! Runs every test on one cast, setting flags[0, count)
+    size_t CheckColumns(const SColumns& cols, const SQcOptions& options, uint32_t* flags)
+    {
+        thread_local std::vector<size_t> valid;
+        thread_local std::vector<double> values, median, mad;
+
+        valid.clear();
+        for (size_t n = 0; n < cols.count; ++n)
+        {
+            SCastEntry entry;
+            entry.depth = cols.depth[n];
+            entry.c = cols.c[n];
+            entry.temp = cols.temp[n];
+            entry.salinity = cols.salinity[n];
+            entry.pressure = cols.pressure[n];
+
+            // CheckLimits lets NaN through (every comparison is false), and NaN would never be a spike either
+            const bool finite = std::isfinite(entry.depth) && std::isfinite(entry.c) && std::isfinite(entry.temp) &&
+                std::isfinite(entry.salinity) && std::isfinite(entry.pressure);
+            if (finite && CheckLimits(entry))
+            {
+                flags[n] = 0;
+                valid.push_back(n);
+            }
+            else
+                flags[n] = QcLimits;
+        }
+
+        struct SChannel
+        {
+            const double* values;
+            uint32_t spikeFlag;
+            double minSpike;
+            double maxGradient;
+            bool present;
+        };
+        SChannel channels[] = {
+            { cols.c, QcSpeedSpike, options.minSpeedSpike, options.maxSpeedGradient, false },
+            { cols.temp, QcTempSpike, options.minTempSpike, options.maxTempGradient, false },
+            { cols.salinity, QcSalinitySpike, options.minSalinitySpike, options.maxSalinityGradient, false } };
+        for (auto& channel : channels)
+            channel.present = std::any_of(valid.begin(), valid.end(), [&](size_t n) { return channel.values[n] != 0; });
+
+        // Spikes against the rolling median of the valid samples
+        const size_t numValid = valid.size();
+        if (options.spikeThreshold > 0)
+        {
+            values.resize(numValid);
+            median.resize(numValid);
+            mad.resize(numValid);
+            for (const auto& channel : channels)
+            {
+                if (!channel.present)
+                    continue;
+                for (size_t k = 0; k < numValid; ++k)
+                    values[k] = channel.values[valid[k]];
+                RollingMedian(values.data(), numValid, options.window, median.data(), mad.data());
+                for (size_t k = 0; k < numValid; ++k)
+                {
+                    const double limit = std::max(options.spikeThreshold * 1.4826 * mad[k], channel.minSpike);
+                    if (std::abs(values[k] - median[k]) > limit)
+                        flags[valid[k]] |= channel.spikeFlag;
+                }
+            }
+        }
+
+        // Gradients and density inversions against the nearest sample above without a spike, so one spike
+        //  does not also flag the good sample below it
+        const bool hasDensity = channels[1].present && channels[2].present && options.densityInversion > 0;
+        size_t above = SIZE_MAX;
+        for (size_t k = 0; k < numValid; ++k)
+        {
+            const size_t n = valid[k];
+            if (flags[n] != 0)
+                continue;
+
+            if (above != SIZE_MAX)
+            {
+                const double dz = cols.depth[n] - cols.depth[above];
+                if (dz > 0)
+                {
+                    for (const auto& channel : channels)
+                    {
+                        if (channel.present && channel.maxGradient > 0 &&
+                            std::abs(channel.values[n] - channel.values[above]) > channel.maxGradient * dz)
+                            flags[n] |= QcGradient;
+                    }
+                }
+
+                if (hasDensity)
+                {
+                    const double p = 0.5 * (cols.pressure[n] + cols.pressure[above]);
+                    const double S0 = cols.salinity[above], S1 = cols.salinity[n];
+                    const double densityAbove = Density(PotentialTemperature(cols.temp[above], S0, cols.pressure[above], p), S0, p);
+                    const double density = Density(PotentialTemperature(cols.temp[n], S1, cols.pressure[n], p), S1, p);
+                    if (density < densityAbove - options.densityInversion)
+                        flags[n] |= QcDensityInversion;
+                }
+            }
+            above = n;
+        }
+
+        return static_cast<size_t>(std::count_if(flags, flags + cols.count, [](uint32_t f) { return f != 0; }));
+    }
+
+
+    //! Fills pressure from depth where it is missing
+    void FillPressure(const double* depth, const double* pressure, size_t count, double lat, std::vector<double>& out)
+    {
+        out.resize(count);
+        for (size_t n = 0; n < count; ++n)
+            out[n] = (pressure[n] != 0) ? pressure[n] : DepthToPressure(depth[n], lat);
+        return;
+    }
+};  // End namespace ssp::qc
 
 
 namespace ssp
@@ -182,4 +356,96 @@ bool Cleanup(SCast& cast)
     return true;
 }
 
+
+void RollingMedian(const double* values, size_t count, size_t window, double* median, double* mad)
+{
+    const size_t half = window / 2;
+    thread_local std::vector<double> sorted;
+    sorted.clear();
+    sorted.reserve(2 * half + 1);
+
+    size_t lo = 0, hi = 0;  // The window is values[lo, hi)
+    for (size_t n = 0; n < count; ++n)
+    {
+        // NaN is kept out of the window, since it cannot be ordered
+        for (const size_t end = std::min(count, n + half + 1); hi < end; ++hi)
+        {
+            if (!std::isnan(values[hi]))
+                sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), values[hi]), values[hi]);
+        }
+        for (const size_t begin = (n > half) ? n - half : 0; lo < begin; ++lo)
+        {
+            if (!std::isnan(values[lo]))
+                sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), values[lo]));
+        }
+
+        if (sorted.empty())
+        {
+            median[n] = mad[n] = std::numeric_limits<double>::quiet_NaN();
+            continue;
+        }
+        const size_t mid = (sorted.size() - 1) / 2;
+        median[n] = sorted[mid];
+        mad[n] = qc::KthDeviation(sorted, mid, mid);
+    }
+    return;
+}
+
+
+size_t QualityCheck(SCast& cast, const SQcOptions& options)
+{
+    const size_t count = cast.entries.size();
+    thread_local std::vector<double> columns[5], pressure;
+    thread_local std::vector<uint32_t> flags;
+    for (auto& column : columns)
+        column.resize(count);
+    for (size_t n = 0; n < count; ++n)
+    {
+        const auto& entry = cast.entries[n];
+        columns[0][n] = entry.depth;
+        columns[1][n] = entry.c;
+        columns[2][n] = entry.temp;
+        columns[3][n] = entry.salinity;
+        columns[4][n] = entry.pressure;
+    }
+    qc::FillPressure(columns[0].data(), columns[4].data(), count, cast.lat, pressure);
+
+    flags.resize(count);
+    const qc::SColumns cols = { columns[0].data(), columns[1].data(), columns[2].data(), columns[3].data(), pressure.data(), count, cast.lat };
+    const size_t numFlagged = qc::CheckColumns(cols, options, flags.data());
+    for (size_t n = 0; n < count; ++n)
+        cast.entries[n].flags = flags[n];
+    return numFlagged;
+}
+
+
+size_t QualityCheck(SCastTable& table, const SQcOptions& options, unsigned int numThreads)
+{
+    table.flags.resize(table.NumSamples());
+    std::vector<size_t> numFlagged(table.NumCasts());
+    ParallelFor(table.NumCasts(), numThreads, [&](size_t n)
+        {
+            const size_t first = table.offsets[n], count = table.offsets[n + 1] - first;
+            thread_local std::vector<double> pressure;
+            qc::FillPressure(table.depth.data() + first, table.pressure.data() + first, count, table.lats[n], pressure);
+            const qc::SColumns cols = { table.depth.data() + first, table.c.data() + first, table.temp.data() + first,
+                table.salinity.data() + first, pressure.data(), count, table.lats[n] };
+            numFlagged[n] = qc::CheckColumns(cols, options, table.flags.data() + first);
+        });
+
+    size_t total = 0;
+    for (size_t flagged : numFlagged)
+        total += flagged;
+    return total;
+}
+
+
+size_t RemoveFlagged(SCast& cast, uint32_t mask)
+{
+    const size_t before = cast.entries.size();
+    auto removeIter = std::remove_if(begin(cast.entries), end(cast.entries), [mask](SCastEntry& entry) { return (entry.flags & mask) != 0; });
+    cast.entries.erase(removeIter, end(cast.entries));
+    return before - cast.entries.size();
+}
+
 };  // End namespace ssp
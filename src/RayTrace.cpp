@@ -0,0 +1,177 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   RayTrace.cpp
+  * \brief  Ray tracing through a compiled (constant-gradient layer) profile
+  *
+  * With the ray parameter p = sin(beam angle) / c held constant (Snell's law), a ray through a layer with
+  * gradient g from speed c0 (angle b0) to c1 (angle b1) covers:
+  *   horizontal: (cos b0 - cos b1) / (p g)
+  *   time: ln(c1 (1 + cos b0) / (c0 (1 + cos b1))) / g
+  * Since c / (1 + cos b) = tan(b / 2) / p, the time equation can also be solved directly for the speed at
+  * which a given time runs out.
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/RayTrace.h"
+#include <cmath>
+#include <limits>
+
+
+namespace ssp::ray
+{
+    //! Part of the profile with a constant gradient, from the ray's current depth down to bottom
+    struct SSegment
+    {
+        double bottom;
+        double gradient;
+        size_t next;  //!< Layer index where the following segment starts
+    };
+
+    /*!
+     * \brief Segment starting at depth, where layer is the layer holding depth
+     *
+     * Above the cast is one segment with no gradient, and so is everything below it.
+     */
+    inline SSegment Segment(const SCompiledProfile& profile, double depth, size_t layer)
+    {
+        if (depth < profile.MinDepth())
+            return { profile.MinDepth(), 0.0, 0 };
+        if (layer >= profile.layers.size() || depth >= profile.MaxDepth())
+            return { std::numeric_limits<double>::infinity(), 0.0, profile.layers.size() };
+        return { profile.layers[layer].bottom, profile.layers[layer].gradient, layer + 1 };
+    }
+
+    constexpr double quarterPi = 0.78539816339744831;
+
+    //! Whether the speed changes so little over dz that the layer is treated as having no gradient
+    inline bool Flat(double gradient, double dz, double c)
+    {
+        return gradient == 0 || std::fabs(gradient * dz) < 1e-9 * c;
+    }
+
+    /*!
+     * \brief Traces down to targetDepth or until targetTime is reached, whichever is first
+     * \returns false if the ray turns back up first
+     */
+    bool Trace(const SCompiledProfile& profile, double startDepth, double beamAngleDeg, double targetDepth, double targetTime,
+        SRayPoint& point)
+    {
+        const double angle = beamAngleDeg * 0.017453292519943295;
+        double c = profile.SoundSpeed(startDepth);
+        const double p = std::sin(angle) / c;
+
+        point = { startDepth, 0.0, 0.0 };
+        size_t layer = profile.Layer(startDepth);
+        while (point.depth < targetDepth && point.time < targetTime)
+        {
+            const SSegment segment = Segment(profile, point.depth, layer);
+            const double g = segment.gradient;
+            const double sin0 = p * c;
+            const double cos0 = std::sqrt(1.0 - sin0 * sin0);
+
+            // Whole segment (or up to the target depth)
+            const double dz = std::min(segment.bottom, targetDepth) - point.depth;
+            const double c1 = (g != 0) ? c + g * dz : c;  // dz is infinite below the cast
+            const double sin1 = p * c1;
+            if (sin1 >= 1.0)
+                return false;
+            const double cos1 = std::sqrt(1.0 - sin1 * sin1);
+
+            double dx, dt;
+            if (Flat(g, dz, c))
+            {
+                dx = dz * sin0 / cos0;
+                dt = dz / (c * cos0);
+            }
+            else
+            {
+                dx = (p > 0) ? (cos0 - cos1) / (p * g) : 0.0;
+                dt = std::log(c1 * (1.0 + cos0) / (c * (1.0 + cos1))) / g;
+            }
+
+            if (point.time + dt > targetTime)
+            {
+                // Time runs out in this segment
+                const double remaining = targetTime - point.time;
+                if (Flat(g, remaining * c, c))
+                {
+                    const double dzPart = remaining * c * cos0;
+                    point.depth += dzPart;
+                    point.horizontal += dzPart * sin0 / cos0;
+                }
+                else
+                {
+                    double cEnd, cosEnd;
+                    if (p > 0)
+                    {
+                        const double halfAngle = std::atan(p * c / (1.0 + cos0) * std::exp(g * remaining));
+                        if (halfAngle >= quarterPi)
+                            return false;  // Beam angle would pass 90 degrees, so it turned
+                        cEnd = std::sin(2.0 * halfAngle) / p;
+                        cosEnd = std::cos(2.0 * halfAngle);
+                        point.horizontal += (cos0 - cosEnd) / (p * g);
+                    }
+                    else
+                        cEnd = c * std::exp(g * remaining);
+                    point.depth += (cEnd - c) / g;
+                }
+                point.time = targetTime;
+                return true;
+            }
+
+            point.depth += dz;
+            point.horizontal += dx;
+            point.time += dt;
+            c = c1;
+            layer = segment.next;
+        }
+
+        return true;
+    }
+};  // End namespace ssp::ray
+
+
+namespace ssp
+{
+
+std::optional<SRayPoint> TraceRayToDepth(const SCompiledProfile& profile, double startDepth, double beamAngleDeg, double depth)
+{
+    SRayPoint point;
+    if (!ray::Trace(profile, startDepth, beamAngleDeg, depth, std::numeric_limits<double>::infinity(), point))
+        return {};
+    return point;
+}
+
+
+std::optional<SRayPoint> TraceRayForTime(const SCompiledProfile& profile, double startDepth, double beamAngleDeg, double oneWayTime)
+{
+    SRayPoint point;
+    if (!ray::Trace(profile, startDepth, beamAngleDeg, std::numeric_limits<double>::infinity(), oneWayTime, point))
+        return {};
+    return point;
+}
+
+};  // End namespace ssp
@@ -24,182 +24,151 @@
 
  /*!
   * \file   Aoml.cpp
-  * \brief  
+  * \brief  Reader for AOML AMVER-SEAS XBT casts
+  *
+  * The header is made of "Name | Value" lines and ends with a line of '=' characters. The data is
+  * either depth or elapsed time (converted to depth with the probe's fall-rate equation) and temperature.
   */
 
 #include "pch.h"
 #include "Aoml.h"
-#include <fstream>
-#include <regex>
 #include <fmt/format.h>
 #include <SspCpp/SoundSpeed.h>
-#include "StringUtilities.h"
+#include <SspCpp/Xbt.h>
+#include "CastTypes.h"
+#include "Scanner.h"
 #include "TimeStruct.h"
 
 
 namespace ssp::aoml
 {
+    //! Date/time header fields. Seconds are not always present.
+    struct SDateFields
+    {
+        int year = -1, month = -1, day = -1, hour = -1, minute = -1, second = 0;
+    };
+
     //! Gets everything past the vertical bar character on each header line. Usually has one space after the bar.
-    std::string GetLineValue(std::string line)
+    std::string_view GetLineValue(std::string_view line)
     {
-        std::regex rgx("\\|\\s*(.*)");
-        std::smatch match;
-        std::regex_search(line, match, rgx);
-        if (match.size() != 2)
+        auto bar = line.find('|');
+        if (bar == std::string_view::npos)
         {
             std::cout << "Could not parse line\n";
-            return "";
+            return {};
         }
 
-        return match[1];
+        return scan::Trim(line.substr(bar + 1));
     }
 
-    bool ParseLatitude(std::string line, ssp::SCast& cast)
+    //! Parses an integer header value, returning false if it is missing or not a number
+    bool GetLineInt(std::string_view line, int& value)
     {
-        auto strings = SplitString(line);
-        if (strings.size() != 3)
-        {
-            std::cout << "Latitude string incorrect\n";
-            return false;
-        }
-
-        try
-        {
-            double deg = std::stod(strings[0]);
-            double minSec = std::stod(strings[1]);  // Minutes plus fractional minutes (e.g., 11.01)
-            auto dir = strings[2];  // N or S
-            cast.lat = deg + minSec / 60;
-            if (dir != "N" && dir != "S")
-            {
-                std::cout << "Invalid latitude direction\n";
-                return false;
-            }
-            if (dir == "S")
-                cast.lat = -cast.lat;
-        }
-        catch (std::invalid_argument)
-        {
-            std::cout << "Invalid latitude string\n";
-            return false;
-        }
-
-        return true;
+        std::string_view str = GetLineValue(line);
+        const char* p = str.data();
+        return scan::ParseInt(p, p + str.size(), value);
     }
 
-    bool ParseLongitude(std::string line, ssp::SCast& cast)
+    /*!
+     * \brief Parses "degrees minutes direction", where minutes may have a fraction (e.g., 11.01)
+     * \param negative Direction letter for southern/western values
+     */
+    bool ParseCoordinate(std::string_view str, char positive, char negative, double& value)
     {
-        auto strings = SplitString(line);
-        if (strings.size() != 3)
-        {
-            std::cout << "Longitude string incorrect\n";
+        const char* p = str.data();
+        const char* end = p + str.size();
+        double deg, minSec;
+        std::string_view dir;
+        if (!scan::ParseDouble(p, end, deg) || !scan::ParseDouble(p, end, minSec) || !scan::NextField(p, end, dir)
+            || !scan::AtLineEnd(p, end))
             return false;
-        }
-
-        try
-        {
-            double deg = std::stod(strings[0]);
-            double minSec = std::stod(strings[1]);  // Minutes plus fractional minutes (e.g., 11.01)
-            auto dir = strings[2];  // W or E
-            cast.lon = deg + minSec / 60;
-            if (dir != "W" && dir != "E")
-            {
-                std::cout << "Invalid longitude direction\n";
-                return false;
-            }
-            if (dir == "W")
-                cast.lon = -cast.lon;
-        }
-        catch (std::invalid_argument)
-        {
-            std::cout << "Invalid longitude string\n";
+        if (dir.size() != 1 || (dir[0] != positive && dir[0] != negative))
             return false;
-        }
 
+        value = deg + minSec / 60;
+        if (dir[0] == negative)
+            value = -value;
         return true;
     }
 
-    void SetDate(std::string dateStr, ssp::SCast& cast)
+    bool SetDate(const SDateFields& date, std::tm& time)
     {
+        if (date.year < 0 || date.month < 1 || date.month > 12 || date.day < 1 || date.day > 31 || date.hour < 0 || date.minute < 0)
+            return false;
 
-        return;
+        time = CreateTime(date.year, date.month, date.day, date.hour, date.minute, date.second);
+        return true;
     }
 }
 
 using namespace ssp::aoml;
 
 
-std::optional<ssp::SCast> ssp::ReadAoml(const std::string& fileName)
+std::optional<ssp::SCast> ssp::ReadAoml(const std::string& fileName, eSoundSpeedEquation equation)
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
     {
         std::cout << "Could not open file " << fileName << "\n";
         return {};
     }
 
     SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
-    std::string line, dateStr;
+    if (!ParseAoml(contents, fileName, cast, equation))
+        return {};
+    return cast;
+}
+
+
+template <class Cast>
+bool ssp::ParseAoml(std::string_view contents, const std::string& fileName, Cast& cast, eSoundSpeedEquation equation)
+{
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+    std::string_view line;
+    SDateFields date;
+    eXbtProbe probe = eXbtProbe::Unknown;
     bool bLatSet = false, bLongSet = false;
 
-    while (!inFile.eof())
+    while (scan::GetLine(p, end, line))  // Header
     {
-        if (!std::getline(inFile, line))  // Header
-            break;
         if (line.size() == 0)
             break;
 
-        if (StartsWith(line, "Latitude"))
+        if (scan::StartsWith(line, "Latitude"))
         {
-            auto latVal = GetLineValue(line);
-            if (latVal.size() == 0)
+            if (!ParseCoordinate(GetLineValue(line), 'N', 'S', cast.lat))
             {
                 std::cout << fmt::format("Could not parse latitude line for {}\n", fileName);
-                return {};
-            }
-            if (!ParseLatitude(latVal, cast))
-            {
-                return {};
+                return false;
             }
             bLatSet = true;
         }
-        else if (StartsWith(line, "Longitude"))
+        else if (scan::StartsWith(line, "Longitude"))
         {
-            auto lonVal = GetLineValue(line);
-            if (lonVal.size() == 0)
+            if (!ParseCoordinate(GetLineValue(line), 'E', 'W', cast.lon))
             {
                 std::cout << fmt::format("Could not parse longitude line for {}\n", fileName);
-                return {};
-            }
-            if (!ParseLongitude(lonVal, cast))
-            {
-                return {};
+                return false;
             }
             bLongSet = true;
         }
-        // The following date/time fields look to always be in this order
-        else if (StartsWith(line, "Year"))
-        {
-            dateStr += GetLineValue(line) + " ";
-        }
-        else if (StartsWith(line, "Month"))
-        {
-            dateStr += GetLineValue(line) + " ";
-        }
-        else if (StartsWith(line, "Day"))
-        {
-            dateStr += GetLineValue(line) + " ";
-        }
-        else if (StartsWith(line, "Hour"))
-        {
-            dateStr += GetLineValue(line) + " ";
-        }
-        else if (StartsWith(line, "Minute"))
-        {
-            dateStr += GetLineValue(line);
-        }
-
-        else if (StartsWith(line, "===="))
+        else if (scan::StartsWith(line, "Year"))
+            GetLineInt(line, date.year);
+        else if (scan::StartsWith(line, "Month"))
+            GetLineInt(line, date.month);
+        else if (scan::StartsWith(line, "Day"))
+            GetLineInt(line, date.day);
+        else if (scan::StartsWith(line, "Hour"))
+            GetLineInt(line, date.hour);
+        else if (scan::StartsWith(line, "Minute"))
+            GetLineInt(line, date.minute);
+        else if (scan::StartsWith(line, "Second"))
+            GetLineInt(line, date.second);
+        else if (scan::StartsWith(line, "Probe Type"))
+            probe = XbtProbeFromName(std::string(GetLineValue(line)));
+
+        else if (scan::StartsWith(line, "===="))
         {
             break;  // End of header
         }
@@ -207,51 +176,68 @@ std::optional<ssp::SCast> ssp::ReadAoml(const std::string& fileName)
 
     if (!bLatSet || !bLongSet)
         std::cout << fmt::format("Warning: Missing lat/lon data in {}\n", fileName);
-    SetDate(dateStr, cast);
-
-    if (!std::getline(inFile, line))  // Unused
-        return {};
-    if (!std::getline(inFile, line))
-        return {};
-    auto desc = SplitString(line);
-    // The example files I have only have depth and temperature
-    if (desc.size() != 2 || desc[0] != "Depth" || desc[1] != "Temperature")
+    if (!SetDate(date, cast.time))
+        std::cout << fmt::format("Warning: Missing or invalid date/time in {}\n", fileName);
+
+    if (!scan::GetLine(p, end, line))  // Unused
+        return false;
+    if (!scan::GetLine(p, end, line))
+        return false;
+
+    // The example files only have depth and temperature, but raw XBT data has the time since launch instead
+    std::string_view xName, yName;
+    const char* d = line.data();
+    const char* dEnd = d + line.size();
+    if (!scan::NextField(d, dEnd, xName) || !scan::NextField(d, dEnd, yName) || !scan::AtLineEnd(d, dEnd)
+        || (xName != "Depth" && xName != "Time") || yName != "Temperature")
     {
         std::cout << fmt::format("Invalid data types for {}\n", fileName);
-        return {};
+        return false;
     }
-
-    // Now read in the data
-    while (!inFile.eof())
+    const bool bElapsedTime = (xName == "Time");
+
+    // Now read in the data as columns
+    const auto alloc = cast.entries.get_allocator();
+    const size_t maxCount = scan::CountLines(p, end);
+    CastVector<Cast, double> depth(alloc), temp(alloc);
+    depth.reserve(maxCount);
+    temp.reserve(maxCount);
+    while (scan::GetLine(p, end, line))
     {
-        double salinity = 35;  // Assuming 35 ppt salinity, since not measured
-        if (!std::getline(inFile, line))
+        const char* l = line.data();
+        const char* lEnd = l + line.size();
+        double first, second;
+        if (!scan::ParseDouble(l, lEnd, first) || !scan::ParseDouble(l, lEnd, second) || !scan::AtLineEnd(l, lEnd))
             break;
 
-        auto data = SplitString(line);
-        if (data.size() != 2)
-            break;
+        depth.push_back(first);
+        temp.push_back(second);
+    }
 
-        try
-        {
-            SCastEntry entry;
-            entry.depth = std::stod(data[0]);
-            entry.temp = std::stod(data[1]);
+    if (bElapsedTime)
+        XbtDepth(depth.data(), depth.data(), depth.size(), probe);
 
-            entry.pressure = DepthToPressure(entry.depth, cast.lat);
-            entry.c = WongZhu(entry.temp, salinity, entry.pressure);
+    // Assuming 35 ppt salinity, since not measured
+    const size_t count = depth.size();
+    CastVector<Cast, double> salinity(count, 35.0, alloc), pressure(count, 0.0, alloc), c(count, 0.0, alloc);
+    DepthToPressure(depth.data(), pressure.data(), count, cast.lat);
+    SoundSpeed(equation, temp.data(), salinity.data(), pressure.data(), c.data(), count, cast.lat);
 
-            cast.entries.push_back(entry);
-        }
-        catch (std::invalid_argument)
-        {
-            break;
-        }
+    cast.entries.resize(count);
+    for (size_t n = 0; n < count; ++n)
+    {
+        SCastEntry& entry = cast.entries[n];
+        entry.depth = depth[n];
+        entry.temp = temp[n];
+        entry.pressure = pressure[n];
+        entry.c = c[n];
     }
 
-
     cast.desc = "AOML AMVER-SEAS XBT (.txt)";
-    cast.fileName = fileName;
+    AssignString(cast.fileName, fileName);
 
-    return cast;
+    return true;
 }
+
+template bool ssp::ParseAoml(std::string_view, const std::string&, SCast&, eSoundSpeedEquation);
+template bool ssp::ParseAoml(std::string_view, const std::string&, pmr::SCast&, eSoundSpeedEquation);
@@ -29,97 +29,128 @@
 
 #include "pch.h"
 #include "Asvp.h"
-#include <fstream>
 #include <fmt/format.h>
-#include "StringUtilities.h"
+#include "CastTypes.h"
+#include "Scanner.h"
 #include "TimeStruct.h"
 
 
+namespace ssp::asvp
+{
+    //! Parses an integer from a fixed-width part of a field
+    bool ParseDigits(std::string_view str, size_t pos, size_t len, int& value)
+    {
+        const char* p = str.data() + pos;
+        auto result = std::from_chars(p, p + len, value);
+        return result.ec == std::errc() && result.ptr == p + len;
+    }
+
+    //! Converts the %Y%m%d%H%M or %Y%m%d%H%M%S header time
+    bool ParseTime(std::string_view timeStr, std::tm& time)
+    {
+        if (timeStr.size() != 12 && timeStr.size() != 14)
+            return false;
+
+        int year, month, day, hour, minute, second = 0;
+        if (!ParseDigits(timeStr, 0, 4, year) || !ParseDigits(timeStr, 4, 2, month) || !ParseDigits(timeStr, 6, 2, day)
+            || !ParseDigits(timeStr, 8, 2, hour) || !ParseDigits(timeStr, 10, 2, minute))
+            return false;
+        if (timeStr.size() == 14 && !ParseDigits(timeStr, 12, 2, second))
+            return false;
+
+        time = CreateTime(year, month, day, hour, minute, second);
+        return true;
+    }
+};  // End namespace ssp::asvp
+
+
+bool ssp::asvp::IsSectionHeader(std::string_view line)
+{
+    // Header lines look like "( SoundVelocity  1.0 0 201203212242 ..."
+    return line.size() > 0 && line[0] == '(' && line.find("SoundVelocity") != std::string_view::npos;
+}
+
+
 std::optional<ssp::SCast> ssp::ReadAsvp(const std::string& fileName)
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
     {
         std::cout << "Could not open file " << fileName << "\n";
         return {};
     }
 
     SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
-    std::string line, dateLine, timeLine;
+    if (!ParseAsvp(contents, fileName, cast))
+        return {};
+    return cast;
+}
+
+
+template <class Cast>
+bool ssp::ParseAsvp(std::string_view contents, const std::string& fileName, Cast& cast)
+{
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+    std::string_view line;
 
     try
     {
-        if (!std::getline(inFile, line))  // Header
+        if (!scan::GetLine(p, end, line))  // Header
             throw "Line read failure";
 
-        auto headVec = SplitString(line);
-        if (headVec.size() < 7)
-            throw "Could not parse header";
-        if (headVec[1] != "SoundVelocity")
+        // "( SoundVelocity  1.0 0 201203212242 lat lon ..."
+        std::string_view fields[7];
+        const char* h = line.data();
+        const char* hEnd = h + line.size();
+        for (auto& field : fields)
+        {
+            if (!scan::NextField(h, hEnd, field))
+                throw "Could not parse header";
+        }
+        if (fields[1] != "SoundVelocity")
             throw "Wrong type of data";
 
         /// @todo: Move header parsing into a separate function
 
-        try
-        {
-            // Convert date/time string
-            std::string timeStr = headVec[4];
-            if (timeStr.size() == 12 || timeStr.size() == 14)
-            {
-                // %Y%m%d%H%M or %Y%m%d%H%M%S
-                int year   = std::stoi(timeStr.substr(0, 4));
-                int month  = std::stoi(timeStr.substr(4, 2));
-                int day    = std::stoi(timeStr.substr(6, 2));
-                int hour   = std::stoi(timeStr.substr(8, 2));
-                int minute = std::stoi(timeStr.substr(10, 2));
-                int second = 0;
-                if (timeStr.size() == 14)
-                    second = std::stoi(timeStr.substr(12, 2));
-
-                cast.time = CreateTime(year, month, day, hour, minute, second);
-            }
-            else
-            {
-                throw "Header time invalid format";
-            }
-
-            // Convert latitude/longitutde strings
-            std::string latStr = headVec[5];
-            std::string lonStr = headVec[6];
-            cast.lat = std::stod(latStr);
-            cast.lon = std::stod(lonStr);
-        }
-        catch (std::invalid_argument)
-        {
+        if (!asvp::ParseTime(fields[4], cast.time))
+            throw "Header time invalid format";
+        if (!scan::ToDouble(fields[5], cast.lat) || !scan::ToDouble(fields[6], cast.lon))
             throw "Invalid latitude/longitude strings";
-        }
 
-        while (std::getline(inFile, line))
+        cast.entries.reserve(scan::CountLines(p, end));
+        while (p < end)
         {
-            if (line.size() == 0)
-                break;
+            const char* lineStart = p;
+            if (scan::AtLineEnd(p, end))
+                break;  // A blank line ends the cast
 
             // The depth and sound speed are required fields...
-            std::stringstream ss(line);
             SCastEntry entry;
-            ss >> entry.depth >> entry.c;
-            if (ss.fail())
-                throw fmt::format("Incomplete entry for line #{}", entries.size() + 2);
+            if (!scan::ParseDouble(p, end, entry.depth) || !scan::ParseDouble(p, end, entry.c))
+                throw fmt::format("Incomplete entry for line #{}", cast.entries.size() + 2);
 
-            entries.push_back(entry);
+            cast.entries.push_back(entry);
+            p = lineStart;
+            scan::NextLine(p, end);
         }
     }
     catch (std::string err)
     {
         std::cout << "Error reading Kongsberg Maritime file (" << fileName << "): " << err << "\n";
-        return {};
+        return false;
+    }
+    catch (const char* err)
+    {
+        std::cout << "Error reading Kongsberg Maritime file (" << fileName << "): " << err << "\n";
+        return false;
     }
 
-    //cast.lat = 0;
-    //cast.lon = 0;
     cast.desc = "Kongsberg Maritime (.asvp)";
-    cast.fileName = fileName;
+    AssignString(cast.fileName, fileName);
 
-    return cast;
+    return true;
 }
+
+template bool ssp::ParseAsvp(std::string_view, const std::string&, SCast&);
+template bool ssp::ParseAsvp(std::string_view, const std::string&, pmr::SCast&);
@@ -31,9 +31,24 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <SspCpp/Cast.h>
 
 namespace ssp
 {
     std::optional<SCast> ReadAsvp(const std::string& fileName);
+
+    /*!
+     * \brief Parses a single cast (header line and its samples) from text in memory
+     *
+     * Instantiated for SCast and pmr::SCast.
+     */
+    template <class Cast>
+    bool ParseAsvp(std::string_view contents, const std::string& fileName, Cast& cast);
+
+    namespace asvp
+    {
+        //! Whether the line starts a new cast in a file with several concatenated profiles
+        bool IsSectionHeader(std::string_view line);
+    };
 };
@@ -29,88 +29,120 @@
 
 #include "pch.h"
 #include "Hypack.h"
-#include <date/date.h>
 #include <SspCpp/SoundSpeed.h>
+#include "CastTypes.h"
+#include "Scanner.h"
 #include "TimeStruct.h"
 
 
 namespace ssp::hypack
 {
-    bool ParseHeader(std::string line, ssp::SCast& cast)
+    //! Checks for (and skips) a separator character
+    bool Expect(const char*& p, const char* end, char c)
     {
-        std::stringstream ss(line);
+        if (p >= end || *p != c)
+            return false;
+        ++p;
+        return true;
+    }
+
+    template <class Cast>
+    bool ParseHeader(std::string_view line, Cast& cast)
+    {
+        const char* p = line.data();
+        const char* end = p + line.size();
 
         // First 3 entries are "FTP NEW 3" in example files
-        std::string pos1, pos2, pos3;
-        ss >> pos1 >> pos2 >> pos3;
-        if (!ss)
-            return false;
-        
-        ss >> cast.lat >> cast.lon;
-        if (!ss)
-            return false;
+        for (int n = 0; n < 3; ++n)
+        {
+            if (!scan::SkipField(p, end))
+                return false;
+        }
 
-        // The remainder of the string has the time and date
-        std::string datetime;
-        if (!std::getline(ss, datetime))
+        if (!scan::ParseDouble(p, end, cast.lat) || !scan::ParseDouble(p, end, cast.lon))
             return false;
 
-        std::istringstream in(datetime);
-        date::sys_seconds tp;
-        // In format: hh:mm month/day/year. Note that there's a space at the beginning,
-        //  since the string remaining will be of the form " 15:47 08/19/2019".
-        in >> date::parse(" %H:%M %m/%d/%Y", tp);
-        if (!in)
+        // The remainder of the string has the time and date, in format: hh:mm month/day/year
+        int hour, minute, month, day, year;
+        if (!scan::ParseInt(p, end, hour) || !Expect(p, end, ':') || !scan::ParseInt(p, end, minute))
+            return false;
+        if (!scan::ParseInt(p, end, month) || !Expect(p, end, '/') || !scan::ParseInt(p, end, day)
+            || !Expect(p, end, '/') || !scan::ParseInt(p, end, year))
             return false;  // Error parsing date/time string
-
-        if (!CreateTime(tp, cast.time))
+        if (month < 1 || month > 12 || day < 1 || day > 31 || hour < 0 || hour > 23 || minute < 0 || minute > 59)
             return false;
 
+        cast.time = CreateTime(year, month, day, hour, minute, 0);
         return true;
     }
 
+
+    bool IsSectionHeader(std::string_view line)
+    {
+        return line.compare(0, 3, "FTP") == 0;
+    }
+
 };  // End namespace ssp::hypack
 
 
 std::optional<ssp::SCast> ssp::ReadHypack(const std::string& fileName)
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
     {
         std::cout << "Could not open file " << fileName << "\n";
         return {};
     }
 
     SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
-    std::string line, headerStr;
+    if (!ParseHypack(contents, fileName, cast))
+        return {};
+    return cast;
+}
+
+
+template <class Cast>
+bool ssp::ParseHypack(std::string_view contents, const std::string& fileName, Cast& cast)
+{
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+    std::string_view line;
 
-    if (!std::getline(inFile, line))
+    if (!scan::GetLine(p, end, line))
     {
         std::cout << "Could not read " << fileName << "\n";
-        return {};
+        return false;
     }
 
     if (!hypack::ParseHeader(line, cast))
     {
         std::cout << "Could not parse header for " << fileName << "\n";
-        return {};
+        return false;
     }
 
-    // Read in and parse the sound speed data
-    while (!inFile.eof())
+    // Read in and parse the sound speed data. This stops at the "FTP" header of the next cast (if any).
+    cast.entries.reserve(scan::CountLines(p, end));
+    while (p < end)
     {
-        SCastEntry entry;
+        if (scan::AtLineEnd(p, end))
+        {
+            scan::NextLine(p, end);  // Blank line
+            continue;
+        }
 
-        inFile >> entry.depth >> entry.c;
-        if (!inFile)
+        SCastEntry entry;
+        if (!scan::ParseDouble(p, end, entry.depth) || !scan::ParseDouble(p, end, entry.c))
             break;
 
-        entries.push_back(entry);
+        cast.entries.push_back(entry);
+        scan::NextLine(p, end);
     }
 
     cast.desc = "Hypack (.vel)";
-    cast.fileName = fileName;
+    AssignString(cast.fileName, fileName);
 
-    return cast;
+    return true;
 }
+
+template bool ssp::ParseHypack(std::string_view, const std::string&, SCast&);
+template bool ssp::ParseHypack(std::string_view, const std::string&, pmr::SCast&);
@@ -31,9 +31,24 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <SspCpp/Cast.h>
 
 namespace ssp
 {
     std::optional<SCast> ReadHypack(const std::string& fileName);
+
+    /*!
+     * \brief Parses a single cast (one "FTP" header and its samples) from text in memory, stopping at the next header
+     *
+     * Instantiated for SCast and pmr::SCast.
+     */
+    template <class Cast>
+    bool ParseHypack(std::string_view contents, const std::string& fileName, Cast& cast);
+
+    namespace hypack
+    {
+        //! Whether the line starts a new cast in a multi-cast .vel file
+        bool IsSectionHeader(std::string_view line);
+    };
 };
@@ -24,89 +24,296 @@
 
  /*!
   * \file   Oceanscience.cpp
-  * \brief  
+  * \brief  Reader for Oceanscience UnderwaySV casts
+  *
+  * Comment lines start with '*' and may hold "name: value" pairs with the cast date/time and position.
+  * The data lines have the sample number, conductivity, temperature and pressure (decibars). The file is
+  * read into columns first, and the derived values are then computed for the whole cast at once.
   */
 
 #include "pch.h"
 #include "Oceanscience.h"
-#include <date/date.h>
+#include <cctype>
 #include <SspCpp/SoundSpeed.h>
 #include <SspCpp/LatLong.h>
+#include "CastTypes.h"
+#include "Scanner.h"
+#include "StringUtilities.h"
 #include "TimeStruct.h"
 
 
-std::optional<ssp::SCast> ssp::ReadOceanscience(const std::string& fileName)
+namespace ssp::oceanscience
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    //! Pulls all of the unsigned numbers out of a string (e.g., "2021-09-21 14:03:12" gives 6 values)
+    std::vector<double> GetNumbers(const std::string& str, std::vector<int>* numDigits = nullptr)
     {
-        std::cout << "Could not open file " << fileName << "\n";
-        return {};
+        std::vector<double> numbers;
+        const char* p = str.data();
+        const char* end = p + str.size();
+        while (p < end)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(*p)))
+            {
+                ++p;
+                continue;
+            }
+            const char* start = p;
+            double value;
+            if (!scan::ParseDouble(p, end, value))
+                break;
+            numbers.push_back(value);
+            if (numDigits)
+                numDigits->push_back(static_cast<int>(p - start));
+        }
+        return numbers;
     }
 
-    SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
-    std::string line;
-    int lineNum = 0;
 
-    std::optional<double> lat, lon;
+    //! Characters between the parts of a coordinate ("43 07.2", "43:07.2" or 43°07'12", with ° in UTF-8 or Latin-1)
+    inline bool IsCoordinateSeparator(char c)
+    {
+        const unsigned char u = static_cast<unsigned char>(c);
+        return scan::IsSpace(c) || c == ':' || c == '\'' || c == '"' || u == 0xC2 || u == 0xB0 || u == 0xBA;
+    }
+
 
-    // Read in and parse the sound speed data
-    while (!inFile.eof() && std::getline(inFile, line))
+    //! Reads a hemisphere letter standing on its own (so the W of "WGS84" is not one)
+    bool ParseHemisphere(const char*& p, const char* end, bool& bNegative)
     {
-        ++lineNum;
+        if (p >= end)
+            return false;
+        const char c = static_cast<char>(std::toupper(static_cast<unsigned char>(*p)));
+        if (c != 'N' && c != 'S' && c != 'E' && c != 'W')
+            return false;
+        if (p + 1 < end && std::isalnum(static_cast<unsigned char>(p[1])))
+            return false;
+        bNegative = (c == 'S' || c == 'W');
+        ++p;
+        return true;
+    }
 
-        // Blank lines and comment lines (starting with *) currently just ignored
-        if (line.size() == 0)
-            continue;
-        if (line[0] == '*')
+
+    /*!
+     * \brief Parses a latitude or longitude value
+     *
+     * Accepts decimal degrees ("-43.12"), degrees and decimal minutes ("43 07.2 S") or degrees, minutes and seconds.
+     * A '-' right before the number or an S/W hemisphere letter before or after it gives a negative value.
+     * Anything after the coordinate (e.g., "(WGS84)") is ignored.
+     */
+    bool ParseCoordinate(const std::string& str, double& value)
+    {
+        const char* p = str.data();
+        const char* end = p + str.size();
+
+        bool bNegative = false;
+        p = scan::SkipSpace(p, end);
+        const bool bHemisphere = ParseHemisphere(p, end, bNegative);  // "S 43 07.2"
+        p = scan::SkipSpace(p, end);
+        if (!bHemisphere && p < end && (*p == '-' || *p == '+'))
         {
-            std::cout << "Need to check for date/time and lat/lon\n";
-            continue;
+            bNegative = (*p == '-');
+            ++p;
+        }
+
+        // Degrees, then optional minutes and seconds
+        double parts[3] = { 0, 0, 0 };
+        size_t numParts = 0;
+        while (numParts < 3 && p < end && std::isdigit(static_cast<unsigned char>(*p)))
+        {
+            if (!scan::ParseDouble(p, end, parts[numParts]))
+                break;
+            ++numParts;
+            while (p < end && IsCoordinateSeparator(*p))
+                ++p;
         }
+        if (numParts == 0)
+            return false;
+
+        if (!bHemisphere)
+            ParseHemisphere(p, end, bNegative);  // "43 07.2 S"
+
+        value = parts[0] + parts[1] / 60.0 + parts[2] / 3600.0;
+        if (bNegative)
+            value = -value;
+        return true;
+    }
 
 
-        if (!lat || !lon)
+    //! Date and time parts found in the header (either can be on its own line or together)
+    struct SHeaderTime
+    {
+        int year = -1, month = -1, day = -1;
+        int hour = -1, minute = -1, second = 0;
+    };
+
+
+    //! Parses "yyyy-mm-dd hh:mm:ss" (or with '/' separators, or mm/dd/yyyy). Either part may be missing.
+    void ParseDateTime(const std::string& str, SHeaderTime& time)
+    {
+        std::vector<int> numDigits;
+        auto numbers = GetNumbers(str, &numDigits);
+        size_t pos = 0;
+
+        if (numbers.size() >= 3 && (numDigits[0] == 4 || numDigits[2] == 4))
+        {
+            if (numDigits[0] == 4)  // Year first
+            {
+                time.year = static_cast<int>(numbers[0]);
+                time.month = static_cast<int>(numbers[1]);
+                time.day = static_cast<int>(numbers[2]);
+            }
+            else  // US style, month/day/year
+            {
+                time.month = static_cast<int>(numbers[0]);
+                time.day = static_cast<int>(numbers[1]);
+                time.year = static_cast<int>(numbers[2]);
+            }
+            pos = 3;
+        }
+
+        if (numbers.size() >= pos + 2)
         {
-            lat = 0;  lon = 0;  // Assuming latitude/longitude of 0/0 if not specified
+            time.hour = static_cast<int>(numbers[pos]);
+            time.minute = static_cast<int>(numbers[pos + 1]);
+            if (numbers.size() >= pos + 3)
+                time.second = static_cast<int>(numbers[pos + 2]);
         }
+    }
+
+
+    //! Looks at a '*' comment line for the date/time and position
+    void ParseHeaderLine(const std::string& line, double& lat, double& lon, SHeaderTime& time, bool& bLatSet, bool& bLonSet)
+    {
+        auto sep = line.find_first_of(":=");
+        if (sep == std::string::npos)
+            return;
 
-        std::stringstream ss(line);
-        int n;  // Entry number 
-        double cond, temp, pres;  // Conductivity, temperature, pressure
-        ss >> n >> cond >> temp >> pres;
-        if (!ss)
+        std::string key = Lowercase(trim(line.substr(1, sep - 1)));
+        std::string value = trim(line.substr(sep + 1));
+
+        // Whole key names only, so "Elapsed time" or "Calibration date" are not taken for the cast time. Units after
+        //  the name ("Latitude (deg)") are allowed.
+        const auto unitPos = key.find_first_of("([");
+        if (unitPos != std::string::npos)
+            key = trim(key.substr(0, unitPos));
+
+        if (key == "lat" || key == "latitude")
+            bLatSet = ParseCoordinate(value, lat);
+        else if (key == "lon" || key == "long" || key == "longitude")
+            bLonSet = ParseCoordinate(value, lon);
+        else if (key == "date" || key == "time" || key == "date/time" || key == "datetime" || key == "date time" ||
+            key == "cast date" || key == "cast time" || key == "start time")
+            ParseDateTime(value, time);
+    }
+};  // End namespace ssp::oceanscience
+
+
+std::optional<ssp::SCast> ssp::ReadOceanscience(const std::string& fileName, eSoundSpeedEquation equation)
+{
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
+    {
+        std::cout << "Could not open file " << fileName << "\n";
+        return {};
+    }
+
+    SCast cast;
+    if (!ParseOceanscience(contents, fileName, cast, equation))
+        return {};
+    return cast;
+}
+
+
+template <class Cast>
+bool ssp::ParseOceanscience(std::string_view contents, const std::string& fileName, Cast& cast, eSoundSpeedEquation equation)
+{
+    oceanscience::SHeaderTime time;
+    bool bLatSet = false, bLonSet = false;
+
+    // Conductivity, temperature and pressure (decibars) columns
+    const auto alloc = cast.entries.get_allocator();
+    const size_t maxCount = scan::CountLines(contents.data(), contents.data() + contents.size());
+    CastVector<Cast, double> cond(alloc), temp(alloc), pres(alloc);
+    cond.reserve(maxCount);
+    temp.reserve(maxCount);
+    pres.reserve(maxCount);
+
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+    std::string_view line;
+    int lineNum = 0;
+
+    // Single pass over the file: header lines can appear anywhere, data lines go into the columns
+    while (scan::GetLine(p, end, line))
+    {
+        ++lineNum;
+
+        const char* q = scan::SkipSpace(line.data(), line.data() + line.size());
+        const char* lineEnd = line.data() + line.size();
+        if (q == lineEnd)
+            continue;  // Blank line
+        if (*q == '*')
         {
-            fmt::print("Issue reading line {} of {}", lineNum, fileName);
-            return {};
+            oceanscience::ParseHeaderLine(std::string(q, lineEnd), cast.lat, cast.lon, time, bLatSet, bLonSet);
+            continue;
         }
 
-        if (cond < 0 || temp < -2 || pres < 0)
+        int n;  // Entry number
+        double c, t, pr;  // Conductivity, temperature, pressure
+        if (!scan::ParseInt(q, lineEnd, n) || !scan::ParseDouble(q, lineEnd, c) || !scan::ParseDouble(q, lineEnd, t) ||
+            !scan::ParseDouble(q, lineEnd, pr))
         {
-            fmt::print("Invalid parameter on line {} of {}", lineNum, fileName);
-            return {};
+            fmt::print("Issue reading line {} of {}\n", lineNum, fileName);
+            return false;
         }
 
-        double salinity = ConductivityToSalinity(cond, pres, temp);
-        if (salinity < 0)
+        if (c < 0 || t < -2 || pr < 0)
         {
-            fmt::print("Invalid conductivity on line {} of {}", lineNum, fileName);
-            return {};
+            fmt::print("Invalid parameter on line {} of {}\n", lineNum, fileName);
+            return false;
         }
 
-        pres /= 10;  // Convert to bars
-        double c = WongZhu(temp, salinity, pres);
+        cond.push_back(c);
+        temp.push_back(t);
+        pres.push_back(pr);
+    }
+
+    if (!bLatSet || !bLonSet)
+        fmt::print("Warning: Missing lat/lon data in {} (assuming 0/0)\n", fileName);
+    if (time.year > 0 && time.hour >= 0)
+        cast.time = CreateTime(time.year, time.month, time.day, time.hour, time.minute, time.second);
 
-        SCastEntry entry;
-        entry.c = c;
-        entry.depth = Depth(pres, *lat);
-        entry.pressure = pres;
+    // Derived values for the whole cast
+    const size_t count = cond.size();
+    CastVector<Cast, double> salinity(count, 0.0, alloc), depth(count, 0.0, alloc), c(count, 0.0, alloc);
+    ConductivityToSalinity(cond.data(), pres.data(), temp.data(), salinity.data(), count);
+    for (auto& pr : pres)
+        pr /= 10;  // Convert to bars
+    Depth(pres.data(), depth.data(), count, cast.lat);
+    SoundSpeed(equation, temp.data(), salinity.data(), pres.data(), c.data(), count, cast.lat);
+
+    cast.entries.resize(count);
+    for (size_t n = 0; n < count; ++n)
+    {
+        if (salinity[n] < 0)
+        {
+            fmt::print("Invalid conductivity for entry {} of {}\n", n + 1, fileName);
+            return false;
+        }
 
-        entries.push_back(entry);
+        SCastEntry& entry = cast.entries[n];
+        entry.c = c[n];
+        entry.depth = depth[n];
+        entry.pressure = pres[n];
+        entry.temp = temp[n];
+        entry.salinity = salinity[n];
     }
 
     cast.desc = "Oceanscience (.asc)";
-    cast.fileName = fileName;
+    AssignString(cast.fileName, fileName);
 
-    return cast;
+    return true;
 }
+
+template bool ssp::ParseOceanscience(std::string_view, const std::string&, SCast&, eSoundSpeedEquation);
+template bool ssp::ParseOceanscience(std::string_view, const std::string&, pmr::SCast&, eSoundSpeedEquation);
@@ -24,15 +24,21 @@
 
  /*!
   * \file   SeaAndSun.cpp
-  * \brief
+  * \brief  Reader for Sea&Sun Technology (.tob) files
+  *
+  * The "Datasets" and units header lines are turned into a column schema once. The data lines are then
+  * scanned a single time, converting each needed channel to the units used by SCastEntry as it is read.
+  * Only pressure (or depth) is required. Sound speed and salinity are computed if their channels are missing.
   */
 
 #include "pch.h"
 #include "SeaAndSun.h"
 #include <array>
-#include <fstream>
+#include <cctype>
 #include <regex>
 #include "SspCpp/SoundSpeed.h"
+#include "../CastTypes.h"
+#include "../Scanner.h"
 #include "../StringUtilities.h"
 #include "../TimeStruct.h"
 
@@ -57,10 +63,10 @@ namespace internal
     }
 
 
-    bool ParseDateTime(const std::string& line, SCast& cast)
+    bool ParseDateTime(const std::string& line, std::tm& time)
     {
         // Example date/time line: "Freitag, 20. Juli 2018 16:54:38"
-        std::regex rgxDateTime("[a-zA-Z]+[,] ([0-9]+)[.] ([a-zA-Z]+) ([0-9]+) ([0-9]+):([0-9]+):([0-9]+)");
+        static const std::regex rgxDateTime("[a-zA-Z]+[,] ([0-9]+)[.] ([a-zA-Z]+) ([0-9]+) ([0-9]+):([0-9]+):([0-9]+)");
         std::smatch match;
         std::regex_search(line, match, rgxDateTime);
         if (match.size() != 7)
@@ -71,16 +77,15 @@ namespace internal
             return false;
         std::string month = std::to_string(monthNum);
 
-        if (!CreateTime(match[3], month, match[1], match[4], match[5], match[6], cast.time))
+        if (!CreateTime(match[3], month, match[1], match[4], match[5], match[6], time))
             return false;
 
         return true;
     }
 
 
-    bool ParseLatLon(const std::string& line, SCast& cast)
+    bool ParseLatLon(const std::string& line, double& lat, double& lon)
     {
-        std::stringstream ss(line);
         auto headVec = SplitString(line);
         if (headVec.size() < 10)
             return false;
@@ -101,19 +106,19 @@ namespace internal
         {
             // Convert the separate parts from degrees and minutes (plus fraction of minutes) into
             //  single latitude/longitude values
-            cast.lat = (double)std::stoi(lat1);
-            cast.lat += std::stod(lat2) / 60.0;
-            cast.lon = (double)std::stoi(lon1);
-            cast.lon += std::stod(lon2) / 60.0;
+            lat = (double)std::stoi(lat1);
+            lat += std::stod(lat2) / 60.0;
+            lon = (double)std::stoi(lon1);
+            lon += std::stod(lon2) / 60.0;
 
             if (NS != "N" && NS != "S")
                 return false;
             if (EW != "E" && EW != "W")
                 return false;
             if (NS == "S")
-                cast.lat = -cast.lat;
+                lat = -lat;
             if (EW == "W")
-                cast.lon = -cast.lon;
+                lon = -lon;
         }
         catch (std::invalid_argument)
         {
@@ -121,68 +126,301 @@ namespace internal
         }
         return true;
     }
+
+
+    //! Channels that are used from the file
+    enum eChannel
+    {
+        ChanPressure,
+        ChanDepth,
+        ChanTemp,
+        ChanCond,
+        ChanSalinity,
+        ChanSound,
+        NumChannels
+    };
+
+
+    /*!
+     * \brief Where each channel is in a data line and how to convert it
+     *
+     * The converted value is raw * scale + offset, giving bars, meters, degrees Celsius, Siemens/meter,
+     * parts per thousand and meters/second.
+     */
+    struct SColumnSchema
+    {
+        SColumnSchema() { column.fill(-1); scale.fill(1.0); offset.fill(0.0); }
+        bool Has(eChannel channel) const { return column[channel] != -1; }
+
+        int numColumns = 0;
+        std::array<int, NumChannels> column;
+        std::array<double, NumChannels> scale;
+        std::array<double, NumChannels> offset;
+    };
+
+
+    //! Matches a "Datasets" name (e.g., "Press", "SALIN", "SOUND") to a channel. Returns NumChannels if unused.
+    eChannel ChannelFromName(const std::string& name)
+    {
+        std::string n = Lowercase(name);
+        if (StartsWith(n, "press"))
+            return ChanPressure;
+        if (StartsWith(n, "depth"))
+            return ChanDepth;
+        if (StartsWith(n, "temp"))
+            return ChanTemp;
+        if (StartsWith(n, "cond"))
+            return ChanCond;
+        if (StartsWith(n, "salin"))
+            return ChanSalinity;
+        if (StartsWith(n, "sound") || n == "sv" || n == "sos")
+            return ChanSound;
+        return NumChannels;
+    }
+
+
+    //! Unit Sea & Sun instruments use for a channel, for files whose units line leaves it out
+    const char* DefaultUnit(eChannel channel)
+    {
+        switch (channel)
+        {
+            case ChanPressure:  return "dbar";
+            case ChanDepth:     return "m";
+            case ChanTemp:      return "degC";
+            case ChanCond:      return "mS/cm";
+            case ChanSalinity:  return "ppt";
+            case ChanSound:     return "m/s";
+            default:            return "";
+        }
+    }
+
+
+    //! Temperature scale letter ('c', 'f' or 'k') from "degC", "°C", "deg F", "K", etc. Returns 0 if it is not one of these.
+    char TemperatureScale(const std::string& unit)
+    {
+        // Drop the degree sign (in whatever encoding), "deg" and spaces, leaving just the letter
+        std::string letters;
+        for (char c : unit)
+        {
+            if (static_cast<unsigned char>(c) < 0x80 && !std::isspace(static_cast<unsigned char>(c)))
+                letters += c;
+        }
+        if (StartsWith(letters, "deg"))
+            letters.erase(0, 3);
+        if (letters == "c" || letters == "f" || letters == "k")
+            return letters[0];
+        return 0;
+    }
+
+
+    //! Sets the conversion to canonical units. Returns false if the unit is not known for the channel.
+    bool SetUnits(eChannel channel, const std::string& unitIn, SColumnSchema& schema)
+    {
+        std::string unit = Lowercase(unitIn);
+        double& scale = schema.scale[channel];
+        double& offset = schema.offset[channel];
+
+        switch (channel)
+        {
+            case ChanPressure:
+                if (unit == "dbar")
+                    scale = 0.1;
+                else if (unit == "bar")
+                    scale = 1.0;
+                else if (unit == "kpa")
+                    scale = 0.01;
+                else if (unit == "mpa")
+                    scale = 10.0;
+                else if (unit == "psi")
+                    scale = 0.0689475729;
+                else
+                    return false;
+                return true;
+
+            case ChanDepth:
+                if (unit == "m")
+                    scale = 1.0;
+                else if (unit == "ft")
+                    scale = 0.3048;
+                else
+                    return false;
+                return true;
+
+            case ChanTemp:
+                // Different versions of their files can have either degC or °C (in whatever encoding)
+                switch (TemperatureScale(unit))
+                {
+                    case 'c':
+                        return true;
+                    case 'k':
+                        offset = -273.15;
+                        return true;
+                    case 'f':
+                        scale = 5.0 / 9.0;
+                        offset = -32.0 * 5.0 / 9.0;
+                        return true;
+                    default:
+                        return false;
+                }
+
+            case ChanCond:
+                if (unit == "ms/cm")
+                    scale = 0.1;
+                else if (unit == "s/m")
+                    scale = 1.0;
+                else if (unit == "us/cm" || unit == "µs/cm")
+                    scale = 1e-4;
+                else if (unit == "ms/m")
+                    scale = 1e-3;
+                else
+                    return false;
+                return true;
+
+            case ChanSalinity:
+                return unit == "ppt" || unit == "psu" || unit == "_" || unit == "";
+
+            case ChanSound:
+                if (unit == "m/s")
+                    scale = 1.0;
+                else if (unit == "ft/s")
+                    scale = 0.3048;
+                else
+                    return false;
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+
+    /*!
+     * \brief Builds the schema from the "Datasets" line and the units line below it
+     *
+     * Example lines:
+     *  "; Datasets  Press    Temp    Cond   SALIN   SIGMA   SOUND"
+     *  ";         [ dbar]  [ degC]  [mS/cm]  [  ppt]  [kg/m3]  [  m/s]"
+     */
+    bool BuildSchema(const std::string& datasetLine, const std::string& unitsLine, SColumnSchema& schema, std::string& err)
+    {
+        auto dataSetVec = SplitString(datasetLine);
+        if (dataSetVec.size() < 3 || dataSetVec[1] != "Datasets")
+        {
+            err = "Data sets not specified";
+            return false;
+        }
+        dataSetVec.erase(begin(dataSetVec), begin(dataSetVec) + 2);
+        schema.numColumns = static_cast<int>(dataSetVec.size());
+
+        // Units are each in brackets and can have any amount of padding
+        std::vector<std::string> units;
+        size_t pos = 0;
+        while ((pos = unitsLine.find('[', pos)) != std::string::npos)
+        {
+            size_t close = unitsLine.find(']', pos);
+            if (close == std::string::npos)
+                break;
+            units.push_back(trim(unitsLine.substr(pos + 1, close - pos - 1)));
+            pos = close + 1;
+        }
+
+        for (int n = 0; n < schema.numColumns; ++n)
+        {
+            eChannel channel = ChannelFromName(dataSetVec[n]);
+            if (channel == NumChannels || schema.Has(channel))
+                continue;  // Not used (or a repeat of a channel we already have)
+
+            std::string unit;
+            if (n < static_cast<int>(units.size()))
+                unit = units[n];
+            else
+            {
+                // A scale of 1 would read dbar as bar, so take the instrument's usual unit and say so
+                unit = DefaultUnit(channel);
+                fmt::print("No units given for {}, assuming {}\n", dataSetVec[n], unit);
+            }
+            if (!SetUnits(channel, unit, schema))
+            {
+                err = fmt::format("Unknown units \"{}\" for {}", unit, dataSetVec[n]);
+                return false;
+            }
+            schema.column[channel] = n;
+        }
+
+        if (!schema.Has(ChanPressure) && !schema.Has(ChanDepth))
+        {
+            err = "File has neither pressure nor depth";
+            return false;
+        }
+        if (!schema.Has(ChanSound) && !schema.Has(ChanTemp))
+        {
+            err = "File has neither sound speed nor temperature";
+            return false;
+        }
+
+        return true;
+    }
 };
 
 
-std::optional<SCast> ReadSeaAndSun(const std::string& fileName)
+std::optional<SCast> ReadSeaAndSun(const std::string& fileName, eSoundSpeedEquation equation)
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
     {
         std::cout << "Could not open file " << fileName << "\n";
         return {};
     }
 
     SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
-    std::string line, dateLine, timeLine;
+    if (!ParseSeaAndSun(contents, fileName, cast, equation))
+        return {};
+    return cast;
+}
+
+
+template <class Cast>
+bool ParseSeaAndSun(std::string_view contents, const std::string& fileName, Cast& cast, eSoundSpeedEquation equation)
+{
+    auto& entries = cast.entries;
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+    std::string_view lineView;
 
     int lineNum = 0;
-    int numDataLines;
+    int numDataLines = 0;
 
     try
     {
         std::string line;
         bool bFound = false;
 
-        /// @todo: Read lines for time, lat/lon
-
-        while (std::getline(inFile, line))
+        while (scan::GetLine(p, end, lineView))
         {
             lineNum++;
+            line.assign(lineView);
 
             if (lineNum == 3)
             {
-                if (!internal::ParseDateTime(line, cast))
-                    throw std::string("Could not parse date/time line");
+                if (!internal::ParseDateTime(line, cast.time))
+                    std::cout << "Warning: Could not parse date/time line in " << fileName << "\n";
             }
 
+            std::string trimmed = ltrim(line);
+
             // Lat/lon information
-            if (line.length() < 12)
-                throw std::string("Could not parse lat/lon line");
-            if (line.compare(0, 12, "  Position :") == 0)
+            if (StartsWith(trimmed, "Position :"))
             {
-                if (!internal::ParseLatLon(line, cast))
+                if (!internal::ParseLatLon(line, cast.lat, cast.lon))
                     throw std::string("Could not parse lat/lon line");
             }
 
             // Number of SSP entries in the file
-            if (line.length() < 7)
-                throw "Could not parse lat/lon line";
-            if (line.compare(0, 7, "Lines :") == 0)  // Line starts with "Lines :"
+            if (StartsWith(trimmed, "Lines :"))
             {
-                std::stringstream ss(line);
-                std::string s1, s2, numLinesStr;
-                ss >> s1 >> s2 >> numLinesStr;
-
-                try
-                {
-                    numDataLines = std::stoi(numLinesStr);
-                }
-                catch (std::invalid_argument)
-                {
+                const char* q = trimmed.data() + 7;
+                if (!scan::ParseInt(q, trimmed.data() + trimmed.size(), numDataLines) || numDataLines < 0)
                     throw std::string("Invalid number of entries string");
-                }
 
                 bFound = true;
                 break;
@@ -192,98 +430,138 @@ std::optional<SCast> ReadSeaAndSun(const std::string& fileName)
         if (!bFound)
             throw std::string("Missing number of entries line");
 
-        std::getline(inFile, line);  // Skip - only has a ';'
-
-        std::getline(inFile, line);
-        auto dataSetVec = SplitString(line);
-
-        if (dataSetVec[1] != "Datasets")
+        std::string datasetLine, unitsLine;
+        scan::GetLine(p, end, lineView);  // Skip - only has a ';'
+        if (!scan::GetLine(p, end, lineView))
             throw std::string("Data sets not specified");
-        dataSetVec.erase(begin(dataSetVec), begin(dataSetVec)+2);
+        datasetLine.assign(lineView);
+        if (!scan::GetLine(p, end, lineView))
+            throw std::string("Units not specified");
+        unitsLine.assign(lineView);
+        scan::GetLine(p, end, lineView);  // Skip - only has a ';'
+        lineNum += 4;  // Read 4 lines in the meantime
 
-        int speedPos = -1, pressPos = -1, tempPos = -1, salinPos = -1, condPos = -1, sigmaPos = -1;
-        for (int n = 0; n < static_cast<int>(dataSetVec.size()); ++n)
+        internal::SColumnSchema schema;
+        std::string err;
+        if (!internal::BuildSchema(datasetLine, unitsLine, schema, err))
+            throw err;
+
+        // Read the data lines, keeping only the (converted) values we use
+        using namespace internal;
+        const auto alloc = cast.entries.get_allocator();
+        std::array<CastVector<Cast, double>, NumChannels> columns = { CastVector<Cast, double>(alloc),
+            CastVector<Cast, double>(alloc), CastVector<Cast, double>(alloc), CastVector<Cast, double>(alloc),
+            CastVector<Cast, double>(alloc), CastVector<Cast, double>(alloc) };
+        static_assert(NumChannels == 6, "Update the column initialization");
+        for (int ch = 0; ch < NumChannels; ++ch)
         {
-            if (dataSetVec[n] == "Press")
-                pressPos = n;
-            if (dataSetVec[n] == "Temp")
-                tempPos = n;
-            if (dataSetVec[n] == "Cond")
-                condPos = n;
-            if (dataSetVec[n] == "SALIN")
-                salinPos = n;
-            if (dataSetVec[n] == "SIGMA")
-                sigmaPos = n;
-            if (dataSetVec[n] == "SOUND")
-                speedPos = n;
+            if (schema.Has(static_cast<eChannel>(ch)))
+                columns[ch].reserve(numDataLines);
         }
 
-        // Can have 0 or multiple spaces at the beginning
-        // Example line: "[ dbar]  [ degC]  [mS/cm]  [  ppt]  [kg/m3]  [  m/s]  [    _]"
-        std::regex rgxUnits(R"(\[ *?([a-zA-Z0-9/_]+)\])");
-        std::smatch match;
-        std::vector<std::string> units;
-        std::getline(inFile, line);
-        while (std::regex_search(line, match, rgxUnits))
+        // Which channel (if any) each column in the file goes to
+        std::vector<int> columnChannel(schema.numColumns, -1);
+        for (int ch = 0; ch < NumChannels; ++ch)
         {
-            // Different versions of their files can have either degC or °C
-            std::string unit = (match[1] != "degC") ? match[1].str() : "°C";
-            units.push_back(unit);
-
-            // Move past the found string to continue searching
-            line = match.suffix();
+            if (schema.column[ch] != -1)
+                columnChannel[schema.column[ch]] = ch;
         }
 
-        std::getline(inFile, line);  // Skip - only has a ';'
-        lineNum += 4;  // Read 4 lines in the meantime
-
-        while (std::getline(inFile, line))
+        while (p < end)
         {
             lineNum++;
-            SCastEntry entry;
-
-            auto entryVec = SplitString(line);
-            entryVec.erase(begin(entryVec));  // Each line has an extra entry with the index number
-            if (entryVec.size() != dataSetVec.size())
+            const char* lineEnd = scan::LineEnd(p, end);
+            if (scan::AtLineEnd(p, lineEnd))
             {
-                throw fmt::format("Incomplete line #{}", lineNum);
+                p = (lineEnd < end) ? lineEnd + 1 : end;
+                continue;  // Blank line (usually at the end of the file)
             }
 
-            try
+            // Each line has an extra entry with the index number at the start
+            if (!scan::SkipField(p, lineEnd))
+                throw fmt::format("Incomplete line #{}", lineNum);
+
+            // Unused columns can hold non-numbers (e.g., dates), so they are only split off, not converted
+            for (int n = 0; n < schema.numColumns; ++n)
             {
-                entry.c = std::stod(entryVec[speedPos]);
-                entry.temp = std::stod(entryVec[tempPos]);
-                entry.salinity = std::stod(entryVec[salinPos]);
-                entry.pressure = std::stod(entryVec[pressPos]) / 10;  // decibar to bar
-
-                // The depth has to be calculated
-                double sigma = std::stod(entryVec[sigmaPos]);
-                double density = 1000 + sigma;  // https://en.wikipedia.org/wiki/Sigma-t
-                entry.depth = Depth(entry.pressure, cast.lat);
+                std::string_view field;
+                if (!scan::NextField(p, lineEnd, field))
+                    throw fmt::format("Incomplete line #{}", lineNum);
+
+                int ch = columnChannel[n];
+                if (ch == -1)
+                    continue;
+                double value;
+                if (!scan::ToDouble(field, value))
+                    throw fmt::format("Invalid number on line #{}", lineNum);
+                columns[ch].push_back(value * schema.scale[ch] + schema.offset[ch]);
             }
-            catch (std::invalid_argument)
+
+            p = (lineEnd < end) ? lineEnd + 1 : end;
+        }
+
+        const size_t count = columns[schema.Has(ChanPressure) ? ChanPressure : ChanDepth].size();
+        if (count != static_cast<size_t>(numDataLines))
+            std::cout << "Warning: Number of entries does not match the header in " << fileName << "\n";
+
+        // Fill in whichever of depth/pressure is missing
+        if (!schema.Has(ChanDepth))
+        {
+            columns[ChanDepth].resize(count);
+            ssp::Depth(columns[ChanPressure].data(), columns[ChanDepth].data(), count, cast.lat);
+        }
+        else if (!schema.Has(ChanPressure))
+        {
+            columns[ChanPressure].resize(count);
+            DepthToPressure(columns[ChanDepth].data(), columns[ChanPressure].data(), count, cast.lat);
+        }
+
+        // Salinity from conductivity if needed (or a typical 35 ppt if neither is present)
+        if (!schema.Has(ChanSalinity))
+        {
+            columns[ChanSalinity].resize(count, 35.0);
+            if (schema.Has(ChanCond) && schema.Has(ChanTemp))
             {
-                throw fmt::format("Invalid number on line #{}", lineNum);
+                CastVector<Cast, double> presDbar(columns[ChanPressure], alloc);
+                for (auto& pr : presDbar)
+                    pr *= 10.0;
+                ConductivityToSalinity(columns[ChanCond].data(), presDbar.data(), columns[ChanTemp].data(), columns[ChanSalinity].data(), count);
             }
+        }
 
-            entries.push_back(entry);
+        if (!schema.Has(ChanTemp))
+            columns[ChanTemp].resize(count, 0.0);
+        if (!schema.Has(ChanSound))
+        {
+            columns[ChanSound].resize(count);
+            SoundSpeed(equation, columns[ChanTemp].data(), columns[ChanSalinity].data(), columns[ChanPressure].data(),
+                columns[ChanSound].data(), count, cast.lat);
         }
 
-        if (entries.size() != numDataLines)
-            throw std::string("Number of entries does not match");
+        entries.resize(count);
+        for (size_t n = 0; n < count; ++n)
+        {
+            SCastEntry& entry = entries[n];
+            entry.c = columns[ChanSound][n];
+            entry.temp = columns[ChanTemp][n];
+            entry.salinity = columns[ChanSalinity][n];
+            entry.pressure = columns[ChanPressure][n];
+            entry.depth = columns[ChanDepth][n];
+        }
     }
     catch (std::string err)
     {
         std::cout << "Error reading Sea & Sun file (" << fileName << "): " << err << "\n";
-        return {};
+        return false;
     }
 
-    //cast.lat = 0;
-    //cast.lon = 0;
     cast.desc = "Sea & Sun (.tob)";
-    cast.fileName = fileName;
+    AssignString(cast.fileName, fileName);
 
-    return cast;
+    return true;
 }
 
+template bool ParseSeaAndSun(std::string_view, const std::string&, SCast&, eSoundSpeedEquation);
+template bool ParseSeaAndSun(std::string_view, const std::string&, pmr::SCast&, eSoundSpeedEquation);
+
 };  // End namespace ssp
@@ -31,9 +31,16 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include "SspCpp/Cast.h"
+#include "SspCpp/Equations.h"
 
 namespace ssp
 {
-    std::optional<SCast> ReadSeaAndSun(const std::string& fileName);
+    std::optional<SCast> ReadSeaAndSun(const std::string& fileName, eSoundSpeedEquation equation = eSoundSpeedEquation::WongZhu);
+
+    //! Parses a cast from text in memory. Instantiated for SCast and pmr::SCast.
+    template <class Cast>
+    bool ParseSeaAndSun(std::string_view contents, const std::string& fileName, Cast& cast,
+        eSoundSpeedEquation equation = eSoundSpeedEquation::WongZhu);
 };
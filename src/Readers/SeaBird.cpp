@@ -41,6 +41,8 @@
 #include <date/date.h>
 #include <fmt/format.h>
 #include <SspCpp/SoundSpeed.h>
+#include "../CastTypes.h"
+#include "../Scanner.h"
 #include "../StringUtilities.h"
 #include "../TimeStruct.h"
 
@@ -48,11 +50,11 @@
 namespace ssp
 {
 
-bool ParseCnvTime(std::string header, SCast& cast)
+bool ParseCnvTime(const std::string& header, std::tm& time)
 {
     using namespace date;
 
-    std::regex rgxTime("# start_time = ([a-zA-Z]+ [0-9]+ [0-9]+ [0-9]+:[0-9]+:[0-9]+)");
+    static const std::regex rgxTime("# start_time = ([a-zA-Z]+ [0-9]+ [0-9]+ [0-9]+:[0-9]+:[0-9]+)");
     std::smatch match;
     std::regex_search(header, match, rgxTime);
     if (match.size() != 2)
@@ -70,7 +72,7 @@ bool ParseCnvTime(std::string header, SCast& cast)
     //
     //cast.time = CreateTime(static_cast<int>(ymd.year()), static_cast<unsigned int>(ymd.month()), static_cast<unsigned int>(ymd.day()),
     //    hms.hours().count(), hms.minutes().count(), static_cast<unsigned int>(hms.seconds().count()));
-    if (!CreateTime(tp, cast.time))
+    if (!CreateTime(tp, time))
         return false;
 
     // To verify that CreateTime worked correctly.
@@ -81,7 +83,7 @@ bool ParseCnvTime(std::string header, SCast& cast)
 }
 
 
-bool ParseLatLon1(std::string header, SCast& cast)
+bool ParseLatLon1(const std::string& header, double& latOut, double& lonOut)
 {
     std::smatch match;
 
@@ -91,7 +93,7 @@ bool ParseLatLon1(std::string header, SCast& cast)
     //   associated decimal-fraction are optional if full resolution not required."
 
     // Parse latitude string
-    std::regex rgxLat("NMEA Latitude = ([0-9]+) ([0-9]+[.][0-9]+) ([NS])");
+    static const std::regex rgxLat("NMEA Latitude = ([0-9]+) ([0-9]+[.][0-9]+) ([NS])");
     std::regex_search(header, match, rgxLat);
     if (match.size() != 4)
         return false;
@@ -106,10 +108,10 @@ bool ParseLatLon1(std::string header, SCast& cast)
 
     if (NorthSouth == "S")
         lat = -lat;
-    cast.lat = lat;
+    latOut = lat;
 
     // Parse longitude string
-    std::regex rgxLon("NMEA Longitude = ([0-9]+) ([0-9]+[.][0-9]+) ([EW])");
+    static const std::regex rgxLon("NMEA Longitude = ([0-9]+) ([0-9]+[.][0-9]+) ([EW])");
     std::regex_search(header, match, rgxLon);
     if (match.size() != 4)
         return false;
@@ -124,18 +126,18 @@ bool ParseLatLon1(std::string header, SCast& cast)
 
     if (EastWest == "W")
         lon = -lon;
-    cast.lon = lon;
+    lonOut = lon;
 
     return true;
 }
 
 
-bool ParseLatLon2(std::string header, SCast& cast)
+bool ParseLatLon2(const std::string& header, double& latOut, double& lonOut)
 {
     std::smatch match;
 
     // Parse latitude string
-    std::regex rgxLat(R"(\*\* Lat:[ ]*([0-9]+);([0-9]+);([0-9]+[.][0-9]+) ([NS]))");
+    static const std::regex rgxLat(R"(\*\* Lat:[ ]*([0-9]+);([0-9]+);([0-9]+[.][0-9]+) ([NS]))");
     std::regex_search(header, match, rgxLat);
     if (match.size() != 5)
         return false;
@@ -152,10 +154,10 @@ bool ParseLatLon2(std::string header, SCast& cast)
 
     if (NorthSouth == "S")
         lat = -lat;
-    cast.lat = lat;
+    latOut = lat;
 
     // Parse longitude string
-    std::regex rgxLon(R"(\*\* Lon:[ ]*([0-9]+);([0-9]+);([0-9]+[.][0-9]+) ([EW]))");
+    static const std::regex rgxLon(R"(\*\* Lon:[ ]*([0-9]+);([0-9]+);([0-9]+[.][0-9]+) ([EW]))");
     std::regex_search(header, match, rgxLon);
     if (match.size() != 5)
         return false;
@@ -172,20 +174,20 @@ bool ParseLatLon2(std::string header, SCast& cast)
 
     if (EastWest == "W")
         lon = -lon;
-    cast.lon = lon;
+    lonOut = lon;
 
     return true;
 }
 
 
-bool ParseLatLon(std::string header, SCast& cast)
+bool ParseLatLon(const std::string& header, double& lat, double& lon)
 {
     try
     {
         // There are two different ways that lat/lon can be specified, so try both.
-        if (ParseLatLon1(header, cast))
+        if (ParseLatLon1(header, lat, lon))
             return true;
-        if (ParseLatLon2(header, cast))
+        if (ParseLatLon2(header, lat, lon))
             return true;
     }
     catch (std::invalid_argument)
@@ -200,46 +202,48 @@ bool ParseLatLon(std::string header, SCast& cast)
 
 std::optional<SCast> ReadSeaBirdCnv(const std::string& fileName)
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
     {
         std::cout << "Could not open file " << fileName << "\n";
         return {};
     }
 
     SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
+    if (!ParseSeaBirdCnv(contents, fileName, cast))
+        return {};
+    return cast;
+}
 
-    // Reads all of the header up through the "*END*" line
-    std::string line, header;
-    header.reserve(7000);
-    bool bFoundEnd = false;
 
-    while (std::getline(inFile, line))
+template <class Cast>
+bool ParseSeaBirdCnv(std::string_view contents, const std::string& fileName, Cast& cast)
+{
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+
+    // Finds the header up through the "*END*" line
+    std::string_view line;
+    const char* headerEnd = nullptr;
+    while (headerEnd == nullptr && scan::GetLine(p, end, line))
     {
         if (line == "*END*")
-        {
-            bFoundEnd = true;
-            break;
-        }
-
-        header += line + "\n";
+            headerEnd = line.data();
     }
-    if (!bFoundEnd)
+    if (headerEnd == nullptr)
     {
         std::cout << "Sea-Bird file has malformed header\n";
-        return {};
+        return false;
     }
+    const std::string header(contents.data(), headerEnd - contents.data());
 
     // This can have different sensors, and they can likely be on any channel. Here we have to determine from
     //  the header where the information we are interested in is.
     int depthPos = -1, speedPos = -1, salinPos = -1, tempPos = -1, pressurePos = -1;
-    std::regex rgx("# name ([0-9]+) = ([a-zA-Z0-9/]+): ([a-zA-Z]+)");
-    std::smatch match;
-    std::string headSub = header;
-
-    while (std::regex_search(headSub, match, rgx))
+    static const std::regex rgx("# name ([0-9]+) = ([a-zA-Z0-9/]+): ([a-zA-Z]+)");
+    for (auto it = std::sregex_iterator(header.begin(), header.end(), rgx); it != std::sregex_iterator(); ++it)
     {
+        const auto& match = *it;
         int pos;
         try
         {
@@ -248,7 +252,7 @@ std::optional<SCast> ReadSeaBirdCnv(const std::string& fileName)
         catch (std::invalid_argument)
         {
             std::cout << "Invalid latitude/longitude strings\n";
-            return {};
+            return false;
         }
         std::string sensorType = match[3];
 
@@ -262,68 +266,74 @@ std::optional<SCast> ReadSeaBirdCnv(const std::string& fileName)
             tempPos = pos;
         else if (sensorType == "Pressure")
             pressurePos = pos;
-
-        // Move past the found string to continue searching
-        headSub = match.suffix();
     }
 
     /// @todo: Calculate sound speed from the other parameters (if depth is present)
     if (depthPos == -1 || speedPos == -1)
     {
         std::cout << "Missing sensor types in " << fileName << "\n";
-        return {};
+        return false;
     }
 
-    if (!ParseCnvTime(header, cast))
-        return {};
+    if (!ParseCnvTime(header, cast.time))
+        return false;
 
-    if (!ParseLatLon(header, cast))
-        return {};
+    if (!ParseLatLon(header, cast.lat, cast.lon))
+        return false;
 
     /// @todo: May want to do something with the "# nvalues =" line
 
-    int lineNum = 0;
-    while (std::getline(inFile, line))
+    // Columns are picked out of each line by position, without splitting the line into strings
+    const int lastPos = std::max({ depthPos, speedPos, salinPos, tempPos, pressurePos });
+    cast.entries.reserve(scan::CountLines(p, end));
+    while (p < end)
     {
-        lineNum++;
-        if (line.size() == 0)
+        if (scan::AtLineEnd(p, end))
             break;
 
-        auto lineStrings = SplitString(line);
-        
-        try
+        SCastEntry entry;
+        bool valid = true;
+        for (int pos = 0; pos <= lastPos && valid; ++pos)
         {
-            SCastEntry entry;
-            entry.depth = std::stod(lineStrings[depthPos]);
-            entry.c = std::stod(lineStrings[speedPos]);
-
-            if (salinPos != -1)
-                entry.salinity = std::stod(lineStrings[salinPos]);
-            if (tempPos != -1)
-                entry.temp = std::stod(lineStrings[tempPos]);
-            if (pressurePos != -1)
-                entry.pressure = std::stod(lineStrings[pressurePos]);
+            std::string_view field;
+            if (!scan::NextField(p, end, field))
+            {
+                valid = false;
+                break;
+            }
 
-            entries.push_back(entry);
+            if (pos == depthPos)
+                valid = scan::ToDouble(field, entry.depth);
+            else if (pos == speedPos)
+                valid = scan::ToDouble(field, entry.c);
+            else if (pos == salinPos)
+                valid = scan::ToDouble(field, entry.salinity);
+            else if (pos == tempPos)
+                valid = scan::ToDouble(field, entry.temp);
+            else if (pos == pressurePos)
+                valid = scan::ToDouble(field, entry.pressure);
         }
-        catch (std::invalid_argument)
+        if (!valid)
         {
-            std::cout << "Invalid entry #" << entries.size() << "\n";
-            return {};
+            std::cout << "Invalid entry #" << cast.entries.size() << "\n";
+            return false;
         }
+
+        cast.entries.push_back(entry);
+        scan::NextLine(p, end);
     }
 
     cast.desc = "Sea-Bird CNV";
-    cast.fileName = fileName;
+    AssignString(cast.fileName, fileName);
 
-    return cast;
+    return true;
 }
 
 
-bool ParseTsvHeader(std::string line, SCast& cast)
+bool ParseTsvHeader(const std::string& line, std::tm& time, double& lat, double& lon)
 {
     // Header string format: "## DATE:yyyy-mm-ddThh:mm:ss\tLATITUDE:xx.xx\tLONGITUDE:xx.xx"
-    std::regex rgx("## DATE:([0-9]+)-([0-9]+)-([0-9]+)T([0-9])+:([0-9])+:([0-9]+).*LATITUDE:([+-]?([0-9]*[.])?[0-9]+).*LONGITUDE:([+-]?([0-9]*[.])?[0-9]+)");
+    static const std::regex rgx("## DATE:([0-9]+)-([0-9]+)-([0-9]+)T([0-9]+):([0-9]+):([0-9]+).*LATITUDE:([+-]?([0-9]*[.])?[0-9]+(?:[eE][+-]?[0-9]+)?).*LONGITUDE:([+-]?([0-9]*[.])?[0-9]+(?:[eE][+-]?[0-9]+)?)");
     std::smatch matches;
     std::regex_search(line, matches, rgx);
 
@@ -333,13 +343,13 @@ bool ParseTsvHeader(std::string line, SCast& cast)
         return false;
     }
 
-    if (!CreateTime(matches[1], matches[2], matches[3], matches[4], matches[5], matches[6], cast.time))
+    if (!CreateTime(matches[1], matches[2], matches[3], matches[4], matches[5], matches[6], time))
         return false;
 
     try
     {
-        cast.lat = std::stod(matches[7]);
-        cast.lon = std::stod(matches[9]);
+        lat = std::stod(matches[7]);
+        lon = std::stod(matches[9]);
     }
     catch (std::invalid_argument)
     {
@@ -353,60 +363,72 @@ bool ParseTsvHeader(std::string line, SCast& cast)
 
 std::optional<SCast> ReadSeaBirdTsv(const std::string& fileName)
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
     {
         std::cout << "Could not open file " << fileName << "\n";
         return {};
     }
 
     SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
-    std::string line;
+    if (!ParseSeaBirdTsv(contents, fileName, cast))
+        return {};
+    return cast;
+}
+
+
+template <class Cast>
+bool ParseSeaBirdTsv(std::string_view contents, const std::string& fileName, Cast& cast)
+{
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+    std::string_view line;
 
     try
     {
-        if (!std::getline(inFile, line))
+        if (!scan::GetLine(p, end, line))
             throw "Line read failure";
 
-        if (!ParseTsvHeader(line, cast))
+        if (!ParseTsvHeader(std::string(line), cast.time, cast.lat, cast.lon))
             throw "Could not parse header line";
 
-        while (std::getline(inFile, line))
+        cast.entries.reserve(scan::CountLines(p, end));
+        while (p < end)
         {
-            if (line.size() == 0)
+            if (scan::AtLineEnd(p, end))
                 break;
 
             // The depth and sound speed are required fields
-            std::stringstream ss(line);
             SCastEntry entry;
-            ss >> entry.depth >> entry.c;
-            if (ss.fail())
-                throw fmt::format("Incomplete entry for line #{}", entries.size() + 2);
+            if (!scan::ParseDouble(p, end, entry.depth) || !scan::ParseDouble(p, end, entry.c))
+                throw fmt::format("Incomplete entry for line #{}", cast.entries.size() + 2);
 
             // Temperature and salinity are optional fields (may not be present in the file but have to be present together)
-            ss >> entry.temp >> entry.salinity;
-            if (ss.fail())
+            if (!scan::ParseDouble(p, end, entry.temp) || !scan::ParseDouble(p, end, entry.salinity))
             {
                 entry.temp = 0;
                 entry.salinity = 0;
             }
 
-            entries.push_back(entry);
+            cast.entries.push_back(entry);
+            scan::NextLine(p, end);
         }
     }
     catch (std::string err)
     {
         std::cout << "Error reading Sea-Bird file (" << fileName << "): " << err << "\n";
-        return {};
+        return false;
+    }
+    catch (const char* err)
+    {
+        std::cout << "Error reading Sea-Bird file (" << fileName << "): " << err << "\n";
+        return false;
     }
 
-    //cast.lat = 0;
-    //cast.lon = 0;
     cast.desc = "Sea-Bird Nautilus";
-    cast.fileName = fileName;
+    AssignString(cast.fileName, fileName);
 
-    return cast;
+    return true;
 }
 
 
@@ -416,4 +438,9 @@ std::optional<SCast> ReadSeaBird(const std::string& fileName)
     return ReadSeaBirdTsv(fileName);
 }
 
+template bool ParseSeaBirdCnv(std::string_view, const std::string&, SCast&);
+template bool ParseSeaBirdCnv(std::string_view, const std::string&, pmr::SCast&);
+template bool ParseSeaBirdTsv(std::string_view, const std::string&, SCast&);
+template bool ParseSeaBirdTsv(std::string_view, const std::string&, pmr::SCast&);
+
 };  // End namespace ssp
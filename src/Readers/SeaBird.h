@@ -31,6 +31,7 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <SspCpp/Cast.h>
 
 namespace ssp
@@ -38,4 +39,10 @@ namespace ssp
     std::optional<SCast> ReadSeaBirdCnv(const std::string& fileName);
     std::optional<SCast> ReadSeaBirdTsv(const std::string& fileName);
     std::optional<SCast> ReadSeaBird(const std::string& fileName);
+
+    //! Parse casts from text in memory. Instantiated for SCast and pmr::SCast.
+    template <class Cast>
+    bool ParseSeaBirdCnv(std::string_view contents, const std::string& fileName, Cast& cast);
+    template <class Cast>
+    bool ParseSeaBirdTsv(std::string_view contents, const std::string& fileName, Cast& cast);
 };
@@ -28,84 +28,227 @@
   * 
   * This file can have whitespace and delimiters in the lines (space, tab, commas, semicolons,
   * etc.). If a line starts with #, %, or //, it is considered to be a comment line and ignored.
+  * Units after the numbers ("10 m 1500 m/s") are ignored, and lines without enough numbers (such as
+  * column headers) are skipped. The column layout can be changed with SSimpleFormat.
   */
 
 #include "pch.h"
 #include "Simple.h"
 #include <array>
-#include <fstream>
-#include <regex>
 #include <fmt/format.h>
 #include <SspCpp/SoundSpeed.h>
+#include "CastTypes.h"
+#include "Scanner.h"
 #include "StringUtilities.h"
 
 
+namespace ssp::simple
+{
+    //! Whether the character separates fields when no delimiter was given
+    inline bool IsSeparator(char c)
+    {
+        return scan::IsSpace(c) || c == ',' || c == ';' || c == '|';
+    }
+
+    //! Finds where a comment starts on the line (or the line end if there is none)
+    const char* CommentStart(const char* p, const char* end)
+    {
+        for (; p < end; ++p)
+        {
+            if (*p == '#' || *p == '%')
+                return p;
+            if (*p == '/' && p + 1 < end && *(p + 1) == '/')
+                return p;
+        }
+        return end;
+    }
+
+    //! Gets the next field, either separated by the delimiter or by runs of any separator characters
+    bool NextField(const char*& p, const char* end, char delimiter, std::string_view& field)
+    {
+        if (delimiter == 0)
+        {
+            while (p < end && IsSeparator(*p))
+                ++p;
+            const char* start = p;
+            while (p < end && !IsSeparator(*p))
+                ++p;
+            field = std::string_view(start, p - start);
+            return p != start;
+        }
+
+        if (p >= end)
+            return false;
+        const char* start = scan::SkipSpace(p, end);
+        const char* fieldEnd = start;
+        while (fieldEnd < end && *fieldEnd != delimiter)
+            ++fieldEnd;
+        p = (fieldEnd < end) ? fieldEnd + 1 : end;
+
+        while (fieldEnd > start && scan::IsSpace(*(fieldEnd - 1)))
+            --fieldEnd;
+        field = std::string_view(start, fieldEnd - start);
+        return true;
+    }
+
+    //! Reads the number at the start of a field, ignoring any unit right after it ("1500m/s")
+    inline bool ParseNumber(std::string_view field, double& value)
+    {
+        const char* p = field.data();
+        return scan::ParseDouble(p, p + field.size(), value);
+    }
+
+    /*!
+     * \brief Gets the next numeric field
+     *
+     * Without a delimiter, words between the numbers (units such as "10 m 1500 m/s") are skipped. With a
+     * delimiter the columns are positional, so the field must start with a number.
+     */
+    bool NextNumber(const char*& p, const char* end, char delimiter, double& value)
+    {
+        std::string_view field;
+        while (NextField(p, end, delimiter, field))
+        {
+            if (ParseNumber(field, value))
+                return true;
+            if (delimiter != 0)
+                return false;
+        }
+        return false;
+    }
+};  // End namespace ssp::simple
+
+
 std::optional<ssp::SCast> ssp::ReadSimple(const std::string& fileName)
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    return ReadSimple(fileName, SSimpleFormat());
+}
+
+
+std::optional<ssp::SCast> ssp::ReadSimple(const std::string& fileName, const SSimpleFormat& format)
+{
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
     {
         std::cout << "Could not open file " << fileName << "\n";
         return {};
     }
 
     SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
-    std::string line;
-    int lineNum = 0;
+    if (!ParseSimple(contents, fileName, format, cast))
+        return {};
+    return cast;
+}
 
-    while (!inFile.eof())
-    {
-        ++lineNum;
 
-        if (!std::getline(inFile, line))
-            break;
-        std::string trimmed = ltrim(line);
-        if (StartsWith(trimmed, "#") || StartsWith(trimmed, "%") || StartsWith(trimmed, "//"))  // Comment line
+template <class Cast>
+bool ssp::ParseSimple(std::string_view contents, const std::string& fileName, const SSimpleFormat& format, Cast& cast)
+{
+    constexpr size_t NumColumns = static_cast<size_t>(eSimpleColumn::Ignore);
+
+    // Last column index that has to be read, and which quantities are present
+    int lastColumn = -1;
+    std::array<bool, NumColumns> present = {};
+    for (size_t n = 0; n < format.columns.size(); ++n)
+    {
+        if (format.columns[n] == eSimpleColumn::Ignore)
             continue;
+        present[static_cast<size_t>(format.columns[n])] = true;
+        lastColumn = static_cast<int>(n);
+    }
+
+    const bool bHasDepth = present[static_cast<size_t>(eSimpleColumn::Depth)];
+    const bool bHasPressure = present[static_cast<size_t>(eSimpleColumn::Pressure)];
+    const bool bHasSpeed = present[static_cast<size_t>(eSimpleColumn::SoundSpeed)];
+    const bool bHasTemp = present[static_cast<size_t>(eSimpleColumn::Temperature)];
+    if ((!bHasDepth && !bHasPressure) || (!bHasSpeed && !bHasTemp))
+    {
+        fmt::print("Simple format for {} needs depth or pressure, and sound speed or temperature\n", fileName);
+        return false;
+    }
+
+    auto& entries = cast.entries;
+    entries.reserve(scan::CountLines(contents.data(), contents.data() + contents.size()));
 
-        if (line.size() == 0)
-            break;
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+    std::string_view line;
+    int lineNum = 0;
+    int numSkipped = 0;
 
-        // Can be either an integer or a decimal number. The "(?:[+-]?[0-9]*[.])?" is a non-capture group,
-        //  with the last ? indicating that it is optional. The "[0-9]+" at the end indicates that this
-        //  must have at least a set of digits. The "[+-]?" at the beginning gives that the number could have
-        //  an optional + or - at the beginning.
-        std::regex rgx("([+-]?(?:[0-9]*[.])?[0-9]+)");
-        std::smatch match;
+    while (scan::GetLine(p, end, line))
+    {
+        ++lineNum;
 
-        std::array<double,2> vals;
-        for (int n = 0; n < 2; ++n)
+        const char* q = line.data();
+        const char* lineEnd = simple::CommentStart(q, q + line.size());
+        const bool bComment = lineEnd != q + line.size();
+        if (scan::AtLineEnd(q, lineEnd))
         {
+            if (!bComment && format.stopAtBlankLine)
+                break;
+            continue;  // Blank or comment line
+        }
 
-            if (!std::regex_search(line, match, rgx) || match.size() < 2)
+        SCastEntry entry;
+        bool bParsed = true;
+        for (int n = 0; n <= lastColumn; ++n)
+        {
+            double value;
+            if (!simple::NextNumber(q, lineEnd, format.delimiter, value))
             {
-                fmt::print("Could not parse line #{} of {}\n", lineNum, fileName);
-                return {};
+                bParsed = false;
+                break;
             }
 
-            try
+            switch (format.columns[n])
             {
-                vals[n] = std::stod(match[1]);
+                case eSimpleColumn::Depth:        entry.depth = value;     break;
+                case eSimpleColumn::SoundSpeed:   entry.c = value;         break;
+                case eSimpleColumn::Temperature:  entry.temp = value;      break;
+                case eSimpleColumn::Salinity:     entry.salinity = value;  break;
+                case eSimpleColumn::Pressure:     entry.pressure = value;  break;
+                default:                                                   break;
             }
-            catch (std::invalid_argument)
-            {
-                fmt::print("Could not parse line #{} of {}\n", lineNum, fileName);
-                return {};
-            }
-
-            // Move past the found string to continue searching
-            line = match.suffix();
         }
 
-        SCastEntry entry;
-        entry.depth = vals[0];
-        entry.c = vals[1];
+        // Lines without enough numbers are skipped. Before the data they are column headers, so only the ones
+        //  after it are worth reporting.
+        if (!bParsed)
+        {
+            if (!entries.empty())
+                ++numSkipped;
+            continue;
+        }
         entries.push_back(entry);
     }
 
+    if (entries.empty())
+    {
+        fmt::print("Could not parse any lines of {}\n", fileName);
+        return false;
+    }
+    if (numSkipped > 0)
+        fmt::print("Skipped {} lines of {} that could not be parsed\n", numSkipped, fileName);
+
+    // Fill in anything that can be derived from the other columns
+    const bool bHasSalinity = present[static_cast<size_t>(eSimpleColumn::Salinity)];
+    for (auto& entry : entries)
+    {
+        if (!bHasDepth)
+            entry.depth = Depth(entry.pressure, 0.0);
+        else if (!bHasPressure && !bHasSpeed)
+            entry.pressure = DepthToPressure(entry.depth, 0.0);
+
+        if (!bHasSpeed)
+            entry.c = SoundSpeed(format.equation, entry.temp, bHasSalinity ? entry.salinity : 35.0, entry.pressure, 0.0);
+    }
+
     cast.desc = "Simple text-based SSP";
-    cast.fileName = fileName;
+    AssignString(cast.fileName, fileName);
 
-    return cast;
+    return true;
 }
+
+template bool ssp::ParseSimple(std::string_view, const std::string&, const SSimpleFormat&, SCast&);
+template bool ssp::ParseSimple(std::string_view, const std::string&, const SSimpleFormat&, pmr::SCast&);
@@ -31,9 +31,15 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <SspCpp/Cast.h>
+#include <SspCpp/SoundSpeed.h>
 
 namespace ssp
 {
     std::optional<SCast> ReadSimple(const std::string& fileName);
+
+    //! Parses a cast from text in memory. Instantiated for SCast and pmr::SCast.
+    template <class Cast>
+    bool ParseSimple(std::string_view contents, const std::string& fileName, const SSimpleFormat& format, Cast& cast);
 };
@@ -29,102 +29,119 @@
 
 #include "pch.h"
 #include "Sonardyne.h"
-#include <algorithm>
-#include <fstream>
 #include <iostream>
 #include <string>
-#include <sstream>
-#include <vector>
 #include <fmt/format.h>
 #include <SspCpp/Cast.h>
+#include "../CastTypes.h"
+#include "../Scanner.h"
 #include "../TimeStruct.h"
 
 
+namespace ssp::sonardyne
+{
+    //! Parses three integers separated by a character (e.g., 08/19/2019 or 15:47:00)
+    bool ParseTriple(std::string_view line, char separator, int& a, int& b, int& c)
+    {
+        const char* p = line.data();
+        const char* end = p + line.size();
+        if (!scan::ParseInt(p, end, a) || p >= end || *p++ != separator)
+            return false;
+        if (!scan::ParseInt(p, end, b) || p >= end || *p++ != separator)
+            return false;
+        return scan::ParseInt(p, end, c);
+    }
+};  // End namespace ssp::sonardyne
+
+
 std::optional<ssp::SCast> ssp::ReadSonardyne(const std::string& fileName)
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
     {
         std::cout << "Could not open file " << fileName << "\n";
         return {};
     }
 
     SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
-    std::string line, dateLine, timeLine;
+    if (!ParseSonardyne(contents, fileName, cast))
+        return {};
+    return cast;
+}
+
+
+template <class Cast>
+bool ssp::ParseSonardyne(std::string_view contents, const std::string& fileName, Cast& cast)
+{
+    const char* p = contents.data();
+    const char* end = p + contents.size();
+    std::string_view line, dateLine, timeLine;
 
     try
     {
-        if (!std::getline(inFile, line))  // Title
+        if (!scan::GetLine(p, end, line))  // Title
             throw "Line read failure";
-        if (!std::getline(inFile, dateLine))
+        if (!scan::GetLine(p, end, dateLine))
             throw "Line read failure";
-        if (!std::getline(inFile, timeLine))
+        if (!scan::GetLine(p, end, timeLine))
             throw "Line read failure";
-        if (!std::getline(inFile, line))  // Probe name?
+        if (!scan::GetLine(p, end, line))  // Probe name?
             throw "Line read failure";
-        if (!std::getline(inFile, line))  // Comments line
+        if (!scan::GetLine(p, end, line))  // Comments line
             throw "Line read failure";
 
-        // Parse the date string
-        std::replace(dateLine.begin(), dateLine.end(), '/', ' ');
-        std::stringstream dateStream(dateLine);
         int month, day, year;
-        dateStream >> month >> day >> year;
-        if (dateStream.fail())
+        if (!sonardyne::ParseTriple(dateLine, '/', month, day, year))
             throw "Could not parse date";
 
-        // Parse the time string
-        std::replace(timeLine.begin(), timeLine.end(), ':', ' ');
-        std::stringstream timeStream(timeLine);
         int hour, minute, second;
-        timeStream >> hour >> minute >> second;
-        if (timeStream.fail())
+        if (!sonardyne::ParseTriple(timeLine, ':', hour, minute, second))
             throw "Could not parse time";
 
         cast.time = CreateTime(year, month, day, hour, minute, second);
 
-        while (std::getline(inFile, line))
+        cast.entries.reserve(scan::CountLines(p, end));
+        while (p < end)
         {
-            if (line.size() == 0)
+            if (scan::AtLineEnd(p, end))
                 break;
 
             // The depth and sound speed are required fields...
-            std::stringstream ss(line);
             SCastEntry entry;
-            ss >> entry.depth >> entry.c;
-            if (ss.fail())
-                throw fmt::format("Incomplete entry for line #{}", entries.size() + 6);
+            if (!scan::ParseDouble(p, end, entry.depth) || !scan::ParseDouble(p, end, entry.c))
+                throw fmt::format("Incomplete entry for line #{}", cast.entries.size() + 6);
 
             // Salinity and temperature are optional fields (may not be present in the file)
-            ss >> entry.salinity;
-            if (ss.fail())
+            if (!scan::ParseDouble(p, end, entry.salinity))
             {
                 entry.salinity = 0;
                 entry.temp = 0;
             }
-            else
+            else if (!scan::ParseDouble(p, end, entry.temp))
             {
-                ss >> entry.temp;
-                if (ss.fail())
-                {
-                    entry.temp = 0;
-                }
+                entry.temp = 0;
             }
 
-            entries.push_back(entry);
+            cast.entries.push_back(entry);
+            scan::NextLine(p, end);
         }
     }
     catch (std::string err)
     {
         std::cout << "Error reading Sonardyne file (" << fileName << "): " << err << "\n";
-        return {};
+        return false;
+    }
+    catch (const char* err)
+    {
+        std::cout << "Error reading Sonardyne file (" << fileName << "): " << err << "\n";
+        return false;
     }
 
-    //cast.lat = 0;
-    //cast.lon = 0;
     cast.desc = "Sonardyne";
-    cast.fileName = fileName;
+    AssignString(cast.fileName, fileName);
 
-    return cast;
+    return true;
 }
+
+template bool ssp::ParseSonardyne(std::string_view, const std::string&, SCast&);
+template bool ssp::ParseSonardyne(std::string_view, const std::string&, pmr::SCast&);
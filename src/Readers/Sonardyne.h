@@ -31,9 +31,14 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <SspCpp/Cast.h>
 
 namespace ssp
 {
     std::optional<SCast> ReadSonardyne(const std::string& fileName);
+
+    //! Parses a cast from text in memory. Instantiated for SCast and pmr::SCast.
+    template <class Cast>
+    bool ParseSonardyne(std::string_view contents, const std::string& fileName, Cast& cast);
 };
@@ -25,152 +25,353 @@
  /*!
   * \file   Unb.cpp
   * \brief
+  *
+  * The whole file is read into memory and scanned in place, so there is no per-line or per-field
+  * allocation. The same record parser is used by the bulk reader (ReadUnbCasts), which handles a
+  * directory of .unb files or files with several records concatenated (e.g., World Ocean Database exports).
+  * A directory is read in two passes: the first finds the size of every record, so the table columns can be
+  * sized once, and the second parses each file straight into its slice of the columns.
   */
 
 #include "pch.h"
 #include "Unb.h"
 #include <algorithm>
-#include <fstream>
+#include <cstdint>
+#include <filesystem>
 #include <iostream>
-#include <regex>
 #include <string>
-#include <sstream>
 #include <vector>
-#include <date/date.h>
 #include <fmt/format.h>
 #include <SspCpp/Cast.h>
+#include <SspCpp/CastTable.h>
 #include <SspCpp/LatLong.h>
 #include <SspCpp/ProcessChecks.h>
+#include <SspCpp/SoundSpeed.h>
+#include "CastTypes.h"
+#include "Parallel.h"
+#include "Scanner.h"
 #include "StringUtilities.h"
 #include "TimeStruct.h"
 
 
 namespace ssp::unb
 {
-    // This version will throw exceptions!
-    void ParseVersion(std::ifstream& inFile)
+    //! Reason and line number for a failed parse (this path does not use exceptions)
+    struct SParseError
     {
-        std::string line;
-        if (!std::getline(inFile, line))  // Version line (usually with comments after #)
-            throw "Line read failure";
+        const char* msg = "";
+        int lineNum = 0;
+    };
 
-        auto strings = SplitString(line);
-        if (strings.size() == 0)
-            throw "Invalid version in header";
+    //! Header values for one record
+    struct SRecordHeader
+    {
+        std::tm time;
+        double lat = 0;
+        double lon = 0;
+        int numEntries = 0;
+    };
+
+
+    bool Fail(SParseError& err, const char* msg, int lineNum)
+    {
+        err.msg = msg;
+        err.lineNum = lineNum;
+        return false;
+    }
+
+
+    //! Parses "year julian-day hh:mm:ss" (fractional seconds are ignored)
+    bool ParseDateTime(const char* p, const char* end, std::tm& time)
+    {
+        int year, julianDay, hour, minute, second;
+        if (!scan::ParseInt(p, end, year) || !scan::ParseInt(p, end, julianDay) || !scan::ParseInt(p, end, hour))
+            return false;
+        if (p >= end || *p++ != ':' || !scan::ParseInt(p, end, minute))
+            return false;
+        if (p >= end || *p++ != ':' || !scan::ParseInt(p, end, second))
+            return false;
+        if (julianDay < 1 || julianDay > 366)
+            return false;
 
-        try
+        // mktime normalizes the day of the year into a month and day
+        time = CreateTime(year, 1, julianDay, hour, minute, second);
+        return true;
+    }
+
+
+    //! Parses the 16 header lines, leaving p at the first entry
+    bool ParseHeader(const char*& p, const char* end, SRecordHeader& header, int& lineNum, SParseError& err)
+    {
+        std::string_view line;
+
+        // Version line (usually with comments after #)
+        ++lineNum;
+        int ver;
+        if (!scan::GetLine(p, end, line))
+            return Fail(err, "Line read failure", lineNum);
+        const char* q = line.data();
+        if (!scan::ParseInt(q, line.data() + line.size(), ver))
+            return Fail(err, "Invalid version line", lineNum);
+        if (ver != 2)
+            return Fail(err, "Invalid version number (should be 2)", lineNum);
+
+        // Date/time line. The next line has a date/time for logging, but the examples we have are filled with zeros.
+        ++lineNum;
+        if (!scan::GetLine(p, end, line) || !ParseDateTime(line.data(), line.data() + line.size(), header.time))
+            return Fail(err, "Could not parse date/time", lineNum);
+        ++lineNum;
+        if (!scan::GetLine(p, end, line))
+            return Fail(err, "Could not parse date/time", lineNum);
+
+        // Lat/lon line, followed by a lat/lon for logging (also unused)
+        ++lineNum;
+        if (!scan::GetLine(p, end, line))
+            return Fail(err, "Could not parse latitude/longitude", lineNum);
+        q = line.data();
+        if (!scan::ParseDouble(q, line.data() + line.size(), header.lat) || !scan::ParseDouble(q, line.data() + line.size(), header.lon))
+            return Fail(err, "Could not parse latitude/longitude", lineNum);
+        ++lineNum;
+        if (!scan::GetLine(p, end, line))
+            return Fail(err, "Could not parse latitude/longitude", lineNum);
+
+        ++lineNum;
+        if (!scan::GetLine(p, end, line))
+            return Fail(err, "Could not read line", lineNum);
+        q = line.data();
+        if (!scan::ParseInt(q, line.data() + line.size(), header.numEntries) || header.numEntries < 1)
+            return Fail(err, "Could not read number of entries", lineNum);
+
+        // Skip the next 10 lines, which are for future use
+        for (int m = 0; m < 10; ++m)
         {
-            int ver = std::stoi(strings[0]);
-            if (ver != 2)
-                throw "Invalid version number (should be 2)";
+            ++lineNum;
+            if (!scan::GetLine(p, end, line))
+                return Fail(err, "Could not read line", lineNum);
         }
-        catch (std::invalid_argument)
+
+        return true;
+    }
+
+
+    /*!
+     * \brief Parses the entry lines of one record, calling addEntry(depth, c, temp, salinity) for each
+     *
+     * Each line has the (1-indexed) entry number, depth, sound speed, temperature and salinity, followed by
+     * at least two more fields that are unused.
+     */
+    template <class AddEntry>
+    bool ParseEntries(const char*& p, const char* end, int numEntries, int& lineNum, AddEntry&& addEntry, SParseError& err)
+    {
+        for (int n = 0; n < numEntries; ++n)
         {
-            throw "Invalid version line";
+            ++lineNum;
+            if (p >= end)
+                return Fail(err, "Could not read line", lineNum);
+
+            const char* lineEnd = scan::LineEnd(p, end);
+            int entryNum;
+            double depth, c, temp, salinity;
+            if (!scan::ParseInt(p, lineEnd, entryNum))
+                return Fail(err, "Line could not be parsed", lineNum);
+            if (entryNum != n + 1)  // 1-indexed
+                return Fail(err, "Invalid entry number", lineNum);
+            if (!scan::ParseDouble(p, lineEnd, depth) || !scan::ParseDouble(p, lineEnd, c) ||
+                !scan::ParseDouble(p, lineEnd, temp) || !scan::ParseDouble(p, lineEnd, salinity))
+                return Fail(err, "Line could not be parsed", lineNum);
+            if (!scan::SkipField(p, lineEnd) || !scan::SkipField(p, lineEnd))
+                return Fail(err, "Invalid line", lineNum);
+
+            addEntry(depth, c, temp, salinity);
+            p = (lineEnd < end) ? lineEnd + 1 : end;
         }
 
-        return;
+        return true;
     }
 
 
-    bool ParseDateTime(std::ifstream& inFile, SCast& cast)
+    template <class Cast>
+    bool ParseRecord(const char*& p, const char* end, Cast& cast, int& lineNum, SParseError& err)
     {
-        std::string line;
-        if (!std::getline(inFile, line))  // Date/time line (usually with comments after #)
+        SRecordHeader header;
+        if (!ParseHeader(p, end, header, lineNum, err))
             return false;
 
-        std::istringstream in(line);
-        date::sys_seconds tp;
-        // In format: year julian-day hh:mm:ss
-        in >> date::parse("%Y %j %T", tp);
-        if (!in)
-            return false;  // Error parsing date/time string
+        cast.time = header.time;
+        cast.lat = header.lat;
+        cast.lon = header.lon;
+        cast.entries.reserve(header.numEntries);
 
-        if (!CreateTime(tp, cast.time))
-            return false;
+        return ParseEntries(p, end, header.numEntries, lineNum, [&cast](double depth, double c, double temp, double salinity)
+        {
+            SCastEntry entry;
+            entry.depth = depth;
+            entry.c = c;
+            entry.temp = temp;
+            entry.salinity = salinity;
+            cast.entries.push_back(entry);
+        }, err);
+    }
 
-        // The next line has a date/time for logging, but the two examples we have are filled with zeros
-        if (!std::getline(inFile, line))
-            return false;
 
-        return true;
+    //! Grows a column for another record without giving up geometric growth
+    void ReserveMore(std::vector<double>& column, size_t count)
+    {
+        const size_t needed = column.size() + count;
+        if (needed > column.capacity())
+            column.reserve(std::max(needed, 2 * column.capacity()));
     }
 
 
-    bool ParseLatLon(std::ifstream& inFile, SCast& cast)
+    //! Parses the entries of one record onto the end of the table columns. On failure the table is left unchanged.
+    bool ParseRecordEntries(const char*& p, const char* end, const SRecordHeader& header, const std::string& fileName,
+        SCastTable& table, int& lineNum, SParseError& err)
     {
-        std::string line;
-        if (!std::getline(inFile, line))  // Lat/lon line
-            return false;
+        for (auto* column : { &table.depth, &table.c, &table.temp, &table.salinity, &table.pressure })
+            ReserveMore(*column, header.numEntries);
 
-        std::stringstream ss(line);
-        ss >> cast.lat;
-        if (!ss)
-            return false;
-        ss >> cast.lon;
-        if (!ss)
-            return false;
+        bool ok = ParseEntries(p, end, header.numEntries, lineNum, [&table](double depth, double c, double temp, double salinity)
+        {
+            table.depth.push_back(depth);
+            table.c.push_back(c);
+            table.temp.push_back(temp);
+            table.salinity.push_back(salinity);
+        }, err);
 
-        // The next line has a lat/lon for logging, but the two examples we have are filled with zeros
-        if (!std::getline(inFile, line))
+        if (!ok)
+        {
+            // Roll back any entries from this record
+            const size_t size = table.offsets.back();
+            for (auto* column : { &table.depth, &table.c, &table.temp, &table.salinity })
+                column->resize(size);
             return false;
+        }
+
+        for (auto* column : { &table.pressure, &table.density, &table.sigmaT, &table.n2 })
+            column->resize(table.depth.size(), 0.0);
+        table.flags.resize(table.depth.size(), 0);
+        table.offsets.push_back(table.depth.size());
+        table.fileNames.push_back(fileName);
+        table.times.push_back(header.time);
+        table.lats.push_back(header.lat);
+        table.lons.push_back(header.lon);
 
         return true;
     }
 
 
-    // Warning: This function can throw!
-    bool ReadEntries(std::ifstream& inFile, SCast& cast) noexcept(false)
+    /*!
+     * \brief Parses up to maxRecords records from a file's contents, calling parseEntries(p, end, header, lineNum, err)
+     * after each header. Records after a malformed one are skipped.
+     */
+    template <class ParseBody>
+    size_t ForEachRecord(const std::string& contents, const std::string& fileName, size_t maxRecords, ParseBody&& parseEntries)
     {
-        std::string line;
+        const char* p = contents.data();
+        const char* end = p + contents.size();
+        int lineNum = 0;
+        size_t numRecords = 0;
 
-        if (!std::getline(inFile, line))
-            throw "Could not read line";
-        int num;
-        std::stringstream ss(line);
-        ss >> num;
-        if (!ss || num < 1)
-            throw "Could not read number of entries";
+        while (numRecords < maxRecords)
+        {
+            // Skip blank lines between records
+            while (p < end && scan::AtLineEnd(p, end))
+            {
+                scan::NextLine(p, end);
+                ++lineNum;
+            }
+            if (p >= end)
+                break;
 
-        cast.entries.reserve(num);
+            SParseError err;
+            SRecordHeader header;
+            if (!ParseHeader(p, end, header, lineNum, err) || !parseEntries(p, end, header, lineNum, err))
+            {
+                fmt::print("Error reading Unb file ({}): {} on line #{}\n", fileName, err.msg, err.lineNum);
+                break;
+            }
+            ++numRecords;
+        }
 
-        // Skip the next 10 lines, which are for future use
-        for (int m = 0; m < 10; ++m)
+        return numRecords;
+    }
+
+
+    //! Parses every record in a file onto the end of the table
+    size_t ReadRecords(const std::string& fileName, SCastTable& table)
+    {
+        std::string contents;
+        if (!scan::ReadFile(fileName, contents))
         {
-            if (!std::getline(inFile, line))
-                throw "Could not read line";
+            std::cout << "Could not open file " << fileName << "\n";
+            return 0;
         }
 
-        for (int n = 0; n < num; ++n)
+        return ForEachRecord(contents, fileName, SIZE_MAX,
+            [&](const char*& p, const char* end, const SRecordHeader& header, int& lineNum, SParseError& err)
         {
-            if (!std::getline(inFile, line))
-                throw fmt::format("Could not read line #{}", n + 16);
+            return ParseRecordEntries(p, end, header, fileName, table, lineNum, err);
+        });
+    }
 
-            auto strings = SplitString(line);
-            if (strings.size() == 0 || strings.size() < 7)
-                throw fmt::format("Invalid line #{}", n + 16);
 
-            try
-            {
-                int entryNum = std::stoi(strings[0]);
-                if (entryNum != n+1)  // 1-indexed
-                    throw fmt::format("Invalid entry number on line #{}", n + 16);
+    //! Headers of the records in one file that parsed, and where their entries start in the table
+    struct SFileRecords
+    {
+        std::vector<SRecordHeader> headers;
+        size_t numEntries = 0;
+        size_t firstEntry = 0;
+    };
 
-                SCastEntry entry;
-                entry.depth = std::stod(strings[1]);
-                entry.c = std::stod(strings[2]);
-                entry.temp = std::stod(strings[3]);
-                entry.salinity = std::stod(strings[4]);
 
-                cast.entries.push_back(entry);
-            }
-            catch (std::invalid_argument)
-            {
-                throw fmt::format("Line #{} could not be parsed", n + 16);
-            }
+    //! First pass over a file: validates every record and keeps only the headers, so the table can be sized up front
+    SFileRecords ScanRecords(const std::string& fileName)
+    {
+        SFileRecords records;
+        std::string contents;
+        if (!scan::ReadFile(fileName, contents))
+        {
+            std::cout << "Could not open file " << fileName << "\n";
+            return records;
         }
 
-        return true;
+        ForEachRecord(contents, fileName, SIZE_MAX,
+            [&records](const char*& p, const char* end, const SRecordHeader& header, int& lineNum, SParseError& err)
+        {
+            if (!ParseEntries(p, end, header.numEntries, lineNum, [](double, double, double, double) {}, err))
+                return false;
+            records.headers.push_back(header);
+            records.numEntries += header.numEntries;
+            return true;
+        });
+
+        return records;
+    }
+
+
+    //! Second pass over a file: writes the entries of the records found by ScanRecords into their slots in the table
+    void FillRecords(const std::string& fileName, const SFileRecords& records, SCastTable& table)
+    {
+        std::string contents;
+        if (records.headers.empty() || !scan::ReadFile(fileName, contents))
+            return;
+
+        size_t index = records.firstEntry;
+        const size_t endIndex = records.firstEntry + records.numEntries;
+        ForEachRecord(contents, fileName, records.headers.size(),
+            [&](const char*& p, const char* end, const SRecordHeader& header, int& lineNum, SParseError& err)
+        {
+            if (index + header.numEntries > endIndex)  // The file changed since the first pass
+                return Fail(err, "Record does not match the first read", lineNum);
+            return ParseEntries(p, end, header.numEntries, lineNum, [&](double depth, double c, double temp, double salinity)
+            {
+                table.depth[index] = depth;
+                table.c[index] = c;
+                table.temp[index] = temp;
+                table.salinity[index] = salinity;
+                ++index;
+            }, err);
+        });
     }
 
 }  // End namespace ssp::unb
@@ -178,39 +379,98 @@ namespace ssp::unb
 
 std::optional<ssp::SCast> ssp::ReadUnb(const std::string& fileName)
 {
-    std::ifstream inFile(fileName);
-    if (!inFile)
+    std::string contents;
+    if (!scan::ReadFile(fileName, contents))
     {
         std::cout << "Could not open file " << fileName << "\n";
         return {};
     }
 
     SCast cast;
-    std::vector<SCastEntry>& entries = cast.entries;
-    std::string line, dateLine, timeLine;
+    if (!ParseUnb(contents, fileName, cast))
+        return {};
+    return cast;
+}
+
 
-    try
+template <class Cast>
+bool ssp::ParseUnb(std::string_view contents, const std::string& fileName, Cast& cast)
+{
+    const char* p = contents.data();
+    int lineNum = 0;
+    unb::SParseError err;
+
+    if (!unb::ParseRecord(p, p + contents.size(), cast, lineNum, err))
     {
-        unb::ParseVersion(inFile);
+        fmt::print("Error reading Unb file ({}): {} on line #{}\n", fileName, err.msg, err.lineNum);
+        return false;
+    }
+
+    cast.desc = "University of New Brunswick";
+    AssignString(cast.fileName, fileName);
+
+    return true;
+}
+
+template bool ssp::ParseUnb(std::string_view, const std::string&, SCast&);
+template bool ssp::ParseUnb(std::string_view, const std::string&, pmr::SCast&);
+
 
-        if (!unb::ParseDateTime(inFile, cast))
-            throw "Could not parse date/time";
+size_t ssp::ReadUnbCasts(const std::string& path, SCastTable& table, unsigned int numThreads)
+{
+    namespace fs = std::filesystem;
 
-        if (!unb::ParseLatLon(inFile, cast))
-            throw "Could not parse latitude/longitude";
+    std::error_code ec;
+    if (!fs::is_directory(path, ec))
+        return unb::ReadRecords(path, table);
 
-        if (!unb::ReadEntries(inFile, cast))
-            throw "Could not read entries";
+    std::vector<std::string> fileNames;
+    for (const auto& dirEntry : fs::directory_iterator(path, ec))
+    {
+        if (dirEntry.is_regular_file(ec) && Lowercase(dirEntry.path().extension().string()) == ".unb")
+            fileNames.push_back(dirEntry.path().string());
     }
-    catch (std::string err)
+    std::sort(begin(fileNames), end(fileNames));  // Keep the output order independent of the directory listing
+
+    // The files are scanned once to find their record counts and sizes, then the table columns are sized for all
+    // of them and each file is parsed again straight into its slice of the columns.
+    std::vector<unb::SFileRecords> files(fileNames.size());
+    ParallelFor(fileNames.size(), numThreads, [&](size_t n)
     {
-        //std::cout << "Error reading Unb file (" << fileName << "): " << err << "\n";
-        fmt::print("Error reading Unb file ({}): {}\n", fileName, err);
-        return {};
+        files[n] = unb::ScanRecords(fileNames[n]);
+    });
+
+    size_t numCasts = 0;
+    size_t numEntries = table.depth.size();
+    for (auto& file : files)
+    {
+        file.firstEntry = numEntries;
+        numEntries += file.numEntries;
+        numCasts += file.headers.size();
     }
 
-    cast.desc = "University of New Brunswick";
-    cast.fileName = fileName;
+    for (auto* column : { &table.depth, &table.c, &table.temp, &table.salinity, &table.pressure,
+        &table.density, &table.sigmaT, &table.n2 })
+        column->resize(numEntries, 0.0);
+    table.flags.resize(numEntries, 0);
+    for (size_t n = 0; n < files.size(); ++n)
+    {
+        size_t offset = files[n].firstEntry;
+        for (const auto& header : files[n].headers)
+        {
+            offset += header.numEntries;
+            table.offsets.push_back(offset);
+            table.fileNames.push_back(fileNames[n]);
+            table.times.push_back(header.time);
+            table.lats.push_back(header.lat);
+            table.lons.push_back(header.lon);
+        }
+    }
 
-    return cast;
+    ParallelFor(fileNames.size(), numThreads, [&](size_t n)
+    {
+        unb::FillRecords(fileNames[n], files[n], table);
+    });
+
+    return numCasts;
 }
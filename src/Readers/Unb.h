@@ -31,9 +31,15 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 #include <SspCpp/Cast.h>
+#include <SspCpp/CastTable.h>
 
 namespace ssp
 {
     std::optional<SCast> ReadUnb(const std::string& fileName);
+
+    //! Parses the first record from text in memory. Instantiated for SCast and pmr::SCast.
+    template <class Cast>
+    bool ParseUnb(std::string_view contents, const std::string& fileName, Cast& cast);
 };
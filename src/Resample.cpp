@@ -0,0 +1,308 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Resample.cpp
+  * \brief  Resampling of casts onto a common depth grid
+  */
+
+#include "pch.h"
+#include <SspCpp/Resample.h>
+#include <cmath>
+#include <limits>
+#include "Parallel.h"
+
+
+namespace ssp::resample
+{
+    enum eChannel { ChanC, ChanTemp, ChanSalinity, ChanPressure, ChanDensity, ChanSigmaT, ChanN2, NumChannels };
+
+    constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    //! One cast as separate columns, pointing either into a table or into per-thread buffers
+    struct SColumns
+    {
+        const double* depth = nullptr;
+        const double* channel[NumChannels] = {};
+        size_t count = 0;
+    };
+
+
+    /*!
+     * \brief Linear interpolation of sorted samples onto the grid
+     *
+     * Every sample pair covers a run of grid depths that can be computed directly, so the inner loop is
+     * branch-free. Its counter is an int offset into the run, because SSE2 can only convert 32-bit integers
+     * to double in vector form (CheckGrid keeps grid.count within an int).
+     */
+    void Interpolate(const double* depth, const double* value, size_t count, const SDepthGrid& grid, double* out)
+    {
+        std::fill(out, out + grid.count, NaN);
+        if (count == 0)
+            return;
+
+        const double invStep = 1.0 / grid.step;
+        const auto FirstAtOrDeeper = [&](double d)
+        {
+            const double pos = std::ceil((d - grid.start) * invStep);
+            return static_cast<size_t>(std::clamp(pos, 0.0, static_cast<double>(grid.count)));
+        };
+
+        // Pairs of neighbouring samples with finite depths (a bad depth is stepped over, not turned into a gap)
+        size_t k = 0;
+        while (k < count && !std::isfinite(depth[k]))
+            ++k;
+        size_t deepest = k;
+        for (size_t next = k + 1; next < count; ++next)
+        {
+            if (!std::isfinite(depth[next]))
+                continue;
+            const size_t prev = k;
+            k = deepest = next;
+
+            const double d0 = depth[prev], d1 = depth[next];
+            if (!(d1 > d0))
+                continue;  // Duplicate depth
+            const double v0 = value[prev];
+            const double slope = (value[next] - v0) / (d1 - d0);
+
+            const size_t first = FirstAtOrDeeper(d0);
+            const size_t last = FirstAtOrDeeper(d1);  // Exclusive; d1 is handled by the next pair or below
+            const double base = grid.Depth(first) - d0;
+            const int runLength = static_cast<int>(last - first);
+            double* run = out + first;
+            for (int n = 0; n < runLength; ++n)
+                run[n] = v0 + slope * (base + n * grid.step);
+        }
+
+        // A grid depth landing exactly on the last sample
+        if (deepest == count)
+            return;  // No finite depths
+        const double pos = (depth[deepest] - grid.start) * invStep;
+        if (pos >= 0 && pos < grid.count && pos == std::floor(pos))
+            out[static_cast<size_t>(pos)] = value[deepest];
+
+        return;
+    }
+
+
+    //! Average of all samples within half a grid step of each grid depth
+    void BinAverage(const double* depth, const double* value, size_t count, const SDepthGrid& grid, double* out,
+        std::vector<double>& numInBin)
+    {
+        std::fill(out, out + grid.count, 0.0);
+        numInBin.assign(grid.count, 0.0);
+
+        const double invStep = 1.0 / grid.step;
+        for (size_t k = 0; k < count; ++k)
+        {
+            const double bin = std::floor((depth[k] - grid.start) * invStep + 0.5);
+            if (!(bin >= 0 && bin < grid.count))
+                continue;  // Outside the grid, or not a finite depth
+            const size_t n = static_cast<size_t>(bin);
+            out[n] += value[k];
+            numInBin[n] += 1.0;
+        }
+
+        for (size_t n = 0; n < grid.count; ++n)
+            out[n] = (numInBin[n] > 0) ? out[n] / numInBin[n] : NaN;
+
+        return;
+    }
+
+
+    //! Checks that the grid has a finite start and a positive step
+    bool CheckGrid(const SDepthGrid& grid)
+    {
+        if (grid.step > 0 && std::isfinite(grid.step) && std::isfinite(grid.start) &&
+            grid.count <= static_cast<size_t>(std::numeric_limits<int>::max()))
+            return true;
+        std::cout << "Depth grid must have a finite start, a positive step and at most INT_MAX depths\n";
+        return false;
+    }
+
+
+    //! Sets up the output matrices for the channels that are populated
+    SResampledCasts Allocate(const SDepthGrid& grid, size_t numCasts, const bool (&populated)[NumChannels])
+    {
+        SResampledCasts result;
+        result.grid = grid;
+        result.numCasts = numCasts;
+
+        const size_t size = grid.count * numCasts;
+        if (populated[ChanC]) result.c.resize(size);
+        if (populated[ChanTemp]) result.temp.resize(size);
+        if (populated[ChanSalinity]) result.salinity.resize(size);
+        if (populated[ChanPressure]) result.pressure.resize(size);
+        if (populated[ChanDensity]) result.density.resize(size);
+        if (populated[ChanSigmaT]) result.sigmaT.resize(size);
+        if (populated[ChanN2]) result.n2.resize(size);
+
+        return result;
+    }
+
+
+    //! Resamples the populated channels of cast n
+    void ResampleColumns(const SColumns& cols, size_t n, eResampleMode mode, SResampledCasts& result)
+    {
+        thread_local std::vector<double> numInBin;
+
+        std::vector<double>* outputs[NumChannels] = { &result.c, &result.temp, &result.salinity, &result.pressure,
+            &result.density, &result.sigmaT, &result.n2 };
+        for (int chan = 0; chan < NumChannels; ++chan)
+        {
+            if (outputs[chan]->empty())
+                continue;
+            double* out = outputs[chan]->data() + n * result.grid.count;
+            if (mode == eResampleMode::Interpolate)
+                Interpolate(cols.depth, cols.channel[chan], cols.count, result.grid, out);
+            else
+                BinAverage(cols.depth, cols.channel[chan], cols.count, result.grid, out, numInBin);
+        }
+
+        return;
+    }
+
+
+    //! Flags the channels that have any non-zero values in the cast
+    void FindPopulated(const SCast& cast, bool (&populated)[NumChannels])
+    {
+        for (const auto& entry : cast.entries)
+        {
+            populated[ChanC] |= (entry.c != 0);
+            populated[ChanTemp] |= (entry.temp != 0);
+            populated[ChanSalinity] |= (entry.salinity != 0);
+            populated[ChanPressure] |= (entry.pressure != 0);
+            populated[ChanDensity] |= (entry.density != 0);
+            populated[ChanSigmaT] |= (entry.sigmaT != 0);
+            populated[ChanN2] |= (entry.n2 != 0);
+        }
+
+        return;
+    }
+
+
+    //! Copies a cast's entries into per-thread columns
+    SColumns GatherColumns(const SCast& cast)
+    {
+        thread_local std::vector<double> buffers[NumChannels + 1];
+
+        const size_t count = cast.entries.size();
+        for (auto& buffer : buffers)
+            buffer.resize(count);
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            const auto& entry = cast.entries[k];
+            buffers[0][k] = entry.depth;
+            buffers[1 + ChanC][k] = entry.c;
+            buffers[1 + ChanTemp][k] = entry.temp;
+            buffers[1 + ChanSalinity][k] = entry.salinity;
+            buffers[1 + ChanPressure][k] = entry.pressure;
+            buffers[1 + ChanDensity][k] = entry.density;
+            buffers[1 + ChanSigmaT][k] = entry.sigmaT;
+            buffers[1 + ChanN2][k] = entry.n2;
+        }
+
+        SColumns cols;
+        cols.depth = buffers[0].data();
+        for (int chan = 0; chan < NumChannels; ++chan)
+            cols.channel[chan] = buffers[1 + chan].data();
+        cols.count = count;
+        return cols;
+    }
+};  // End namespace ssp::resample
+
+
+namespace ssp
+{
+
+SResampledCasts ResampleCasts(const std::vector<SCast>& casts, const SDepthGrid& grid, eResampleMode mode,
+    unsigned int numThreads)
+{
+    using namespace resample;
+
+    if (!CheckGrid(grid))
+        return {};
+
+    bool populated[NumChannels] = {};
+    for (const auto& cast : casts)
+        FindPopulated(cast, populated);
+
+    SResampledCasts result = Allocate(grid, casts.size(), populated);
+    ParallelFor(casts.size(), numThreads, [&](size_t n)
+        {
+            ResampleColumns(GatherColumns(casts[n]), n, mode, result);
+        });
+
+    return result;
+}
+
+
+SResampledCasts ResampleCasts(const SCastTable& table, const SDepthGrid& grid, eResampleMode mode,
+    unsigned int numThreads)
+{
+    using namespace resample;
+
+    if (!CheckGrid(grid))
+        return {};
+
+    const std::vector<double>* columns[NumChannels] = { &table.c, &table.temp, &table.salinity, &table.pressure,
+        &table.density, &table.sigmaT, &table.n2 };
+    bool populated[NumChannels] = {};
+    for (int chan = 0; chan < NumChannels; ++chan)
+        populated[chan] = std::any_of(begin(*columns[chan]), end(*columns[chan]), [](double v) { return v != 0; });
+
+    SResampledCasts result = Allocate(grid, table.NumCasts(), populated);
+    ParallelFor(table.NumCasts(), numThreads, [&](size_t n)
+        {
+            SColumns cols;
+            const size_t first = table.offsets[n];
+            cols.depth = table.depth.data() + first;
+            for (int chan = 0; chan < NumChannels; ++chan)
+                cols.channel[chan] = columns[chan]->data() + first;
+            cols.count = table.offsets[n + 1] - first;
+            ResampleColumns(cols, n, mode, result);
+        });
+
+    return result;
+}
+
+
+SResampledCasts ResampleCast(const SCast& cast, const SDepthGrid& grid, eResampleMode mode)
+{
+    using namespace resample;
+
+    if (!CheckGrid(grid))
+        return {};
+
+    bool populated[NumChannels] = {};
+    FindPopulated(cast, populated);
+
+    SResampledCasts result = Allocate(grid, 1, populated);
+    ResampleColumns(GatherColumns(cast), 0, mode, result);
+    return result;
+}
+
+};  // End namespace ssp
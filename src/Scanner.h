@@ -0,0 +1,199 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Scanner.h
+  * \brief  Allocation-free helpers for scanning numbers out of text held in memory
+  *
+  * These work on [p, end) character ranges and advance p past whatever they consume, so a whole file
+  * can be read into one buffer and parsed without creating a string per line or per field.
+  */
+
+#pragma once
+
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace ssp::scan
+{
+    inline bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    //! Skips spaces and tabs (but not newlines)
+    inline const char* SkipSpace(const char* p, const char* end)
+    {
+        while (p < end && IsSpace(*p))
+            ++p;
+        return p;
+    }
+
+    //! Returns a pointer to the '\n' ending the line that p is in (or end)
+    inline const char* LineEnd(const char* p, const char* end)
+    {
+        const void* nl = std::memchr(p, '\n', end - p);
+        return nl ? static_cast<const char*>(nl) : end;
+    }
+
+    //! Moves p to the start of the next line
+    inline void NextLine(const char*& p, const char* end)
+    {
+        p = LineEnd(p, end);
+        if (p < end)
+            ++p;
+    }
+
+    //! Reads the current line (without the line ending) and moves p to the start of the next line
+    inline bool GetLine(const char*& p, const char* end, std::string_view& line)
+    {
+        if (p >= end)
+            return false;
+        const char* lineEnd = LineEnd(p, end);
+        const char* trimmedEnd = lineEnd;
+        if (trimmedEnd > p && *(trimmedEnd - 1) == '\r')
+            --trimmedEnd;
+        line = std::string_view(p, trimmedEnd - p);
+        p = (lineEnd < end) ? lineEnd + 1 : end;
+        return true;
+    }
+
+    //! Parses a floating point value after optional leading spaces. Does not cross line boundaries.
+    inline bool ParseDouble(const char*& p, const char* end, double& value)
+    {
+        p = SkipSpace(p, end);
+        if (p < end && *p == '+')  // from_chars does not accept a leading +
+            ++p;
+        auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+            return false;
+        p = result.ptr;
+        return true;
+    }
+
+    //! Parses an integer value after optional leading spaces. Does not cross line boundaries.
+    inline bool ParseInt(const char*& p, const char* end, int& value)
+    {
+        p = SkipSpace(p, end);
+        if (p < end && *p == '+')
+            ++p;
+        auto result = std::from_chars(p, end, value);
+        if (result.ec != std::errc())
+            return false;
+        p = result.ptr;
+        return true;
+    }
+
+    //! Skips one whitespace-separated field on the current line. Returns false if there was none.
+    inline bool SkipField(const char*& p, const char* end)
+    {
+        p = SkipSpace(p, end);
+        const char* start = p;
+        while (p < end && *p != '\n' && !IsSpace(*p))
+            ++p;
+        return p != start;
+    }
+
+    //! Gets the next whitespace-separated field on the current line. Returns false if there was none.
+    inline bool NextField(const char*& p, const char* end, std::string_view& field)
+    {
+        p = SkipSpace(p, end);
+        const char* start = p;
+        while (p < end && *p != '\n' && !IsSpace(*p))
+            ++p;
+        field = std::string_view(start, p - start);
+        return p != start;
+    }
+
+    //! Converts a whole field to a floating point value (fails if anything is left over)
+    inline bool ToDouble(std::string_view field, double& value)
+    {
+        const char* p = field.data();
+        const char* end = p + field.size();
+        if (p < end && *p == '+')
+            ++p;
+        auto result = std::from_chars(p, end, value);
+        return result.ec == std::errc() && result.ptr == end;
+    }
+
+    //! Whether only whitespace remains before the end of the line
+    inline bool AtLineEnd(const char* p, const char* end)
+    {
+        p = SkipSpace(p, end);
+        return p >= end || *p == '\n';
+    }
+
+    //! Whether the text begins with prefix
+    inline bool StartsWith(std::string_view text, std::string_view prefix)
+    {
+        return text.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    //! Removes leading and trailing whitespace
+    inline std::string_view Trim(std::string_view text)
+    {
+        while (!text.empty() && (IsSpace(text.front()) || text.front() == '\n'))
+            text.remove_prefix(1);
+        while (!text.empty() && (IsSpace(text.back()) || text.back() == '\n'))
+            text.remove_suffix(1);
+        return text;
+    }
+
+    //! Number of lines in [p, end), counting a last line without a '\n'. Useful for reserving entries.
+    inline size_t CountLines(const char* p, const char* end)
+    {
+        size_t count = 0;
+        for (; p < end; ++count)
+            NextLine(p, end);
+        return count;
+    }
+
+    /*!
+     * \brief Reads an entire file into memory
+     *
+     * The stream is unbuffered, since the file is read in one go, so the only allocation is the contents
+     * (which may use any allocator).
+     */
+    template <class String>
+    bool ReadFile(const std::string& fileName, String& contents)
+    {
+        std::ifstream inFile;
+        inFile.rdbuf()->pubsetbuf(nullptr, 0);
+        inFile.open(fileName, std::ios::binary | std::ios::ate);
+        if (!inFile)
+            return false;
+
+        auto size = inFile.tellg();
+        if (size < 0)
+            return false;
+        contents.resize(static_cast<size_t>(size));
+        inFile.seekg(0);
+        if (size > 0 && !inFile.read(&contents[0], size))
+            return false;
+        return true;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,204 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   SharedMemory.cpp
+  * \brief  Named shared memory regions that several processes can map
+  */
+
+#include "pch.h"
+#include "SharedMemory.h"
+#include <algorithm>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+namespace ssp
+{
+
+#ifdef _WIN32
+
+bool SharedMemory::Create(const std::string& regionName, size_t regionSize)
+{
+    Close();
+
+    const unsigned long long size64 = regionSize;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xffffffff), regionName.c_str());
+    if (mapping == nullptr)
+        return false;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, regionSize);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    mappingHandle = mapping;
+    data = static_cast<char*>(view);
+    size = regionSize;
+    name = regionName;
+    owner = true;
+    return true;
+}
+
+
+bool SharedMemory::Open(const std::string& regionName)
+{
+    Close();
+
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, regionName.c_str());
+    if (mapping == nullptr)
+        return false;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(view, &info, sizeof(info));
+
+    mappingHandle = mapping;
+    data = static_cast<char*>(view);
+    size = info.RegionSize;
+    name = regionName;
+    owner = false;
+    return true;
+}
+
+
+void SharedMemory::Close()
+{
+    // Windows removes the mapping when its last handle is closed
+    if (data)
+        UnmapViewOfFile(data);
+    if (mappingHandle)
+        CloseHandle(mappingHandle);
+
+    data = nullptr;
+    size = 0;
+    mappingHandle = nullptr;
+    owner = false;
+    return;
+}
+
+#else
+
+//! POSIX shared memory names have to start with a single '/'
+static std::string PosixName(const std::string& name)
+{
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+
+bool SharedMemory::Create(const std::string& regionName, size_t regionSize)
+{
+    Close();
+
+    const std::string posixName = PosixName(regionName);
+    const int fd = shm_open(posixName.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+
+    // Only reuse a region left behind by this user, and take away any write access it gave to others
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_uid != geteuid() || ((info.st_mode & 022) != 0 && fchmod(fd, 0644) != 0) ||
+        (static_cast<size_t>(info.st_size) < regionSize && ftruncate(fd, regionSize) != 0))
+    {
+        close(fd);
+        return false;
+    }
+    const size_t mapSize = std::max(regionSize, static_cast<size_t>(info.st_size));
+
+    void* view = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    data = static_cast<char*>(view);
+    size = mapSize;
+    name = posixName;
+    owner = true;
+    return true;
+}
+
+
+bool SharedMemory::Open(const std::string& regionName)
+{
+    Close();
+
+    const std::string posixName = PosixName(regionName);
+    const int fd = shm_open(posixName.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    data = static_cast<char*>(view);
+    size = static_cast<size_t>(info.st_size);
+    name = posixName;
+    owner = false;
+    return true;
+}
+
+
+void SharedMemory::Close()
+{
+    if (data)
+        munmap(data, size);
+    if (owner)
+        shm_unlink(name.c_str());
+
+    data = nullptr;
+    size = 0;
+    owner = false;
+    return;
+}
+
+#endif
+
+};  // End namespace ssp
@@ -0,0 +1,76 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   SharedMemory.h
+  * \brief  Named shared memory regions that several processes can map
+  */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+
+namespace ssp
+{
+    /*!
+     * \brief A named shared memory region (POSIX shm_open or a Windows named file mapping)
+     *
+     * Only the creator can write to the region. On POSIX systems other users can map it read-only (mode 0644).
+     */
+    class SharedMemory
+    {
+    public:
+        SharedMemory() = default;
+        ~SharedMemory() { Close(); }
+        SharedMemory(const SharedMemory&) = delete;
+        SharedMemory& operator=(const SharedMemory&) = delete;
+
+        /*!
+         * \brief Creates the region (or opens an existing one) with at least size bytes. The creator removes the name on Close.
+         *
+         * An existing POSIX region is only reused if it belongs to the current user.
+         */
+        bool Create(const std::string& name, size_t size);
+
+        //! Opens a region created by another process, mapping all of it read-only (Data must not be written to)
+        bool Open(const std::string& name);
+
+        void Close();
+
+        char* Data() const { return data; }
+        size_t Size() const { return size; }
+        bool IsOpen() const { return data != nullptr; }
+
+    private:
+        char* data = nullptr;
+        size_t size = 0;
+        std::string name;
+        bool owner = false;
+#ifdef _WIN32
+        void* mappingHandle = nullptr;
+#endif
+    };
+};
@@ -0,0 +1,300 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   SharedProfile.cpp
+  * \brief  Publishing the current cast to other processes through shared memory
+  *
+  * Region layout: SRegionHeader, then maxEntries SCastEntry records starting on a cache line.
+  * The sequence number is odd while the publisher is writing. A reader copies the cast between two
+  * loads of the sequence and keeps the copy only if both loads saw the same even value.
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/SharedProfile.h"
+#include "SharedMemory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+
+namespace ssp
+{
+namespace shared
+{
+    constexpr uint64_t magic = 0x31464f5250505353;  // "SSPPROF1"
+    constexpr uint32_t layoutVersion = 3;  // Changes with the SCastEntry layout
+    constexpr size_t descSize = 64;
+    constexpr size_t fileNameSize = 256;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared sequence numbers need lock free 64-bit atomics");
+    static_assert(std::is_trivially_copyable<SCastEntry>::value, "Cast entries are copied into shared memory as bytes");
+
+    //! Fixed size copy of everything in SCast except the entries
+    struct SCastHeader
+    {
+        int32_t time[9];  //!< tm_sec, tm_min, tm_hour, tm_mday, tm_mon, tm_year, tm_wday, tm_yday, tm_isdst
+        uint32_t numEntries;
+        double lat;
+        double lon;
+        char desc[descSize];
+        char fileName[fileNameSize];
+    };
+
+    struct SRegionHeader
+    {
+        std::atomic<uint64_t> magic;  //!< Stored last by the publisher, so a subscriber never sees a half built header
+        uint32_t layoutVersion;
+        uint32_t maxEntries;
+        alignas(64) std::atomic<uint64_t> sequence;
+        alignas(64) SCastHeader cast;
+    };
+
+    constexpr size_t entriesOffset = (sizeof(SRegionHeader) + 63) / 64 * 64;
+
+    static SCastEntry* Entries(char* region)
+    {
+        return reinterpret_cast<SCastEntry*>(region + entriesOffset);
+    }
+
+    static void CopyString(char* dest, size_t destSize, const std::string& src)
+    {
+        const size_t len = std::min(src.size(), destSize - 1);
+        std::memcpy(dest, src.data(), len);
+        std::memset(dest + len, 0, destSize - len);
+        return;
+    }
+
+    static void Pack(const SCast& cast, SCastHeader& header)
+    {
+        const std::tm& t = cast.time;
+        const int32_t time[9] = { t.tm_sec, t.tm_min, t.tm_hour, t.tm_mday, t.tm_mon, t.tm_year, t.tm_wday, t.tm_yday, t.tm_isdst };
+        std::memcpy(header.time, time, sizeof(time));
+        header.numEntries = static_cast<uint32_t>(cast.entries.size());
+        header.lat = cast.lat;
+        header.lon = cast.lon;
+        CopyString(header.desc, descSize, cast.desc);
+        CopyString(header.fileName, fileNameSize, cast.fileName);
+        return;
+    }
+
+    static void Unpack(const SCastHeader& header, SCast& cast)
+    {
+        std::tm& t = cast.time;
+        t.tm_sec = header.time[0]; t.tm_min = header.time[1]; t.tm_hour = header.time[2];
+        t.tm_mday = header.time[3]; t.tm_mon = header.time[4]; t.tm_year = header.time[5];
+        t.tm_wday = header.time[6]; t.tm_yday = header.time[7]; t.tm_isdst = header.time[8];
+        cast.lat = header.lat;
+        cast.lon = header.lon;
+        cast.desc.assign(header.desc, strnlen(header.desc, descSize));
+        cast.fileName.assign(header.fileName, strnlen(header.fileName, fileNameSize));
+        return;
+    }
+};  // End namespace shared
+
+
+using namespace shared;
+
+struct ProfilePublisher::SImpl
+{
+    SharedMemory memory;
+    SRegionHeader* header = nullptr;
+};
+
+struct ProfileSubscriber::SImpl
+{
+    SharedMemory memory;  //!< Mapped read-only
+    const SRegionHeader* header = nullptr;
+    uint32_t maxEntries = 0;  //!< Copied on Open, after checking it against the region size
+};
+
+
+ProfilePublisher::ProfilePublisher() : impl(std::make_unique<SImpl>()) {}
+ProfilePublisher::~ProfilePublisher() = default;
+
+
+bool ProfilePublisher::Open(const std::string& name, size_t maxEntries)
+{
+    Close();
+    if (maxEntries == 0 || maxEntries > UINT32_MAX)
+        return false;
+
+    if (!impl->memory.Create(name, entriesOffset + maxEntries * sizeof(SCastEntry)))
+    {
+        fmt::print("Unable to create shared memory region {}\n", name);
+        return false;
+    }
+
+    // A region left behind by a publisher that crashed is reused, so start it over from scratch
+    SRegionHeader* header = new (impl->memory.Data()) SRegionHeader;
+    header->magic.store(0, std::memory_order_relaxed);
+    header->layoutVersion = layoutVersion;
+    header->maxEntries = static_cast<uint32_t>(maxEntries);
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->cast = {};
+    header->magic.store(magic, std::memory_order_release);
+
+    impl->header = header;
+    return true;
+}
+
+
+void ProfilePublisher::Close()
+{
+    impl->header = nullptr;
+    impl->memory.Close();
+    return;
+}
+
+
+bool ProfilePublisher::Publish(const SCast& cast)
+{
+    SRegionHeader* header = impl->header;
+    if (!header || cast.entries.size() > header->maxEntries)
+        return false;
+
+    // Odd sequence tells readers an update is in progress. The fence keeps the data writes below it.
+    const uint64_t seq = header->sequence.load(std::memory_order_relaxed);
+    header->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Pack(cast, header->cast);
+    if (!cast.entries.empty())
+        std::memcpy(Entries(impl->memory.Data()), cast.entries.data(), cast.entries.size() * sizeof(SCastEntry));
+
+    header->sequence.store(seq + 2, std::memory_order_release);
+    return true;
+}
+
+
+uint64_t ProfilePublisher::Version() const
+{
+    return impl->header ? impl->header->sequence.load(std::memory_order_relaxed) / 2 : 0;
+}
+
+
+ProfileSubscriber::ProfileSubscriber() : impl(std::make_unique<SImpl>()) {}
+ProfileSubscriber::~ProfileSubscriber() = default;
+
+
+bool ProfileSubscriber::Open(const std::string& name)
+{
+    Close();
+    if (!impl->memory.Open(name))
+        return false;
+
+    // maxEntries is read once (after the magic), so the size checked here is the one every Read clamps to
+    const auto* header = reinterpret_cast<const SRegionHeader*>(impl->memory.Data());
+    const bool valid = impl->memory.Size() >= entriesOffset && header->magic.load(std::memory_order_acquire) == magic &&
+        header->layoutVersion == layoutVersion;
+    const uint32_t maxEntries = valid ? header->maxEntries : 0;
+    if (!valid || impl->memory.Size() < entriesOffset + size_t(maxEntries) * sizeof(SCastEntry))
+    {
+        fmt::print("Shared memory region {} does not hold published casts\n", name);
+        impl->memory.Close();
+        return false;
+    }
+
+    impl->header = header;
+    impl->maxEntries = maxEntries;
+    return true;
+}
+
+
+void ProfileSubscriber::Close()
+{
+    impl->header = nullptr;
+    impl->memory.Close();
+    return;
+}
+
+
+uint64_t ProfileSubscriber::Version() const
+{
+    return impl->header ? impl->header->sequence.load(std::memory_order_acquire) / 2 : 0;
+}
+
+
+bool ProfileSubscriber::Read(SCast& cast, uint64_t* version) const
+{
+    const SRegionHeader* header = impl->header;
+    if (!header)
+        return false;
+
+    const SCastEntry* entries = reinterpret_cast<const SCastEntry*>(impl->memory.Data() + entriesOffset);
+    SCastHeader local;
+    for (;;)
+    {
+        const uint64_t before = header->sequence.load(std::memory_order_acquire);
+        if (before == 0)
+            return false;
+        if (before & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // The count may be torn if an update overlaps, so clamp it before copying. The copy is thrown away then anyway.
+        std::memcpy(&local, &header->cast, sizeof(local));
+        const size_t count = std::min<size_t>(local.numEntries, impl->maxEntries);
+        cast.entries.resize(count);
+        if (count > 0)
+            std::memcpy(cast.entries.data(), entries, count * sizeof(SCastEntry));
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) == before)
+        {
+            Unpack(local, cast);
+            if (version)
+                *version = before / 2;
+            return true;
+        }
+    }
+}
+
+
+bool ProfileSubscriber::WaitForUpdate(uint64_t lastVersion, std::chrono::milliseconds timeout) const
+{
+    if (!impl->header)
+        return false;
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (int spin = 0; ; ++spin)
+    {
+        if (Version() > lastVersion)
+            return true;
+
+        if (spin < 1000)
+            continue;
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        if (spin < 2000)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+};  // End namespace ssp
@@ -29,8 +29,12 @@
 
 #include "pch.h"
 #include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <sstream>
+#include <unordered_set>
 #include <vector>
 #include <fmt/format.h>
 #ifdef SSP_MATPLOTLIB_CPP_SUPPORT
@@ -51,6 +55,10 @@
 #include "Readers/Simple.h"
 #include "Readers/Sonardyne.h"
 #include "Readers/Unb.h"
+#include "Writers/Writers.h"
+#include "ParseCache.h"
+#include "Parallel.h"
+#include "Scanner.h"
 
 
 namespace ssp
@@ -132,12 +140,13 @@ eCastType DetermineFileType(const std::string& fileName)
 }
 
 
-std::optional<SCast> ReadCast(const std::string& fileName, eCastType type)
+//! Reads a file of a known type with its reader
+static std::optional<SCast> ReadCastFile(const std::string& fileName, eCastType type, eSoundSpeedEquation equation)
 {
     switch (type)
     {
         case eCastType::Aoml:
-            return ReadAoml(fileName);
+            return ReadAoml(fileName, equation);
 
         case eCastType::Asvp:
             return ReadAsvp(fileName);
@@ -146,10 +155,10 @@ std::optional<SCast> ReadCast(const std::string& fileName, eCastType type)
             return ReadHypack(fileName);
 
         case eCastType::Oceanscience:
-            return ReadOceanscience(fileName);
+            return ReadOceanscience(fileName, equation);
 
         case eCastType::SeaAndSun:
-            return ReadSeaAndSun(fileName);
+            return ReadSeaAndSun(fileName, equation);
 
         case eCastType::SeaBirdCnv:
             return ReadSeaBirdCnv(fileName);
@@ -158,7 +167,11 @@ std::optional<SCast> ReadCast(const std::string& fileName, eCastType type)
             return ReadSeaBirdTsv(fileName);
 
         case eCastType::Simple:
-            return ReadSimple(fileName);
+        {
+            SSimpleFormat format;
+            format.equation = equation;
+            return ReadSimple(fileName, format);
+        }
 
         case eCastType::Sonardyne:
             return ReadSonardyne(fileName);
@@ -166,126 +179,218 @@ std::optional<SCast> ReadCast(const std::string& fileName, eCastType type)
         case eCastType::Unb:
             return ReadUnb(fileName);
 
-        case eCastType::Unknown:  // Fallthrough
         default:
+            return {};
+    }
+}
+
+
+std::optional<SCast> ReadCast(const std::string& fileName, eCastType type, eSoundSpeedEquation equation)
+{
+    if (type == eCastType::Unknown)
+    {
+        type = DetermineFileType(fileName);
+        if (type == eCastType::Unknown)
         {
-            //std::cout << "No support for determining SSP file types\n";
-            eCastType type = DetermineFileType(fileName);
-            if (type == eCastType::Unknown)
-            {
-                std::cout << "Could not determine SSP file type from " << fileName << "\n";
-                return {};
-            }
-            return ReadCast(fileName, type);
+            std::cout << "Could not determine SSP file type from " << fileName << "\n";
+            return {};
         }
     }
 
-    return {};
+    // Cache entries are always computed with the default equation
+    if (cache::IsEnabled() && equation == eSoundSpeedEquation::WongZhu)
+        return cache::ReadThrough(fileName, type, [](const std::string& file, eCastType fileType) {
+            return ReadCastFile(file, fileType, eSoundSpeedEquation::WongZhu);
+        });
+    return ReadCastFile(fileName, type, equation);
 }
 
 
-//
-// Sound speed computation functions
-//
-
-double WongZhuCw(double T, double P)
+bool ReadCast(const std::string& fileName, pmr::SCast& cast, eCastType type, eSoundSpeedEquation equation)
 {
-    const double C00 = 1402.388;
-    const double C01 = 5.03830;
-    const double C02 = -5.81090e-2;
-    const double C03 = 3.3432e-4;
-    const double C04 = -1.47797e-6;
-    const double C05 = 3.1419e-9;
-    const double C10 = 0.153563;
-    const double C11 = 6.8999e-4;
-    const double C12 = -8.1829e-6;
-    const double C13 = 1.3632e-7;
-    const double C14 = -6.1260e-10;
-    const double C20 = 3.1260e-5;
-    const double C21 = -1.7111e-6;
-    const double C22 = 2.5986e-8;
-    const double C23 = -2.5353e-10;
-    const double C24 = 1.0415e-12;
-    const double C30 = -9.7729e-9;
-    const double C31 = 3.8513e-10;
-    const double C32 = -2.3654e-12;
-
-    double C0 = C00 + T * (C01 + T * (C02 + T * (C03 + T * (C04 + T * C05))));
-    double C1 = (C10 + T * (C11 + T * (C12 + T * (C13 + T * C14))));
-    double C2 = (C20 + T * (C21 + T * (C22 + T * (C23 + T * C24))));
-    double C3 = (C30 + T * (C31 + T * C32));
-
-    double Cw = C0 + C1 * P + C2 * P*P + C3 * P*P*P;
-    return Cw;
+    if (type == eCastType::Unknown)
+    {
+        type = DetermineFileType(fileName);
+        if (type == eCastType::Unknown)
+        {
+            std::cout << "Could not determine SSP file type from " << fileName << "\n";
+            return false;
+        }
+    }
+
+    std::pmr::string contents(cast.entries.get_allocator().resource());
+    if (!scan::ReadFile(fileName, contents))
+    {
+        std::cout << "Could not open file " << fileName << "\n";
+        return false;
+    }
+
+    switch (type)
+    {
+        case eCastType::Aoml:
+            return ParseAoml(contents, fileName, cast, equation);
+
+        case eCastType::Asvp:
+            return ParseAsvp(contents, fileName, cast);
+
+        case eCastType::Hypack:
+            return ParseHypack(contents, fileName, cast);
+
+        case eCastType::Oceanscience:
+            return ParseOceanscience(contents, fileName, cast, equation);
+
+        case eCastType::SeaAndSun:
+            return ParseSeaAndSun(contents, fileName, cast, equation);
+
+        case eCastType::SeaBirdCnv:
+            return ParseSeaBirdCnv(contents, fileName, cast);
+
+        case eCastType::SeaBirdTsv:
+            return ParseSeaBirdTsv(contents, fileName, cast);
+
+        case eCastType::Simple:
+        {
+            static const SSimpleFormat defaultFormat;  // Avoids allocating the column list for every cast
+            if (equation == defaultFormat.equation)
+                return ParseSimple(contents, fileName, defaultFormat, cast);
+            SSimpleFormat format;
+            format.equation = equation;
+            return ParseSimple(contents, fileName, format, cast);
+        }
+
+        case eCastType::Sonardyne:
+            return ParseSonardyne(contents, fileName, cast);
+
+        case eCastType::Unb:
+            return ParseUnb(contents, fileName, cast);
+
+        default:
+            return false;
+    }
 }
 
-double WongZhuA(double T, double P)
+
+bool WriteCast(const SCast& cast, eCastType type, std::string& buffer)
 {
-    const double A00 = 1.389;
-    const double A01 = -1.262e-2;
-    const double A02 = 7.166e-5;
-    const double A03 = 2.008e-6;
-    const double A04 = -3.21e-8;
-    const double A10 = 9.4742e-5;
-    const double A11 = -1.2583e-5;
-    const double A12 = -6.4928e-8;
-    const double A13 = 1.0515e-8;
-    const double A14 = -2.0142e-10;
-    const double A20 = -3.9064e-7;
-    const double A21 = 9.1061e-9;
-    const double A22 = -1.6009e-10;
-    const double A23 = 7.994e-12;
-    const double A30 = 1.100e-10;
-    const double A31 = 6.651e-12;
-    const double A32 = -3.391e-13;
-
-    double A0 = A00 + T * (A01 + T * (A02 + T * (A03 + T * A04)));
-    double A1 = (A10 + T * (A11 + T * (A12 + T * (A13 + T * A14))));
-    double A2 = (A20 + T * (A21 + T * (A22 + T * A23)));
-    double A3 = (A30 + T * (A31 + T * A32));
-
-    double A = A0 + A1 * P + A2 * P*P + A3 * P*P*P;
-    return A;
+    switch (type)
+    {
+        case eCastType::Asvp:
+            return WriteAsvp(cast, buffer);
+
+        case eCastType::Hypack:
+            return WriteHypack(cast, buffer);
+
+        case eCastType::SeaBirdTsv:
+            return WriteSeaBirdTsv(cast, buffer);
+
+        case eCastType::Sonardyne:
+            return WriteSonardyne(cast, buffer);
+
+        case eCastType::Unb:
+            return WriteUnb(cast, buffer);
+
+        default:
+            std::cout << "Writing is not supported for this file type\n";
+            return false;
+    }
 }
 
-double WongZhuB(double T, double P)
+
+bool WriteCast(const SCast& cast, eCastType type, std::ostream& out)
 {
-    const double B00 = -1.922e-2;
-    const double B01 = -4.42e-5;
-    const double B10 = 7.3637e-5;
-    const double B11 = 1.7950e-7;
+    std::string buffer;
+    buffer.reserve(32 * cast.entries.size() + 256);
+    if (!WriteCast(cast, type, buffer))
+        return false;
 
-    double B = B00 + B01*T + (B10 + B11*T) * P;
-    return B;
+    out.write(buffer.data(), buffer.size());
+    return static_cast<bool>(out);
 }
 
-double WongZhuD(double T, double P)
-{
-    const double D00 = 1.727e-3;
-    const double D10 = -7.9836e-6;
 
-    double D = D00 + D10 * P;
-    return D;
+std::string CastExtension(eCastType type)
+{
+    switch (type)
+    {
+        case eCastType::Asvp:        return ".asvp";
+        case eCastType::Hypack:      return ".vel";
+        case eCastType::SeaBirdTsv:  return ".tsv";
+        case eCastType::Sonardyne:   return ".pro";
+        case eCastType::Unb:         return ".unb";
+        default:                     return "";
+    }
 }
 
-double WongZhu(double temp, double salin, double pressure)
+
+size_t ConvertCasts(const std::vector<std::string>& inputFiles, const std::string& outputDir, eCastType outputType, unsigned int numThreads)
 {
-    // Temp: [0, 40] Celsius
-    // Salinity: [0, 40] parts per thousand (ppt)
-    // Pressure: [0, 1000] bar
+    namespace fs = std::filesystem;
+
+    const std::string ext = CastExtension(outputType);
+    if (ext == "")
+    {
+        std::cout << "Writing is not supported for this file type\n";
+        return 0;
+    }
+    // Only these formats can hold more than one cast per file
+    const bool bMultiCast = outputType == eCastType::Asvp || outputType == eCastType::Hypack;
+
+    std::error_code ec;
+    fs::create_directories(outputDir, ec);
+
+    // Inputs with the same name (a.asvp and a.vel, or dir1/a and dir2/a) would be written to the same file from
+    //  different threads, so later ones get the input extension and then a number added to their names
+    std::vector<fs::path> stems(inputFiles.size());
+    std::unordered_set<std::string> used;
+    for (size_t n = 0; n < inputFiles.size(); ++n)
+    {
+        const fs::path input(inputFiles[n]);
+        std::string name = input.stem().string();
+        if (used.count(name) != 0 && input.has_extension())
+            name += "_" + input.extension().string().substr(1);
+        const std::string base = name;
+        for (int suffix = 2; used.count(name) != 0; ++suffix)
+            name = fmt::format("{}_{}", base, suffix);
+        used.insert(name);
+        stems[n] = fs::path(outputDir) / name;
+    }
+
+    std::vector<char> converted(inputFiles.size(), 0);
+    ParallelFor(inputFiles.size(), numThreads, [&](size_t n)
+    {
+        // Each thread keeps its own buffer, so the formatting memory is reused from file to file
+        thread_local std::string buffer;
+        buffer.clear();
+
+        const fs::path& stem = stems[n];
+        size_t castNum = 0;
+        bool ok = true;
 
-    double T = temp;
-    double S = salin;
-    double P = pressure;
+        ReadCastsFromFile(inputFiles[n], eCastType::Unknown, [&](SCast& cast)
+        {
+            if (castNum > 0 && !bMultiCast)
+            {
+                // Formats with one cast per file get numbered files after the first
+                std::ofstream outFile(fmt::format("{}_{:03}{}", stem.string(), castNum, ext), std::ios::binary);
+                ok = ok && WriteCast(cast, outputType, outFile);
+            }
+            else
+            {
+                ok = ok && WriteCast(cast, outputType, buffer);
+            }
+            ++castNum;
+            return true;
+        });
 
-    double Cw = WongZhuCw(temp, pressure);
-    double A  = WongZhuA(temp, pressure);
-    double B  = WongZhuB(temp, pressure);
-    double D  = WongZhuD(temp, pressure);
+        if (castNum == 0 || !ok)
+            return;
 
-    double c = Cw + A*S + B*pow(S,3.0/2.0) + D*S*S;
+        std::ofstream outFile(stem.string() + ext, std::ios::binary);
+        outFile.write(buffer.data(), buffer.size());
+        converted[n] = static_cast<bool>(outFile);
+    });
 
-    return c;
+    return static_cast<size_t>(std::count(begin(converted), end(converted), 1));
 }
 
 
@@ -0,0 +1,236 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   SoundSpeedTable.cpp
+  * \brief  Precomputed temperature/salinity/pressure grid for fast approximate sound speed
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/SoundSpeedTable.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "Parallel.h"
+
+
+namespace ssp
+{
+namespace table
+{
+    //! Position of node n (of num) between min and max
+    inline double Node(double min, double max, size_t n, size_t num)
+    {
+        return min + (max - min) * n / (num - 1);
+    }
+
+    /*!
+     * \brief Largest second derivative of sound speed along each axis (T, S, P), from a coarse sampling
+     *
+     * Trilinear interpolation error along an axis is about step^2 * |f''| / 8, so these set how finely each
+     * axis needs to be divided.
+     */
+    static void Curvature(const STableRange& range, eSoundSpeedEquation equation, double latitudeDeg, double curvature[3])
+    {
+        constexpr size_t num = 9;
+        const double lo[3] = { range.tempMin, range.salinMin, range.pressureMin };
+        const double hi[3] = { range.tempMax, range.salinMax, range.pressureMax };
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            // The axis being differentiated is sampled finely, the other two on a coarse grid
+            const int other1 = (axis + 1) % 3, other2 = (axis + 2) % 3;
+            const size_t fine = 4 * (num - 1);
+            const double h = (hi[axis] - lo[axis]) / fine;
+            curvature[axis] = 0;
+            for (size_t i = 0; i < num; ++i)
+                for (size_t j = 0; j < num; ++j)
+                    for (size_t k = 1; k < fine; ++k)
+                    {
+                        double x[3];
+                        x[other1] = Node(lo[other1], hi[other1], i, num);
+                        x[other2] = Node(lo[other2], hi[other2], j, num);
+                        x[axis] = lo[axis] + k * h;
+
+                        auto f = [&](double offset) {
+                            double y[3] = { x[0], x[1], x[2] };
+                            y[axis] += offset;
+                            return SoundSpeed(equation, y[0], y[1], y[2], latitudeDeg);
+                        };
+                        curvature[axis] = std::max(curvature[axis], std::abs(f(h) - 2 * f(0) + f(-h)) / (h * h));
+                    }
+        }
+        return;
+    }
+};  // End namespace table
+
+
+std::optional<SSoundSpeedTable> BuildSoundSpeedTable(const STableRange& range, size_t numTemp, size_t numSalin,
+    size_t numPressure, eSoundSpeedEquation equation, double latitudeDeg, unsigned int numThreads)
+{
+    if (numTemp < 2 || numSalin < 2 || numPressure < 2 || !(range.tempMax > range.tempMin) ||
+        !(range.salinMax > range.salinMin) || !(range.pressureMax > range.pressureMin))
+        return {};
+
+    SSoundSpeedTable table;
+    table.range = range;
+    table.equation = equation;
+    table.latitudeDeg = latitudeDeg;
+    table.numTemp = numTemp;
+    table.numSalin = numSalin;
+    table.numPressure = numPressure;
+    const double lo[3] = { range.tempMin, range.salinMin, range.pressureMin };
+    const double hi[3] = { range.tempMax, range.salinMax, range.pressureMax };
+    const size_t num[3] = { numTemp, numSalin, numPressure };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        table.scale[axis] = (num[axis] - 1) / (hi[axis] - lo[axis]);
+        table.offset[axis] = -lo[axis] * table.scale[axis];
+        // Just below the last node, so the cell index never needs a separate check
+        table.lastCell[axis] = std::nextafter(static_cast<double>(num[axis] - 1), 0.0);
+    }
+    table.c.resize(numTemp * numSalin * numPressure);
+
+    // One temperature slab per work item, each filled with the batch kernel one pressure row at a time
+    ParallelFor(numTemp, numThreads, [&](size_t t) {
+        std::vector<double> temp(numPressure, table::Node(range.tempMin, range.tempMax, t, numTemp));
+        std::vector<double> salin(numPressure), pressure(numPressure);
+        for (size_t p = 0; p < numPressure; ++p)
+            pressure[p] = table::Node(range.pressureMin, range.pressureMax, p, numPressure);
+        for (size_t s = 0; s < numSalin; ++s)
+        {
+            std::fill(salin.begin(), salin.end(), table::Node(range.salinMin, range.salinMax, s, numSalin));
+            SoundSpeed(equation, temp.data(), salin.data(), pressure.data(),
+                table.c.data() + (t * numSalin + s) * numPressure, numPressure, latitudeDeg);
+        }
+    });
+
+    return table;
+}
+
+
+std::optional<SSoundSpeedTable> BuildSoundSpeedTable(const STableRange& range, size_t maxBytes,
+    eSoundSpeedEquation equation, double latitudeDeg, unsigned int numThreads)
+{
+    const double maxNodes = static_cast<double>(maxBytes / sizeof(double));
+    if (maxNodes < 8)
+        return {};
+
+    // Balance the error along the axes: (nodes - 1) in proportion to range * sqrt(curvature)
+    double curvature[3];
+    table::Curvature(range, equation, latitudeDeg, curvature);
+    const double extent[3] = { range.tempMax - range.tempMin, range.salinMax - range.salinMin, range.pressureMax - range.pressureMin };
+    double weight[3];
+    for (int axis = 0; axis < 3; ++axis)
+        weight[axis] = std::max(extent[axis] * std::sqrt(curvature[axis]), 1e-9);
+
+    const double scale = std::cbrt(maxNodes / (weight[0] * weight[1] * weight[2]));
+    size_t num[3];
+    for (int axis = 0; axis < 3; ++axis)
+        num[axis] = std::max<size_t>(2, static_cast<size_t>(weight[axis] * scale) + 1);
+
+    // Axes held at the minimum of 2 leave room for the others
+    while (true)
+    {
+        const double used = static_cast<double>(num[0]) * num[1] * num[2];
+        int grow = -1;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const bool fits = used / num[axis] * (num[axis] + 1) <= maxNodes;
+            if (fits && (grow < 0 || (num[axis] - 1) / weight[axis] < (num[grow] - 1) / weight[grow]))
+                grow = axis;
+        }
+        if (grow < 0)
+            break;
+        ++num[grow];
+    }
+    while (static_cast<double>(num[0]) * num[1] * num[2] > maxNodes)
+    {
+        auto largest = std::max_element(num, num + 3);
+        if (*largest <= 2)
+            return {};
+        --*largest;
+    }
+
+    return BuildSoundSpeedTable(range, num[0], num[1], num[2], equation, latitudeDeg, numThreads);
+}
+
+
+void SoundSpeed(const SSoundSpeedTable& table, const double* temp, const double* salin, const double* pressure,
+    double* c, size_t count)
+{
+    if (table.c.empty())
+    {
+        std::fill(c, c + count, std::numeric_limits<double>::quiet_NaN());
+        return;
+    }
+
+    for (size_t n = 0; n < count; ++n)
+        c[n] = table.SoundSpeed(temp[n], salin[n], pressure[n]);
+    return;
+}
+
+
+STableError VerifySoundSpeedTable(const SSoundSpeedTable& table, eSoundSpeedEquation equation, size_t samplesPerCell,
+    unsigned int numThreads)
+{
+    if (table.c.empty())
+        return {};
+    samplesPerCell = std::max<size_t>(1, samplesPerCell);
+
+    // Sample positions along each axis: samplesPerCell per cell plus the last node
+    auto positions = [samplesPerCell](double min, double max, size_t num) {
+        std::vector<double> x;
+        const size_t total = (num - 1) * samplesPerCell + 1;
+        for (size_t n = 0; n < total; ++n)
+            x.push_back(table::Node(min, max, n, total));
+        return x;
+    };
+    const auto temps = positions(table.range.tempMin, table.range.tempMax, table.numTemp);
+    const auto salins = positions(table.range.salinMin, table.range.salinMax, table.numSalin);
+    const auto pressures = positions(table.range.pressureMin, table.range.pressureMax, table.numPressure);
+
+    std::vector<STableError> errors(temps.size());
+    ParallelFor(temps.size(), numThreads, [&](size_t t) {
+        std::vector<double> temp(pressures.size(), temps[t]), salin(pressures.size()), exact(pressures.size()), approx(pressures.size());
+        STableError& worst = errors[t];
+        for (double s : salins)
+        {
+            std::fill(salin.begin(), salin.end(), s);
+            SoundSpeed(equation, temp.data(), salin.data(), pressures.data(), exact.data(), pressures.size(), table.latitudeDeg);
+            SoundSpeed(table, temp.data(), salin.data(), pressures.data(), approx.data(), pressures.size());
+            for (size_t p = 0; p < pressures.size(); ++p)
+            {
+                const double error = std::abs(approx[p] - exact[p]);
+                if (error > worst.maxError)
+                    worst = { error, temps[t], s, pressures[p] };
+            }
+        }
+    });
+
+    return *std::max_element(errors.begin(), errors.end(),
+        [](const STableError& a, const STableError& b) { return a.maxError < b.maxError; });
+}
+
+};  // End namespace ssp
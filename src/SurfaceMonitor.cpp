@@ -0,0 +1,254 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   SurfaceMonitor.cpp
+  * \brief  Streaming comparison of a surface sound speed probe with the profile in use
+  *
+  * The window is a ring buffer of (time, measured) samples with running sums of the measured values. The sums
+  * are kept relative to a shift close to the data (the profile speed, or the first sample without a profile),
+  * so the variance does not lose precision to values around 1500 m/s.
+  */
+
+#include "pch.h"
+#include "../include/SspCpp/SurfaceMonitor.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+namespace ssp
+{
+
+struct SurfaceMonitor::SImpl
+{
+    struct SSample
+    {
+        double time;
+        double c;
+    };
+
+    SSurfaceMonitorOptions options;
+    SurfaceCallback callback;
+
+    std::vector<SSample> ring;
+    size_t first = 0;  //!< Oldest sample
+    size_t count = 0;
+
+    double shift = 0;  //!< Subtracted from measured values before summing
+    double sum = 0;
+    double sumSquares = 0;
+
+    bool hasProfile = false;
+    double profileSpeed = 0;
+    double lastTime = -HUGE_VAL;
+    double lastMeasured = 0;
+    size_t rejected = 0;
+    bool beyond = false;  //!< Whether the mean is past the threshold
+    double since = 0;  //!< When it went past
+    bool diverged = false;
+
+    SSample& At(size_t n) { return ring[(first + n) % ring.size()]; }
+
+    void PopOldest()
+    {
+        const double d = ring[first].c - shift;
+        sum -= d;
+        sumSquares -= d * d;
+        first = (first + 1) % ring.size();
+        --count;
+        if (first == 0)
+            Resum(shift);  // Once per trip around the ring, so still O(1) per sample on average
+        return;
+    }
+
+    //! Re-sums the window about a new shift, which also clears any rounding built up by adding and removing
+    void Resum(double newShift)
+    {
+        shift = newShift;
+        sum = sumSquares = 0;
+        for (size_t n = 0; n < count; ++n)
+        {
+            const double d = At(n).c - shift;
+            sum += d;
+            sumSquares += d * d;
+        }
+        return;
+    }
+
+    double Mean() const { return count > 0 ? shift + sum / count : 0.0; }
+
+    void UseProfileSpeed(double c)
+    {
+        hasProfile = true;
+        profileSpeed = c;
+        beyond = diverged = false;
+        Resum(c);
+        return;
+    }
+
+    void Raise(eSurfaceEvent type, double time)
+    {
+        if (!callback)
+            return;
+        SSurfaceEvent event;
+        event.type = type;
+        event.time = time;
+        event.since = since;
+        event.meanDifference = Mean() - profileSpeed;
+        callback(event);
+        return;
+    }
+};
+
+
+SurfaceMonitor::SurfaceMonitor(const SSurfaceMonitorOptions& options, SurfaceCallback callback)
+    : impl(std::make_unique<SImpl>())
+{
+    impl->options = options;
+    impl->callback = std::move(callback);
+    impl->ring.resize(std::max<size_t>(options.maxSamples, 1));
+}
+
+
+SurfaceMonitor::~SurfaceMonitor() = default;
+
+
+bool SurfaceMonitor::SetProfile(const SCast& cast)
+{
+    const double depth = impl->options.transducerDepth;
+    const SCastEntry* above = nullptr;
+    for (const auto& entry : cast.entries)
+    {
+        if (!(entry.c > 0))
+            continue;
+        if (entry.depth >= depth)
+        {
+            double c = entry.c;
+            if (above && entry.depth > above->depth)
+                c = above->c + (entry.c - above->c) * (depth - above->depth) / (entry.depth - above->depth);
+            impl->UseProfileSpeed(c);
+            return true;
+        }
+        above = &entry;
+    }
+
+    if (!above)
+        return false;
+    impl->UseProfileSpeed(above->c);  // Cast ends above the transducer
+    return true;
+}
+
+
+void SurfaceMonitor::SetProfile(const SCompiledProfile& profile)
+{
+    impl->UseProfileSpeed(profile.SoundSpeed(impl->options.transducerDepth));
+    return;
+}
+
+
+void SurfaceMonitor::SetProfileSpeed(double c)
+{
+    impl->UseProfileSpeed(c);
+    return;
+}
+
+
+void SurfaceMonitor::Add(double time, double c)
+{
+    SImpl& m = *impl;
+    if (!std::isfinite(time) || !std::isfinite(c) || !(c > 0) || time < m.lastTime)
+    {
+        ++m.rejected;
+        return;
+    }
+
+    // Drop samples that have left the window (or make room)
+    while (m.count > 0 && (m.ring[m.first].time <= time - m.options.window || m.count == m.ring.size()))
+        m.PopOldest();
+    if (m.count == 0 && !m.hasProfile)
+        m.Resum(c);
+
+    m.At(m.count) = { time, c };
+    ++m.count;
+    const double d = c - m.shift;
+    m.sum += d;
+    m.sumSquares += d * d;
+    m.lastTime = time;
+    m.lastMeasured = c;
+
+    if (!m.hasProfile)
+        return;
+
+    const bool beyond = std::abs(m.Mean() - m.profileSpeed) > m.options.threshold;
+    if (beyond && !m.beyond)
+        m.since = time;
+    m.beyond = beyond;
+
+    if (beyond && !m.diverged && time - m.since >= m.options.persistence)
+    {
+        m.diverged = true;
+        m.Raise(eSurfaceEvent::Diverged, time);
+    }
+    else if (!beyond && m.diverged)
+    {
+        m.diverged = false;
+        m.Raise(eSurfaceEvent::Recovered, time);
+    }
+
+    return;
+}
+
+
+SSurfaceStats SurfaceMonitor::Stats() const
+{
+    const SImpl& m = *impl;
+    SSurfaceStats stats;
+    stats.profileSpeed = m.hasProfile ? m.profileSpeed : 0.0;
+    stats.lastTime = m.count > 0 ? m.lastTime : 0.0;
+    stats.lastMeasured = m.lastMeasured;
+    stats.count = m.count;
+    stats.rejected = m.rejected;
+    stats.diverged = m.diverged;
+    if (m.count > 0)
+    {
+        const double mean = m.sum / m.count;
+        stats.meanDifference = m.hasProfile ? m.Mean() - m.profileSpeed : 0.0;
+        stats.stdDifference = std::sqrt(std::max(0.0, m.sumSquares / m.count - mean * mean));
+    }
+    return stats;
+}
+
+
+void SurfaceMonitor::Reset()
+{
+    impl->first = impl->count = 0;
+    impl->sum = impl->sumSquares = 0;
+    impl->lastTime = -HUGE_VAL;
+    impl->lastMeasured = 0;
+    impl->beyond = impl->diverged = false;
+    return;
+}
+
+};  // End namespace ssp
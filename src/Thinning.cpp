@@ -0,0 +1,268 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Thinning.cpp
+  * \brief  Reduction of the number of points in a cast
+  */
+
+#include "pch.h"
+#include <SspCpp/Thinning.h>
+#include <cmath>
+#include <queue>
+#include <utility>
+#include "TravelTime.h"
+
+
+namespace ssp::thin
+{
+    //! A span of entries between two kept entries, with its worst removed entry
+    struct SSegment
+    {
+        size_t first;
+        size_t last;
+        size_t worst;  //!< Entry farthest from the line between first and last
+        double error;  //!< Sound speed difference (m/s) at the worst entry
+
+        bool operator<(const SSegment& other) const { return error < other.error; }
+    };
+
+
+    //! Finds the entry in (first, last) farthest from the straight line between first and last
+    SSegment MakeSegment(const double* depth, const double* c, size_t first, size_t last)
+    {
+        SSegment seg = { first, last, first, 0.0 };
+        if (last <= first + 1)
+            return seg;
+
+        const double d0 = depth[first];
+        const double c0 = c[first];
+        const double dz = depth[last] - d0;
+        const double slope = (dz > 0) ? (c[last] - c0) / dz : 0.0;
+
+        double maxError = -1.0;
+        size_t worst = first + 1;
+        for (size_t n = first + 1; n < last; ++n)
+        {
+            const double err = std::fabs(c[n] - (c0 + slope * (depth[n] - d0)));
+            if (err > maxError)
+            {
+                maxError = err;
+                worst = n;
+            }
+        }
+
+        seg.worst = worst;
+        seg.error = maxError;
+        return seg;
+    }
+
+
+    /*!
+     * \brief Picks the entries to keep, splitting the worst segment until the error is within tolerance
+     *  or maxPoints entries are kept. Each split only rescans that segment, so this is O(n log n) when splits
+     *  fall near the middle, and O(n^2) when each split only peels an entry off the end of a segment.
+     */
+    std::vector<char> SelectPoints(const SCast& cast, double tolerance, size_t maxPoints)
+    {
+        std::vector<char> keep(cast.entries.size(), 0);
+
+        // Entries with a non-finite depth are dropped. index maps the remaining entries back to the cast.
+        std::vector<size_t> index;
+        std::vector<double> depth, c;
+        for (size_t n = 0; n < cast.entries.size(); ++n)
+        {
+            if (!std::isfinite(cast.entries[n].depth))
+                continue;
+            index.push_back(n);
+            depth.push_back(cast.entries[n].depth);
+            c.push_back(cast.entries[n].c);
+        }
+
+        const size_t count = index.size();
+        if (count <= 2)
+        {
+            for (size_t n : index)
+                keep[n] = 1;
+            return keep;
+        }
+
+        keep[index[0]] = keep[index[count - 1]] = 1;
+        size_t numKept = 2;
+
+        std::priority_queue<SSegment> segments;
+        segments.push(MakeSegment(depth.data(), c.data(), 0, count - 1));
+
+        while (!segments.empty() && numKept < maxPoints)
+        {
+            SSegment seg = segments.top();
+            if (seg.error <= tolerance)
+                break;  // Everything left is within tolerance
+            segments.pop();
+
+            keep[index[seg.worst]] = 1;
+            ++numKept;
+            segments.push(MakeSegment(depth.data(), c.data(), seg.first, seg.worst));
+            segments.push(MakeSegment(depth.data(), c.data(), seg.worst, seg.last));
+        }
+
+        return keep;
+    }
+
+
+    //! Removes entries not flagged to keep and returns the travel time error
+    double ApplySelection(SCast& cast, const std::vector<char>& keep)
+    {
+        SCast full = cast;
+
+        size_t out = 0;
+        for (size_t n = 0; n < cast.entries.size(); ++n)
+        {
+            if (keep[n])
+                cast.entries[out++] = cast.entries[n];
+        }
+        cast.entries.resize(out);
+
+        return MaxTravelTimeError(full, cast);
+    }
+
+};  // End namespace ssp::thin
+
+
+namespace ssp
+{
+
+double ThinDouglasPeucker(SCast& cast, double tolerance)
+{
+    return thin::ApplySelection(cast, thin::SelectPoints(cast, tolerance, cast.entries.size()));
+}
+
+
+double ThinToCount(SCast& cast, size_t maxPoints)
+{
+    return thin::ApplySelection(cast, thin::SelectPoints(cast, 0.0, std::max<size_t>(maxPoints, 2)));
+}
+
+
+double ThinDepthBins(SCast& cast, double binSize)
+{
+    const size_t count = cast.entries.size();
+    if (count <= 2 || binSize <= 0)
+        return 0.0;
+
+    // Entries with a non-finite depth are dropped, and never start or end a bin
+    const auto isFinite = [&cast](size_t n) { return std::isfinite(cast.entries[n].depth); };
+    std::vector<char> keep(count, 0);
+    size_t first = 0, last = count - 1;
+    while (first < count && !isFinite(first))
+        ++first;
+    if (first == count)
+        return thin::ApplySelection(cast, keep);
+    while (!isFinite(last))
+        --last;
+    keep[first] = keep[last] = 1;
+
+    // The data is sorted, so each bin is a contiguous run of entries. The entry that starts a bin is always
+    //  consumed, so the loop advances.
+    const double top = cast.entries[first].depth;
+    size_t n = first;
+    while (n <= last)
+    {
+        if (!isFinite(n))
+        {
+            ++n;
+            continue;
+        }
+
+        const double bin = std::floor((cast.entries[n].depth - top) / binSize);
+        const double center = top + (bin + 0.5) * binSize;
+        size_t best = n;
+        for (++n; n <= last; ++n)
+        {
+            if (!isFinite(n))
+                continue;
+            const double depth = cast.entries[n].depth;
+            if (std::floor((depth - top) / binSize) != bin)
+                break;
+            if (std::fabs(depth - center) < std::fabs(cast.entries[best].depth - center))
+                best = n;
+        }
+        keep[best] = 1;
+    }
+
+    return thin::ApplySelection(cast, keep);
+}
+
+
+double MaxTravelTimeError(const SCast& full, const SCast& thinned)
+{
+    const auto& a = full.entries;
+    const auto& b = thinned.entries;
+    if (a.size() < 2 || b.size() < 2)
+        return 0.0;
+
+    // Both casts are integrated from the shallowest depth they share. Walk the full cast, and keep track of the
+    //  thinned cast's layer that contains each depth. Entries of the full cast with a non-finite depth are skipped.
+    size_t prev = 0;  // Last finite entry of the full cast
+    while (prev < a.size() && !std::isfinite(a[prev].depth))
+        ++prev;
+    if (prev == a.size())
+        return 0.0;
+
+    double timeFull = 0.0, timeThin = 0.0, maxError = 0.0;
+    size_t layer = 0;  // Thinned layer [layer, layer + 1]
+    double prevDepth = a[prev].depth;
+    double prevThinC = b[0].c;
+
+    for (size_t n = prev + 1; n < a.size(); ++n)
+    {
+        const double depth = a[n].depth;
+        if (!std::isfinite(depth))
+            continue;
+        timeFull += travel::LayerTime(depth - a[prev].depth, a[prev].c, a[n].c);
+        prev = n;
+
+        // Advance through the thinned layers up to this depth
+        while (layer + 2 < b.size() && b[layer + 1].depth <= depth)
+        {
+            timeThin += travel::LayerTime(b[layer + 1].depth - prevDepth, prevThinC, b[layer + 1].c);
+            prevDepth = b[layer + 1].depth;
+            prevThinC = b[layer + 1].c;
+            ++layer;
+        }
+
+        const double dz = b[layer + 1].depth - b[layer].depth;
+        const double t = (dz > 0) ? (depth - b[layer].depth) / dz : 0.0;
+        const double thinC = b[layer].c + t * (b[layer + 1].c - b[layer].c);
+        timeThin += travel::LayerTime(depth - prevDepth, prevThinC, thinC);
+        prevDepth = depth;
+        prevThinC = thinC;
+
+        maxError = std::max(maxError, std::fabs(timeFull - timeThin));
+    }
+
+    return maxError;
+}
+
+};  // End namespace ssp
@@ -38,7 +38,7 @@ namespace ssp
 {
     inline std::tm CreateTime(int year, int month, int day, int hour, int minute, int second)
     {
-        std::tm time;
+        std::tm time = {};
 
         time.tm_year = year - 1900;
         time.tm_mon = month - 1;  // 0-indexed
@@ -46,6 +46,7 @@ namespace ssp
         time.tm_hour = hour;
         time.tm_min = minute;
         time.tm_sec = second;
+        time.tm_isdst = -1;  // Let mktime decide, otherwise it can shift the hour
         mktime(&time);  // Fills in the rest of the members (day of the week, etc.)
 
         return time;
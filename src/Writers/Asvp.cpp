@@ -0,0 +1,49 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Asvp.cpp
+  * \brief  Writer for Kongsberg Maritime (.asvp) casts
+  */
+
+#include "pch.h"
+#include "Writers.h"
+#include <iterator>
+#include <fmt/format.h>
+
+
+bool ssp::WriteAsvp(const SCast& cast, std::string& buffer)
+{
+    auto out = std::back_inserter(buffer);
+    const std::tm& t = cast.time;
+
+    // Example header: "( SoundVelocity  1.0 0 201203212242 22.24458330 -159.81555560 -1 0 0 SspCpp P 5 )"
+    fmt::format_to(out, "( SoundVelocity  1.0 0 {:04}{:02}{:02}{:02}{:02}{:02} {} {} -1 0 0 SspCpp P {} )\n",
+        t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec, cast.lat, cast.lon, cast.entries.size());
+
+    for (const auto& entry : cast.entries)
+        fmt::format_to(out, "{} {}\n", entry.depth, entry.c);
+
+    return true;
+}
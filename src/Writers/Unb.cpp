@@ -0,0 +1,73 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Unb.cpp
+  * \brief  Writer for University of New Brunswick (.unb) casts
+  */
+
+#include "pch.h"
+#include "Writers.h"
+#include <iterator>
+#include <fmt/format.h>
+
+
+namespace ssp::unb
+{
+    //! Day of the year (1-366) from the year, month and day. tm_yday is not always filled in.
+    int DayOfYear(const std::tm& t)
+    {
+        static const int daysBefore[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+        const int year = t.tm_year + 1900;
+        const bool bLeap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        const int month = (t.tm_mon >= 0 && t.tm_mon < 12) ? t.tm_mon : 0;
+        return daysBefore[month] + t.tm_mday + ((bLeap && month > 1) ? 1 : 0);
+    }
+};
+
+
+bool ssp::WriteUnb(const SCast& cast, std::string& buffer)
+{
+    if (cast.entries.size() == 0)
+        return false;  // The format needs at least one entry
+
+    auto out = std::back_inserter(buffer);
+    const std::tm& t = cast.time;
+
+    // Version, date/time (year, day of the year, time) and logging date/time (unused)
+    fmt::format_to(out, "2  # version\n{:04} {:03} {:02}:{:02}:{:02}  # date/time\n0 0 00:00:00\n",
+        t.tm_year + 1900, unb::DayOfYear(t), t.tm_hour, t.tm_min, t.tm_sec);
+
+    // Position, logging position (unused), number of entries and 10 lines for future use
+    fmt::format_to(out, "{} {}\n0 0\n{}\n", cast.lat, cast.lon, cast.entries.size());
+    for (int n = 0; n < 10; ++n)
+        fmt::format_to(out, "0\n");
+
+    // Entry number, depth, sound speed, temperature, salinity and two unused fields
+    int entryNum = 1;
+    for (const auto& entry : cast.entries)
+        fmt::format_to(out, "{} {} {} {} {} 0 0\n", entryNum++, entry.depth, entry.c, entry.temp, entry.salinity);
+
+    return true;
+}
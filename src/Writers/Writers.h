@@ -0,0 +1,44 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Writers.h
+  * \brief  Writers for the formats that the library can read
+  *
+  * Each writer appends the formatted cast to the buffer, so one buffer can be reused for many casts.
+  */
+
+#pragma once
+
+#include <string>
+#include <SspCpp/Cast.h>
+
+namespace ssp
+{
+    bool WriteAsvp(const SCast& cast, std::string& buffer);
+    bool WriteHypack(const SCast& cast, std::string& buffer);
+    bool WriteSeaBirdTsv(const SCast& cast, std::string& buffer);
+    bool WriteSonardyne(const SCast& cast, std::string& buffer);
+    bool WriteUnb(const SCast& cast, std::string& buffer);
+};
@@ -0,0 +1,127 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2023 Denton Woods
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+ /*!
+  * \file   Xbt.cpp
+  * \brief  Expendable bathythermograph (XBT) fall-rate equations
+  */
+
+#include "pch.h"
+#include <SspCpp/Xbt.h>
+#include <algorithm>
+#include <cctype>
+
+
+namespace ssp
+{
+
+SFallRate FallRateCoefficients(eXbtProbe probe)
+{
+    switch (probe)
+    {
+        // From Hanawa et al., "A new depth-time equation for Sippican or TSK T-7, T-6 and T-4 expendable
+        //  bathythermographs (XBT)", Deep-Sea Research I, 42(8), 1995. Deep Blue uses the same probe body.
+        case eXbtProbe::T4:
+        case eXbtProbe::T6:
+        case eXbtProbe::T7:
+        case eXbtProbe::DeepBlue:
+        case eXbtProbe::Unknown:
+            return { 6.691, 2.25e-3 };
+
+        // The remaining values are the manufacturer's equations
+        case eXbtProbe::T5:
+            return { 6.828, 1.82e-3 };
+        case eXbtProbe::FastDeep:
+            return { 6.390, 1.82e-3 };
+        case eXbtProbe::T10:
+            return { 6.301, 2.16e-3 };
+        case eXbtProbe::T11:
+            return { 1.779, 2.55e-4 };
+        case eXbtProbe::Axbt:
+            return { 1.524, 0.0 };
+    }
+
+    return { 6.691, 2.25e-3 };
+}
+
+
+eXbtProbe XbtProbeFromName(const std::string& name)
+{
+    // Strip out anything that is not a letter or digit, so "T-7" and "t 7" are the same
+    std::string key;
+    for (unsigned char ch : name)
+    {
+        if (std::isalnum(ch))
+            key += static_cast<char>(std::tolower(ch));
+    }
+
+    if (key == "t4")
+        return eXbtProbe::T4;
+    if (key == "t5")
+        return eXbtProbe::T5;
+    if (key == "t6")
+        return eXbtProbe::T6;
+    if (key == "t7")
+        return eXbtProbe::T7;
+    if (key == "deepblue" || key == "db")
+        return eXbtProbe::DeepBlue;
+    if (key == "fastdeep" || key == "fd")
+        return eXbtProbe::FastDeep;
+    if (key == "t10")
+        return eXbtProbe::T10;
+    if (key == "t11")
+        return eXbtProbe::T11;
+    if (key.compare(0, 4, "axbt") == 0)
+        return eXbtProbe::Axbt;
+
+    return eXbtProbe::Unknown;
+}
+
+
+double XbtDepth(double elapsedSec, eXbtProbe probe)
+{
+    const SFallRate f = FallRateCoefficients(probe);
+    return (f.a - f.b * elapsedSec) * elapsedSec;
+}
+
+
+void XbtDepth(const double* elapsedSec, double* depth, size_t count, const SFallRate& fallRate)
+{
+    const double a = fallRate.a, b = fallRate.b;
+    for (size_t n = 0; n < count; ++n)
+    {
+        const double t = elapsedSec[n];
+        depth[n] = (a - b * t) * t;
+    }
+    return;
+}
+
+
+void XbtDepth(const double* elapsedSec, double* depth, size_t count, eXbtProbe probe)
+{
+    XbtDepth(elapsedSec, depth, count, FallRateCoefficients(probe));
+    return;
+}
+
+};  // End namespace ssp
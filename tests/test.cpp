@@ -1,7 +1,34 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <SspCpp/Absorption.h>
+#include <SspCpp/ActiveProfile.h>
+#include <SspCpp/Climatology.h>
+#include <SspCpp/Comparison.h>
+#include <SspCpp/CtdProcessing.h>
+#include <SspCpp/Density.h>
+#include <SspCpp/DirectoryWatcher.h>
+#include <SspCpp/Features.h>
 #include <SspCpp/LatLong.h>
+#include <SspCpp/ParseCache.h>
+#include <SspCpp/SharedProfile.h>
 #include <SspCpp/SoundSpeed.h>
+#include <SspCpp/SoundSpeedTable.h>
+#include <SspCpp/SurfaceMonitor.h>
+#include <SspCpp/RayTrace.h>
+#include <SspCpp/Resample.h>
+#include <SspCpp/Thinning.h>
+#include <SspCpp/Xbt.h>
 #include "../src/TimeStruct.h"
 
 
@@ -50,6 +77,667 @@ TEST_CASE("Wong-Zhu equation", "[ssp-calc]")
 }
 
 
+TEST_CASE("Sound speed equations", "[ssp-calc]")
+{
+    using ssp::eSoundSpeedEquation;
+
+    // Check values from the UNESCO report (Fofonoff and Millard 1983) and Mackenzie (1981)
+    REQUIRE(ssp::SoundSpeed(eSoundSpeedEquation::ChenMillero, 40 / 1.00024, 40, 1000) == Approx(1731.995).margin(0.0005));  // 40 C in IPTS-68
+    const double pressure1000m = ssp::DepthToPressure(1000, 30);
+    REQUIRE(ssp::SoundSpeed(eSoundSpeedEquation::Mackenzie, 25, 35, pressure1000m, 30) == Approx(1550.744).margin(0.0005));
+    REQUIRE(ssp::SoundSpeed(eSoundSpeedEquation::DelGrosso, 0, 35, 0) == Approx(1402.392 + 1.32952290781 * 35 + 0.128955756844e-3 * 35 * 35));
+    REQUIRE(ssp::SoundSpeed(eSoundSpeedEquation::WongZhu, 0, 25, 500) == ssp::WongZhu(0, 25, 500));
+
+    // The equations agree to within a couple of m/s over typical ocean conditions (warm water only near the
+    // surface), and batches match single values
+    std::vector<double> temp, salin, pressure;
+    for (double t = 0; t <= 30; t += 5)
+        for (double p = 0; p <= (t > 20 ? 100 : 600); p += 100)
+        {
+            temp.push_back(t);
+            salin.push_back(35);
+            pressure.push_back(p);
+        }
+    std::vector<double> reference(temp.size()), c(temp.size());
+    ssp::WongZhu(temp.data(), salin.data(), pressure.data(), reference.data(), temp.size());
+    for (auto equation : { eSoundSpeedEquation::ChenMillero, eSoundSpeedEquation::DelGrosso, eSoundSpeedEquation::Mackenzie })
+    {
+        ssp::SoundSpeed(equation, temp.data(), salin.data(), pressure.data(), c.data(), temp.size(), 30);
+        for (size_t n = 0; n < c.size(); ++n)
+        {
+            REQUIRE(std::abs(c[n] - reference[n]) < 2.0);
+            if (equation == eSoundSpeedEquation::ChenMillero)  // Same equation, so only the refit differs
+                REQUIRE(std::abs(c[n] - reference[n]) < 0.01);
+            REQUIRE(c[n] == Approx(ssp::SoundSpeed(equation, temp[n], salin[n], pressure[n], 30)));
+        }
+    }
+
+    return;
+}
+
+
+TEST_CASE("Sound speed lookup table", "[ssp-calc]")
+{
+    ssp::STableRange range;
+    REQUIRE_FALSE(ssp::BuildSoundSpeedTable(range, 1, 10, 10));
+    REQUIRE_FALSE(ssp::BuildSoundSpeedTable(range, 32));
+
+    auto table = ssp::BuildSoundSpeedTable(range, 41, 41, 101);
+    REQUIRE(table);
+    REQUIRE(table->Bytes() == 41 * 41 * 101 * sizeof(double));
+    REQUIRE(table->SoundSpeed(10, 35, 200) == Approx(ssp::WongZhu(10, 35, 200)));  // On a node
+    REQUIRE(table->SoundSpeed(-5, 35, 200) == Approx(ssp::WongZhu(0, 35, 200)));  // Clamped to the range
+    REQUIRE(table->SoundSpeed(12.3, 34.6, 456.7) == Approx(ssp::WongZhu(12.3, 34.6, 456.7)).margin(0.05));
+
+    auto error = ssp::VerifySoundSpeedTable(*table);
+    REQUIRE(error.maxError > 0);
+    REQUIRE(error.maxError < 0.05);
+    REQUIRE(std::abs(table->SoundSpeed(error.temp, error.salin, error.pressure) -
+        ssp::WongZhu(error.temp, error.salin, error.pressure)) == Approx(error.maxError));
+
+    // A larger budget gives a finer table and a smaller error
+    auto small = ssp::BuildSoundSpeedTable(range, 256 << 10);
+    auto large = ssp::BuildSoundSpeedTable(range, 4 << 20);
+    REQUIRE(small);
+    REQUIRE(large);
+    REQUIRE(small->Bytes() <= 256 << 10);
+    REQUIRE(large->Bytes() <= 4 << 20);
+    REQUIRE(large->Bytes() > 3 << 20);
+    REQUIRE(large->numTemp > large->numSalin);  // Sound speed curves more with temperature
+    const double smallError = ssp::VerifySoundSpeedTable(*small).maxError;
+    const double largeError = ssp::VerifySoundSpeedTable(*large).maxError;
+    REQUIRE(largeError < smallError);
+    REQUIRE(largeError < 0.005);
+
+    // Tables of other equations are checked against that equation
+    auto mackenzie = ssp::BuildSoundSpeedTable({ -2, 30, 25, 40, 0, 800 }, 1 << 20, ssp::eSoundSpeedEquation::Mackenzie, 30);
+    REQUIRE(mackenzie);
+    REQUIRE(ssp::VerifySoundSpeedTable(*mackenzie, ssp::eSoundSpeedEquation::Mackenzie).maxError < 0.01);
+
+    std::vector<double> temp = { 5, 15, 25 }, salin = { 34, 35, 36 }, pressure = { 100, 50, 1 }, c(3);
+    ssp::SoundSpeed(*table, temp.data(), salin.data(), pressure.data(), c.data(), c.size());
+    REQUIRE(c[1] == table->SoundSpeed(15, 35, 50));
+
+    // Missing values stay missing instead of indexing outside the table
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    REQUIRE(std::isnan(table->SoundSpeed(nan, 35, 200)));
+    REQUIRE(std::isnan(table->SoundSpeed(10, 35, nan)));
+    REQUIRE(table->SoundSpeed(10, 35, std::numeric_limits<double>::infinity()) == Approx(ssp::WongZhu(10, 35, 1000)));
+    ssp::SoundSpeed(ssp::SSoundSpeedTable(), temp.data(), salin.data(), pressure.data(), c.data(), c.size());
+    REQUIRE(std::isnan(c[0]));
+
+    return;
+}
+
+
+TEST_CASE("Acoustic absorption", "[absorption]")
+{
+    using ssp::eAbsorptionModel;
+    REQUIRE(ssp::Absorption(10, 10, 35, 0) == Approx(0.9626).margin(0.0005));
+    REQUIRE(ssp::Absorption(12, 4, 35, 1000) == Approx(1.3888).margin(0.0005));
+    REQUIRE(ssp::Absorption(100, 10, 35, 100) == Approx(33.17).margin(0.01));
+    REQUIRE(ssp::Absorption(10, 10, 35, 0, 8, eAbsorptionModel::AinslieMcColm) == Approx(0.9866).margin(0.0005));
+    REQUIRE(ssp::Absorption(1, 4, 35, 1000, 8, eAbsorptionModel::AinslieMcColm) == Approx(0.0622).margin(0.0005));
+    REQUIRE(ssp::Absorption(1, 4, 35, 1000, 7.7) < ssp::Absorption(1, 4, 35, 1000, 8.0));  // Boric acid term
+
+    // Depth x frequency matrix, one frequency at a time
+    std::vector<double> temp = { 20, 10, 4, 2 }, salin = { 34, 35, 35, 34.7 }, depth = { 0, 200, 1000, 4000 };
+    std::vector<double> frequencies = { 1, 12, 38, 200 };
+    std::vector<double> alpha(temp.size() * frequencies.size());
+    for (auto model : { eAbsorptionModel::FrancoisGarrison, eAbsorptionModel::AinslieMcColm })
+    {
+        ssp::Absorption(temp.data(), salin.data(), depth.data(), temp.size(), frequencies.data(), frequencies.size(),
+            alpha.data(), 8.0, model);
+        for (size_t k = 0; k < frequencies.size(); ++k)
+            for (size_t n = 0; n < temp.size(); ++n)
+                REQUIRE(alpha[k * temp.size() + n] == Approx(ssp::Absorption(frequencies[k], temp[n], salin[n], depth[n], 8.0, model)));
+    }
+
+    // An odd number of samples runs both the vectorized loop body and its remainder
+    std::vector<double> longTemp, longSalin, longDepth;
+    for (int n = 0; n < 37; ++n)
+    {
+        longDepth.push_back(n * 100.0);
+        longTemp.push_back(2.0 + 18.0 * std::exp(-n / 8.0));
+        longSalin.push_back(34.0 + 0.03 * n);
+    }
+    const std::vector<double> longFrequencies = { 0.5, 3.5, 12, 100, 700 };
+    std::vector<double> longAlpha(longTemp.size() * longFrequencies.size());
+    ssp::Absorption(longTemp.data(), longSalin.data(), longDepth.data(), longTemp.size(), longFrequencies.data(),
+        longFrequencies.size(), longAlpha.data());
+    for (size_t k = 0; k < longFrequencies.size(); ++k)
+        for (size_t n = 0; n < longTemp.size(); ++n)
+            REQUIRE(longAlpha[k * longTemp.size() + n] ==
+                Approx(ssp::Absorption(longFrequencies[k], longTemp[n], longSalin[n], longDepth[n])).epsilon(1e-12));
+
+    ssp::SCast cast;
+    for (int n = 0; n < 50; ++n)
+    {
+        ssp::SCastEntry entry = {};
+        entry.depth = n * 20.0;
+        entry.temp = 4.0 + 14.0 * std::exp(-entry.depth / 150.0);
+        entry.salinity = n % 10 == 0 ? 0.0 : 35.0;  // Missing salinity is taken as 35
+        cast.entries.push_back(entry);
+    }
+    auto matrix = ssp::CastAbsorption(cast, frequencies);
+    REQUIRE(matrix.size() == cast.entries.size() * frequencies.size());
+    ssp::FillAbsorption(cast, 38);
+    for (size_t n = 0; n < cast.entries.size(); ++n)
+    {
+        REQUIRE(cast.entries[n].absorp == Approx(ssp::Absorption(38, cast.entries[n].temp, 35, cast.entries[n].depth)));
+        REQUIRE(cast.entries[n].absorp == matrix[2 * cast.entries.size() + n]);
+    }
+
+    return;
+}
+
+
+TEST_CASE("Density and buoyancy frequency", "[density]")
+{
+    // Check values from Fofonoff and Millard (1983), which are for IPTS-68 temperatures
+    const auto T68 = [](double t) { return t / 1.00024; };
+    REQUIRE(ssp::Density(T68(5), 0, 0) == Approx(999.96675).margin(1e-5));
+    REQUIRE(ssp::Density(T68(5), 35, 0) == Approx(1027.67547).margin(1e-5));
+    REQUIRE(ssp::Density(T68(5), 35, 1000) == Approx(1069.48914).margin(1e-5));
+    REQUIRE(ssp::Density(T68(25), 35, 1000) == Approx(1062.53817).margin(1e-5));
+    REQUIRE(ssp::SigmaT(T68(5), 35) == Approx(27.67547).margin(1e-5));
+    REQUIRE(ssp::PotentialTemperature(T68(40), 40, 1000) * 1.00024 == Approx(36.89073).margin(1e-5));
+
+    // Thermocline over a uniform deep layer
+    ssp::SCast cast;
+    cast.lat = 45;
+    for (int n = 0; n <= 100; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 10.0;
+        entry.temp = entry.depth < 200 ? 18.0 - 0.05 * entry.depth : 8.0;
+        entry.salinity = 35.0;
+        cast.entries.push_back(entry);
+    }
+    ssp::FillDensity(cast);
+    const auto& mid = cast.entries[10];
+    REQUIRE(mid.sigmaT == Approx(ssp::SigmaT(13, 35)));
+    REQUIRE(mid.density == Approx(ssp::Density(13, 35, ssp::DepthToPressure(100, 45))));
+    const double alpha = (ssp::SigmaT(12.9, 35) - ssp::SigmaT(13.1, 35)) / 0.2;  // Thermal expansion times density
+    REQUIRE(mid.n2 == Approx(ssp::Gravity(45) * alpha * 0.05 / mid.density).epsilon(0.05));
+    for (size_t n = 30; n + 1 < cast.entries.size(); ++n)
+    {
+        REQUIRE(cast.entries[n].n2 > 0);  // Only the adiabatic gradient is left
+        REQUIRE(cast.entries[n].n2 < 1e-6);
+    }
+    std::vector<double> temp = { 10, 12 }, salin = { 35, 35 }, pressure = { 1, 2 }, depth = { 0, 10 }, n2(2);
+    ssp::BuoyancyFrequency(temp.data(), salin.data(), pressure.data(), depth.data(), n2.data(), 2, 45);
+    REQUIRE(n2[0] < 0);  // Warmer water below is unstable
+
+    // A table gives the same columns as separate casts
+    ssp::SCastTable table;
+    ssp::SCast other = cast;
+    other.lat = 10;
+    for (auto& entry : other.entries)
+        entry.salinity = 0;  // Taken as 35
+    ssp::AppendCast(table, cast);
+    ssp::AppendCast(table, other);
+    ssp::FillDensity(table, 2);
+    ssp::FillDensity(other);
+    REQUIRE(table.density.size() == table.NumSamples());
+    for (size_t n = 0; n < other.entries.size(); ++n)
+    {
+        REQUIRE(table.density[cast.entries.size() + n] == other.entries[n].density);
+        REQUIRE(table.n2[cast.entries.size() + n] == other.entries[n].n2);
+    }
+    REQUIRE(ssp::GetCast(table, 0).entries[10].n2 == mid.n2);
+
+    ssp::SDepthGrid grid;
+    grid.step = 5;
+    grid.count = 200;
+    auto resampled = ssp::ResampleCasts(table, grid, ssp::eResampleMode::Interpolate);
+    REQUIRE(resampled.density.size() == 2 * grid.count);
+    REQUIRE(resampled.sigmaT[20] == Approx(mid.sigmaT));
+
+    return;
+}
+
+
+TEST_CASE("Acoustic features", "[features]")
+{
+    // Surface duct to 50 m, sound channel axis at 1000 m, back to the near-surface maximum at 2117.6 m
+    ssp::SCast cast;
+    for (int n = 0; n <= 300; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 10.0;
+        entry.temp = entry.depth <= 50 ? 15.0 : 15.0 - 0.01 * (entry.depth - 50);
+        if (entry.depth <= 50)
+            entry.c = 1500.0 + 0.017 * entry.depth;
+        else if (entry.depth <= 1000)
+            entry.c = 1500.85 - 0.02 * (entry.depth - 50);
+        else
+            entry.c = 1481.85 + 0.017 * (entry.depth - 1000);
+        cast.entries.push_back(entry);
+    }
+
+    auto features = ssp::ExtractFeatures(cast);
+    REQUIRE(features.surfaceSpeed == 1500.0);
+    REQUIRE(features.maxDepth == 3000.0);
+    REQUIRE(features.mixedLayerDepth == Approx(70.0));
+    REQUIRE(features.sonicLayerDepth == 50.0);
+    REQUIRE(features.ductCutoffFrequency == Approx(1500.0 / (0.008 * 50.0 * std::sqrt(50.0))).epsilon(0.06));
+    REQUIRE(features.sofarDepth == 1000.0);
+    REQUIRE(features.sofarSpeed == Approx(1481.85));
+    REQUIRE(features.criticalDepth == Approx(1000.0 + 19.0 / 0.017));
+
+    // A shallow cast with speed falling all the way down has no duct, channel or critical depth
+    ssp::SCast shallow;
+    for (int n = 0; n <= 20; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 5.0;
+        entry.c = 1510.0 - 0.1 * entry.depth;
+        shallow.entries.push_back(entry);
+    }
+    auto none = ssp::ExtractFeatures(shallow);
+    REQUIRE(none.sonicLayerDepth == 0.0);
+    REQUIRE(std::isnan(none.ductCutoffFrequency));
+    REQUIRE(std::isnan(none.mixedLayerDepth));  // No temperature
+    REQUIRE(std::isnan(none.sofarDepth));
+    REQUIRE(std::isnan(none.criticalDepth));
+
+    // Archives give one row per cast
+    std::vector<ssp::SCast> casts = { cast, shallow, cast };
+    ssp::SCastTable table;
+    for (const auto& c : casts)
+        ssp::AppendCast(table, c);
+    for (const auto& rows : { ssp::ExtractFeatures(casts, {}, 2), ssp::ExtractFeatures(table, {}, 2) })
+    {
+        REQUIRE(rows.size() == 3);
+        REQUIRE(rows[2].criticalDepth == features.criticalDepth);
+        REQUIRE(rows[1].surfaceSpeed == 1510.0);
+    }
+
+    return;
+}
+
+
+TEST_CASE("Ray tracing and profile comparison", "[compare]")
+{
+    const auto MakeCast = [](int numLayers, double c0, double gradient, double lat = 0, double lon = 0)
+    {
+        ssp::SCast cast;
+        cast.lat = lat;
+        cast.lon = lon;
+        for (int n = 0; n <= numLayers; ++n)
+        {
+            ssp::SCastEntry entry;
+            entry.depth = n * 500.0 / numLayers;
+            entry.c = c0 + gradient * entry.depth;
+            cast.entries.push_back(entry);
+        }
+        return cast;
+    };
+
+    // Straight rays at constant speed
+    auto constant = ssp::CompileProfile(MakeCast(1, 1500, 0));
+    auto straight = ssp::TraceRayToDepth(*constant, 0, 30, 100);
+    REQUIRE(straight);
+    REQUIRE(straight->horizontal == Approx(100 * std::tan(30 * 0.017453292519943295)));
+    REQUIRE(straight->time == Approx(100 / (1500 * std::cos(30 * 0.017453292519943295))));
+
+    // Constant gradient: one layer or many give the same ray, which matches a small step integration of Snell's law
+    auto one = ssp::CompileProfile(MakeCast(1, 1480, 0.05));
+    auto many = ssp::CompileProfile(MakeCast(37, 1480, 0.05));
+    auto rayOne = ssp::TraceRayToDepth(*one, 3, 55, 420);
+    auto rayMany = ssp::TraceRayToDepth(*many, 3, 55, 420);
+    REQUIRE(rayOne);
+    REQUIRE(rayMany);
+    REQUIRE(rayMany->horizontal == Approx(rayOne->horizontal).epsilon(1e-10));
+    REQUIRE(rayMany->time == Approx(rayOne->time).epsilon(1e-10));
+    double x = 0, t = 0;
+    const double p = std::sin(55 * 0.017453292519943295) / (1480 + 0.05 * 3);
+    const int steps = 417000;
+    const double dz = 417.0 / steps;
+    for (int k = 0; k < steps; ++k)
+    {
+        const double c = 1480 + 0.05 * (3 + (k + 0.5) * dz);
+        const double cosAngle = std::sqrt(1 - p * p * c * c);
+        x += dz * p * c / cosAngle;
+        t += dz / (c * cosAngle);
+    }
+    REQUIRE(rayOne->horizontal == Approx(x).epsilon(1e-6));
+    REQUIRE(rayOne->time == Approx(t).epsilon(1e-6));
+
+    // Tracing for the same time ends at the same point, including part way through a layer
+    auto back = ssp::TraceRayForTime(*many, 3, 55, rayMany->time);
+    REQUIRE(back);
+    REQUIRE(back->depth == Approx(420).epsilon(1e-10));
+    REQUIRE(back->horizontal == Approx(rayMany->horizontal).epsilon(1e-10));
+    auto deeper = ssp::TraceRayForTime(*many, 3, 55, 10.0);  // Continues below the cast
+    REQUIRE(deeper);
+    REQUIRE(deeper->depth > 500);
+
+    // A steep gradient turns a low-angle ray back up
+    auto steep = ssp::CompileProfile(MakeCast(5, 1500, 0.2));
+    REQUIRE_FALSE(ssp::TraceRayToDepth(*steep, 0, 80, 400));
+    REQUIRE_FALSE(ssp::TraceRayForTime(*steep, 0, 80, 10.0));
+    REQUIRE(ssp::TraceRayToDepth(*steep, 0, 20, 400));
+
+    // Comparisons
+    ssp::SSwathGeometry swath;
+    swath.waterDepth = 200;
+    auto same = ssp::CompareProfiles(*many, *one, swath);
+    REQUIRE(same.maxSpeedDifference == Approx(0).margin(1e-9));
+    REQUIRE(same.maxDepthError == Approx(0).margin(1e-6));
+
+    auto faster = ssp::CompareProfiles(MakeCast(37, 1480, 0.05), MakeCast(10, 1485, 0.05), swath);
+    REQUIRE(faster);
+    REQUIRE(faster->maxSpeedDifference == Approx(5));
+    REQUIRE(faster->rmsSpeedDifference == Approx(5));
+    REQUIRE(faster->maxDepthError > 200 * 5 / 1490.0);  // At least the vertical beam's error
+    REQUIRE(faster->maxDepthError < 2.0);
+    REQUIRE(faster->maxHorizontalError > 0);
+    REQUIRE_FALSE(ssp::CompareProfiles(MakeCast(1, 1480, 0), ssp::SCast(), swath));
+
+    // Neighbours within 5 km (0.01 degrees of latitude is about 1.1 km)
+    std::vector<ssp::SCast> existing = { MakeCast(10, 1480, 0.05, 45.0, -63), MakeCast(10, 1482, 0.05, 45.1, -63),
+        MakeCast(10, 1481, 0.05, 45.01, -63) };
+    std::vector<ssp::SCast> incoming = { MakeCast(10, 1483, 0.05, 45.0, -63.001), MakeCast(10, 1483, 0.05, 46, -63) };
+    auto comparisons = ssp::CompareWithNeighbours(incoming, existing, 5000, swath, 1.0, 2);
+    REQUIRE(comparisons.size() == 2);
+    REQUIRE(comparisons[0].cast == 0);
+    REQUIRE(comparisons[0].neighbour == 0);
+    REQUIRE(comparisons[0].distance == Approx(78.7).margin(0.5));
+    REQUIRE(comparisons[0].difference.maxSpeedDifference == Approx(3));
+    REQUIRE(comparisons[1].neighbour == 2);
+    REQUIRE(comparisons[1].difference.maxSpeedDifference == Approx(2));
+
+    return;
+}
+
+
+TEST_CASE("Surface sound speed monitor", "[surface]")
+{
+    ssp::SSurfaceMonitorOptions options;
+    options.transducerDepth = 5;
+    options.window = 2;
+    options.threshold = 1;
+    options.persistence = 3;
+    options.maxSamples = 64;
+    std::vector<ssp::SSurfaceEvent> events;
+    ssp::SurfaceMonitor monitor(options, [&events](const ssp::SSurfaceEvent& e) { events.push_back(e); });
+
+    ssp::SCast cast;
+    for (double depth : { 0.0, 10.0, 20.0 })
+    {
+        ssp::SCastEntry entry;
+        entry.depth = depth;
+        entry.c = 1500.0 - depth;
+        cast.entries.push_back(entry);
+    }
+    REQUIRE_FALSE(monitor.SetProfile(ssp::SCast()));
+    REQUIRE(monitor.SetProfile(cast));
+    REQUIRE(monitor.Stats().profileSpeed == 1495.0);
+
+    // 20 Hz readings that agree with the profile apart from noise
+    int sample = 0;
+    const auto Feed = [&](double seconds, double c)
+    {
+        for (const int end = sample + static_cast<int>(seconds * 20); sample < end; ++sample)
+            monitor.Add(sample * 0.05, c + ((sample % 2) ? 0.3 : -0.3));
+    };
+    Feed(5, 1495);
+    auto stats = monitor.Stats();
+    REQUIRE(stats.count == 40);
+    REQUIRE(stats.meanDifference == Approx(0).margin(0.02));
+    REQUIRE(stats.stdDifference == Approx(0.3).margin(0.01));
+    REQUIRE(events.empty());
+
+    // A 2.5 m/s change takes 17 samples to move the mean past the threshold, then must last 3 s
+    Feed(5, 1497.5);
+    REQUIRE(events.size() == 1);
+    REQUIRE(events[0].type == ssp::eSurfaceEvent::Diverged);
+    REQUIRE(events[0].since == Approx(5.8));
+    REQUIRE(events[0].time == Approx(8.8));
+    REQUIRE(monitor.Stats().diverged);
+    REQUIRE(monitor.Stats().meanDifference == Approx(2.5).margin(0.02));
+
+    Feed(5, 1495);
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[1].type == ssp::eSurfaceEvent::Recovered);
+
+    // A brief excursion moves the mean past the threshold, but not for long enough
+    Feed(0.5, 1500);
+    Feed(3, 1495);
+    REQUIRE(events.size() == 2);
+
+    // A new profile restarts the comparison against the samples already in the window
+    monitor.SetProfileSpeed(1493);
+    REQUIRE(monitor.Stats().meanDifference == Approx(2).margin(0.02));
+    REQUIRE_FALSE(monitor.Stats().diverged);
+    monitor.SetProfile(*ssp::CompileProfile(cast));
+    REQUIRE(monitor.Stats().profileSpeed == Approx(1495));
+
+    monitor.Add(sample * 0.05, std::nan(""));
+    monitor.Add(sample * 0.05, -1);
+    monitor.Add(0, 1495);  // Earlier than the latest sample
+    REQUIRE(monitor.Stats().rejected == 3);
+
+    // The ring buffer bounds the window
+    options.maxSamples = 8;
+    ssp::SurfaceMonitor small(options);
+    for (int n = 0; n < 100; ++n)
+        small.Add(n * 0.05, 1500 + n);
+    REQUIRE(small.Stats().count == 8);
+    REQUIRE(small.Stats().stdDifference == Approx(std::sqrt(63.0 / 12.0)));
+    small.Reset();
+    REQUIRE(small.Stats().count == 0);
+
+    return;
+}
+
+
+TEST_CASE("Quality control flags", "[qc]")
+{
+    // Rolling median and MAD match a brute force version, including windows with repeated values
+    std::vector<double> values(300);
+    for (size_t n = 0; n < values.size(); ++n)
+        values[n] = std::floor(10 * std::sin(n * 0.7) + 5 * std::cos(n * 0.13));
+    std::vector<double> median(values.size()), mad(values.size());
+    for (size_t window : { 1, 2, 7, 24 })
+    {
+        ssp::RollingMedian(values.data(), values.size(), window, median.data(), mad.data());
+        for (size_t n = 0; n < values.size(); ++n)
+        {
+            const size_t half = window / 2;
+            std::vector<double> w(values.begin() + (n > half ? n - half : 0), values.begin() + std::min(values.size(), n + half + 1));
+            std::sort(w.begin(), w.end());
+            const double m = w[(w.size() - 1) / 2];
+            for (auto& v : w)
+                v = std::abs(v - m);
+            std::sort(w.begin(), w.end());
+            REQUIRE(median[n] == m);
+            REQUIRE(mad[n] == w[(w.size() - 1) / 2]);
+        }
+    }
+
+    // A smooth CTD cast with injected problems
+    ssp::SCast cast;
+    cast.lat = 45;
+    for (int n = 0; n < 200; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = 1.0 + n;
+        entry.temp = 4.0 + 10.0 * std::exp(-entry.depth / 40.0) + 0.01 * std::sin(n * 1.3);
+        entry.salinity = 33.0 + 2.0 * (1.0 - std::exp(-entry.depth / 60.0));
+        entry.c = ssp::WongZhu(entry.temp, entry.salinity, ssp::DepthToPressure(entry.depth, 45));
+        cast.entries.push_back(entry);
+    }
+    cast.entries[20].c = -9.990e-29;  // Bad value marker
+    cast.entries[50].salinity = 5.0;  // Salinity dropout
+    cast.entries[80].c += 3.0;  // Sound speed spike
+    for (int n = 120; n < 200; ++n)
+        cast.entries[n].temp += 1.5;  // A step of 1.5 C over 1 m, which is also lighter water below
+    for (int n = 120; n < 200; ++n)
+        cast.entries[n].c = ssp::WongZhu(cast.entries[n].temp, cast.entries[n].salinity, ssp::DepthToPressure(cast.entries[n].depth, 45));
+
+    ssp::SQcOptions options;
+    options.maxTempGradient = 1.0;
+    REQUIRE(ssp::QualityCheck(cast, options) == 4);
+    REQUIRE(cast.entries[20].flags == ssp::QcLimits);
+    REQUIRE(cast.entries[50].flags == ssp::QcSalinitySpike);
+    REQUIRE(cast.entries[80].flags == ssp::QcSpeedSpike);
+    REQUIRE(cast.entries[120].flags == (ssp::QcGradient | ssp::QcDensityInversion));
+    REQUIRE(cast.entries[51].flags == 0);  // Compared with the sample above the spike
+    REQUIRE(cast.entries[121].flags == 0);
+
+    // Checking again with other thresholds starts over
+    options.maxSpeedGradient = options.maxTempGradient = options.maxSalinityGradient = 0;
+    options.densityInversion = 0;
+    options.spikeThreshold = 0;
+    REQUIRE(ssp::QualityCheck(cast, options) == 1);
+    REQUIRE(cast.entries[120].flags == 0);
+
+    // Tables give the same flags
+    ssp::SCastTable table;
+    ssp::AppendCast(table, cast);
+    ssp::AppendCast(table, cast);
+    options = {};
+    options.maxTempGradient = 1.0;
+    REQUIRE(ssp::QualityCheck(table, options, 2) == 8);
+    REQUIRE(ssp::QualityCheck(cast, options) == 4);
+    for (size_t n = 0; n < cast.entries.size(); ++n)
+        REQUIRE(table.flags[cast.entries.size() + n] == cast.entries[n].flags);
+    REQUIRE(ssp::GetCast(table, 1).entries[80].flags == ssp::QcSpeedSpike);
+
+    REQUIRE(ssp::RemoveFlagged(cast, ssp::QcLimits | ssp::QcSpeedSpike) == 2);
+    REQUIRE(cast.entries.size() == 198);
+    REQUIRE(ssp::RemoveFlagged(cast) == 2);
+
+    // NaN is out of limits, and stays out of the rolling windows
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    cast.entries[30].temp = nan;
+    REQUIRE(ssp::QualityCheck(cast, options) == 2);  // The temperature step is now at the next sample down
+    REQUIRE(cast.entries[30].flags == ssp::QcLimits);
+    REQUIRE(cast.entries[29].flags == 0);
+    REQUIRE(cast.entries[31].flags == 0);
+
+    std::vector<double> gappy = { 1, nan, 3, 2, nan, nan, nan, 5 };
+    ssp::RollingMedian(gappy.data(), gappy.size(), 3, median.data(), mad.data());
+    REQUIRE(median[1] == 1);
+    REQUIRE(mad[1] == 0);
+    REQUIRE(median[2] == 2);
+    REQUIRE(std::isnan(median[5]));
+    REQUIRE(median[7] == 5);
+
+    return;
+}
+
+
+TEST_CASE("Splitting raw CTD casts", "[ctd]")
+{
+    // Raw series in time order: on deck, soak at 10 m (salinity 30), back up to 1 m, then down to 100 m with heave
+    //  loops (temperature 10) and back up to the surface (temperature 20)
+    ssp::SCast raw;
+    auto add = [&raw](double depth, double temp, double salinity)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = depth;
+        entry.c = 1500 + 0.1 * depth;
+        entry.temp = temp;
+        entry.salinity = salinity;
+        raw.entries.push_back(entry);
+    };
+    for (int n = 0; n < 5; ++n)
+        add(-0.5, 10, 30);
+    for (int n = 0; n < 300; ++n)
+        add(std::min(10.0, n * 0.1) + 0.05 * std::sin(n * 1.3), 10, 30);
+    for (int n = 0; n <= 90; ++n)
+        add(10 - n * 0.1, 10, 30);
+    for (int n = 0; n <= 2000; ++n)
+        add(1 + n * 0.0495 + (n < 1900 ? 0.4 * std::sin(n * 0.2) : 0.0), 10, 35);
+    const size_t deepest = raw.entries.size() - 1;
+    for (int n = 1; n <= 1000; ++n)
+        add(raw.entries[deepest].depth - n * 0.1, 20, 35);
+    for (int n = 0; n < 20; ++n)
+        add(-0.2, 20, 35);
+
+    REQUIRE(ssp::FindTurningPoint(raw) == deepest);
+
+    // Downcast: only the final descent, strictly deeper each sample
+    ssp::SCastSplitOptions options;
+    options.binSize = 0;
+    ssp::SCast down = raw;
+    const size_t numDown = ssp::SplitCast(down, options);
+    REQUIRE(numDown == down.entries.size());
+    REQUIRE(down.entries.front().depth < options.soakDepth);
+    REQUIRE(down.entries.back().depth == raw.entries[deepest].depth);
+    for (size_t n = 0; n < down.entries.size(); ++n)
+    {
+        REQUIRE(down.entries[n].temp == 10);
+        REQUIRE(down.entries[n].salinity == 35);
+        if (n > 0)
+            REQUIRE(down.entries[n].depth > down.entries[n - 1].depth);
+    }
+
+    // Upcast: sorted by depth as well, without the samples out of the water
+    options.direction = ssp::eCastDirection::Up;
+    ssp::SCast up = raw;
+    ssp::SplitCast(up, options);
+    REQUIRE(up.entries.front().depth >= 0);
+    REQUIRE(up.entries.back().depth == raw.entries[deepest].depth);
+    for (size_t n = 1; n < up.entries.size(); ++n)
+    {
+        REQUIRE(up.entries[n - 1].temp == 20);  // The turning point is shared with the downcast
+        REQUIRE(up.entries[n].depth > up.entries[n - 1].depth);
+    }
+
+    // Binning averages each run of samples onto the bin centers
+    options.direction = ssp::eCastDirection::Down;
+    options.binSize = 2;
+    ssp::SCast binned = raw;
+    const size_t numBins = ssp::SplitCast(binned, options);
+    REQUIRE(numBins == binned.entries.size());
+    REQUIRE(binned.entries.front().depth == 2);
+    REQUIRE(binned.entries.back().depth == 2 * std::floor(raw.entries[deepest].depth / 2 + 0.5));
+    REQUIRE(numBins == size_t(binned.entries.back().depth / 2));
+    for (const auto& entry : binned.entries)
+    {
+        REQUIRE(entry.c == Approx(1500 + 0.1 * entry.depth).margin(0.11));
+        REQUIRE(entry.temp == Approx(10));
+    }
+
+    // Binning a sorted cast directly gives the same result
+    ssp::SCast rebinned = down;
+    REQUIRE(ssp::BinAverage(rebinned, 2) == numBins);
+    REQUIRE(rebinned.entries.back().c == binned.entries.back().c);
+
+    std::vector<ssp::SCast> casts(4, raw);
+    ssp::SplitCasts(casts, options, 2);
+    for (const auto& cast : casts)
+        REQUIRE(cast.entries.size() == numBins);
+
+    ssp::SCast empty;
+    REQUIRE(ssp::SplitCast(empty) == 0);
+
+    // Samples without a valid depth are dropped rather than binned
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    ssp::SCast bad;
+    for (double depth : { nan, 0.5, 1.0, 2.0, 3.0, nan, 4.0, 5.0, nan })
+    {
+        ssp::SCastEntry entry;
+        entry.depth = depth;
+        entry.c = 1500;
+        bad.entries.push_back(entry);
+    }
+    ssp::SCast sorted = bad;
+    REQUIRE(ssp::BinAverage(sorted, 1) == 5);
+    REQUIRE(sorted.entries.front().depth == 1);
+    REQUIRE(sorted.entries.back().depth == 5);
+    REQUIRE(ssp::FindTurningPoint(bad) == 7);
+    REQUIRE(ssp::SplitCast(bad, options) == 3);
+    for (const auto& entry : bad.entries)
+        REQUIRE(std::isfinite(entry.depth));
+}
+
+
 TEST_CASE("Latitude-longitude setting", "[lat-long]")
 {
     ssp::SLatLong s;
@@ -107,4 +795,1012 @@ TEST_CASE("Conductivity to salinity", "[salinity]")
     REQUIRE(ssp::ConductivityToSalinity(1.3981451 * 4.2914, 2000, 30) == Approx(35.5783));
 
     return;
-}
\ No newline at end of file
+}
+
+TEST_CASE("Multi-cast Hypack file", "[multicast]")
+{
+    const std::string fileName = "multicast_test.vel";
+    {
+        std::ofstream out(fileName);
+        for (int n = 0; n < 40; ++n)
+        {
+            out << "FTP NEW 3 43.1 -70.5 15:" << (10 + n) << " 08/19/2019\n";
+            for (int d = 0; d <= n; ++d)
+                out << d << " " << 1480 + n << "\n";
+        }
+    }
+
+    auto casts = ssp::ReadCastsFromFile(fileName, ssp::eCastType::Hypack);
+    REQUIRE(casts.size() == 40);
+    REQUIRE(casts[0].entries.size() == 1);
+    REQUIRE(casts[39].entries.size() == 40);
+    REQUIRE(casts[39].entries[0].c == Approx(1519));
+    REQUIRE(casts[39].time.tm_min == 49);
+
+    // Parallel parsing must keep file order, and the callback can stop early
+    size_t count = 0;
+    bool ordered = true;
+    size_t numRead = ssp::ReadCastsFromFile(fileName, ssp::eCastType::Hypack, [&](ssp::SCast& cast)
+    {
+        ordered = ordered && cast.entries.size() == count + 1;
+        return ++count < 25;
+    }, 4);
+    REQUIRE(ordered);
+    REQUIRE(count == 25);
+    REQUIRE(numRead == 25);
+
+    std::remove(fileName.c_str());
+    return;
+}
+
+
+TEST_CASE("Bulk UNB reading", "[unb]")
+{
+    auto writeRecord = [](std::ofstream& out, int numEntries, double c)
+    {
+        out << "2  # version\n2019 231 15:47:00  # date/time\n0 0 0:0:0\n43.5 -70.25\n0 0\n" << numEntries << "\n";
+        for (int m = 0; m < 10; ++m)
+            out << "0\n";
+        for (int n = 0; n < numEntries; ++n)
+            out << n + 1 << " " << n * 2.5 << " " << c << " 10.5 35.0 0 0\n";
+    };
+
+    const std::string fileName = "bulk_test.unb";
+    {
+        std::ofstream out(fileName);
+        writeRecord(out, 3, 1490.0);
+        out << "\n";
+        writeRecord(out, 5, 1500.0);
+    }
+
+    auto cast = ssp::ReadCast(fileName, ssp::eCastType::Unb);
+    REQUIRE(cast);
+    REQUIRE(cast->entries.size() == 3);
+    REQUIRE(cast->lat == Approx(43.5));
+    REQUIRE(cast->time.tm_mon == 7);  // Day 231 of 2019 is August 19th
+    REQUIRE(cast->time.tm_mday == 19);
+
+    ssp::SCastTable table;
+    REQUIRE(ssp::ReadUnbCasts(fileName, table) == 2);
+    REQUIRE(table.NumCasts() == 2);
+    REQUIRE(table.NumSamples() == 8);
+    REQUIRE(table.offsets[1] == 3);
+    REQUIRE(table.c[7] == Approx(1500.0));
+    REQUIRE(ssp::GetCast(table, 1).entries[4].depth == Approx(10.0));
+
+    // A directory is filled in filename order after the casts already in the table. The malformed last
+    // record of b.unb is dropped.
+    const std::string dirName = "bulk_test_unb";
+    std::filesystem::create_directory(dirName);
+    {
+        std::ofstream out(dirName + "/b.unb");
+        writeRecord(out, 4, 1510.0);
+        out << "\n2  # version\nnot a date\n";
+    }
+    {
+        std::ofstream out(dirName + "/a.unb");
+        writeRecord(out, 2, 1520.0);
+    }
+    REQUIRE(ssp::ReadUnbCasts(dirName, table, 2) == 2);
+    REQUIRE(table.NumCasts() == 4);
+    REQUIRE(table.NumSamples() == 14);
+    REQUIRE(table.offsets == std::vector<size_t>{ 0, 3, 8, 10, 14 });
+    REQUIRE(table.c[8] == Approx(1520.0));
+    REQUIRE(table.c[13] == Approx(1510.0));
+    REQUIRE(table.depth[13] == Approx(7.5));
+    REQUIRE(table.pressure.size() == 14);
+    REQUIRE(table.flags.size() == 14);
+    REQUIRE(table.fileNames[3].find("b.unb") != std::string::npos);
+
+    std::filesystem::remove_all(dirName);
+    std::remove(fileName.c_str());
+    return;
+}
+
+
+TEST_CASE("XBT fall rate and AOML reading", "[aoml]")
+{
+    // Hanawa et al. (1995) T-7: z = 6.691 t - 0.00225 t^2
+    REQUIRE(ssp::XbtDepth(100.0, ssp::eXbtProbe::T7) == Approx(646.6));
+    REQUIRE(ssp::XbtProbeFromName("Deep Blue") == ssp::eXbtProbe::DeepBlue);
+    REQUIRE(ssp::XbtProbeFromName("T-5") == ssp::eXbtProbe::T5);
+
+    const std::string fileName = "aoml_test.txt";
+    {
+        std::ofstream out(fileName);
+        out << "Ship Name          | Test Ship\n";
+        out << "Year               | 2018\nMonth              | 11\nDay                | 29\n";
+        out << "Hour               | 17\nMinute             | 49\n";
+        out << "Latitude           | 26 30.0 N\nLongitude          | 78 15.0 W\n";
+        out << "Probe Type         | T-7\n";
+        out << "================================\n\nTime Temperature\n";
+        out << "0.0 25.0\n10.0 24.5\n100.0 12.0\n";
+    }
+
+    auto cast = ssp::ReadCast(fileName, ssp::eCastType::Aoml);
+    REQUIRE(cast);
+    REQUIRE(cast->lat == Approx(26.5));
+    REQUIRE(cast->lon == Approx(-78.25));
+    REQUIRE(cast->time.tm_year == 118);
+    REQUIRE(cast->time.tm_mday == 29);
+    REQUIRE(cast->entries.size() == 3);
+    REQUIRE(cast->entries[2].depth == Approx(646.6));
+    REQUIRE(cast->entries[2].c == Approx(ssp::WongZhu(12.0, 35.0, ssp::DepthToPressure(646.6, 26.5))));
+
+    auto unesco = ssp::ReadCast(fileName, ssp::eCastType::Aoml, ssp::eSoundSpeedEquation::ChenMillero);
+    REQUIRE(unesco);
+    REQUIRE(unesco->entries[2].c == Approx(ssp::SoundSpeed(ssp::eSoundSpeedEquation::ChenMillero, 12.0, 35.0,
+        ssp::DepthToPressure(646.6, 26.5))));
+
+    std::remove(fileName.c_str());
+    return;
+}
+
+
+TEST_CASE("Oceanscience reading", "[oceanscience]")
+{
+    const std::string fileName = "oceanscience_test.asc";
+    {
+        std::ofstream out(fileName);
+        out << "* Oceanscience UnderwaySV\n* Cast time: 2021-09-21 14:03:12\n";
+        out << "* Latitude: 41 30.0 N\n* Longitude: 070 40.5 W\n";
+        out << "1 4.2914 15.0 0.0\n2 4.2914 15.0 10.0\n3 4.5 14.0 50.0\n";
+    }
+
+    auto cast = ssp::ReadCast(fileName, ssp::eCastType::Oceanscience);
+    REQUIRE(cast);
+    REQUIRE(cast->lat == Approx(41.5));
+    REQUIRE(cast->lon == Approx(-70.675));
+    REQUIRE(cast->time.tm_hour == 14);
+    REQUIRE(cast->time.tm_mon == 8);
+    REQUIRE(cast->entries.size() == 3);
+    REQUIRE(cast->entries[0].salinity == Approx(35.0));
+    REQUIRE(cast->entries[0].temp == Approx(15.0));
+    REQUIRE(cast->entries[2].pressure == Approx(5.0));
+    REQUIRE(cast->entries[2].depth == Approx(ssp::Depth(5.0, 41.5)));
+    REQUIRE(cast->entries[2].c == Approx(ssp::WongZhu(14.0, cast->entries[2].salinity, 5.0)));
+
+    auto delGrosso = ssp::ReadCast(fileName, ssp::eCastType::Oceanscience, ssp::eSoundSpeedEquation::DelGrosso);
+    REQUIRE(delGrosso);
+    REQUIRE(delGrosso->entries[2].c == Approx(ssp::SoundSpeed(ssp::eSoundSpeedEquation::DelGrosso, 14.0, cast->entries[2].salinity, 5.0)));
+
+    // Text after the coordinates and keys that only contain "time" or "date" are left alone
+    {
+        std::ofstream out(fileName);
+        out << "* Date/Time: 2021-09-21 14:03:12\n* Elapsed time: 00:10:00\n* Calibration date: 2019-01-02\n";
+        out << "* Latitude: 43.5 N (WGS84)\n* Longitude (deg): -63.25 (WGS84)\n";
+        out << "1 4.2914 15.0 0.0\n2 4.2914 15.0 10.0\n";
+    }
+    cast = ssp::ReadCast(fileName, ssp::eCastType::Oceanscience);
+    REQUIRE(cast);
+    REQUIRE(cast->lat == Approx(43.5));
+    REQUIRE(cast->lon == Approx(-63.25));
+    REQUIRE(cast->time.tm_year == 121);
+    REQUIRE(cast->time.tm_hour == 14);
+    REQUIRE(cast->time.tm_min == 3);
+
+    std::remove(fileName.c_str());
+    return;
+}
+
+
+TEST_CASE("Sea & Sun reading", "[seaandsun]")
+{
+    const std::string fileName = "seaandsun_test.tob";
+    {
+        std::ofstream out(fileName);
+        out << "; Sea & Sun Technology\n;\n";
+        out << "Freitag, 20. Juli 2018 16:54:38\n";
+        out << "\n";  // Short lines in the header used to make the file fail to load
+        out << "  Position : Lat.: 54° 19.5' N Lon.: 10° 9.2' E\n";
+        out << "Lines : 3\n;\n";
+        out << "; Datasets  IntD  Press  Temp  Cond  SIGMA\n";
+        out << ";  [ date]  [ dbar]  [ degC]  [mS/cm]  [kg/m3]\n;\n";
+        out << "  1  20.07.2018  0.0  15.0  42.914  25.0\n";
+        out << "  2  20.07.2018  10.0  15.0  42.914  25.1\n";
+        out << "  3  20.07.2018  20.0  14.0  43.0  25.2\n";
+    }
+
+    auto cast = ssp::ReadCast(fileName, ssp::eCastType::SeaAndSun);
+    REQUIRE(cast);
+    REQUIRE(cast->lat == Approx(54.325));
+    REQUIRE(cast->entries.size() == 3);
+    REQUIRE(cast->entries[1].pressure == Approx(1.0));
+    REQUIRE(cast->entries[0].salinity == Approx(35.0));  // 42.914 mS/cm at 15 C
+    REQUIRE(cast->entries[1].depth == Approx(ssp::Depth(1.0, cast->lat)));
+    REQUIRE(cast->entries[1].c == Approx(ssp::WongZhu(15.0, cast->entries[1].salinity, 1.0)));
+
+    // Channels without units take the instrument's usual ones (dbar, not bar), and only whole temperature units count
+    const char* header = "; Sea & Sun Technology\n;\nFreitag, 20. Juli 2018 16:54:38\nLines : 2\n;\n";
+    for (const char* tempUnits : { "", "  [ °F]", "  [ fathoms]" })
+    {
+        {
+            std::ofstream out(fileName);
+            out << header << "; Datasets  IntD  Press  Temp\n";
+            out << ";  [ date]  [ dbar]" << tempUnits << "\n;\n";
+            out << "  1  20.07.2018  0.0  59.0\n  2  20.07.2018  10.0  59.0\n";
+        }
+        cast = ssp::ReadCast(fileName, ssp::eCastType::SeaAndSun);
+        if (std::string(tempUnits).find("fathoms") != std::string::npos)
+        {
+            REQUIRE(!cast);
+            continue;
+        }
+        REQUIRE(cast);
+        REQUIRE(cast->entries[1].pressure == Approx(1.0));
+        REQUIRE(cast->entries[1].temp == Approx(tempUnits[0] ? 15.0 : 59.0));
+    }
+    {
+        std::ofstream out(fileName);
+        out << header << "; Datasets  IntD  Press  Temp\n;  [ date]\n;\n  1  20.07.2018  10.0  15.0\n  2  20.07.2018  20.0  15.0\n";
+    }
+    cast = ssp::ReadCast(fileName, ssp::eCastType::SeaAndSun);
+    REQUIRE(cast);
+    REQUIRE(cast->entries[0].pressure == Approx(1.0));
+
+    std::remove(fileName.c_str());
+    return;
+}
+
+
+TEST_CASE("Simple text reading", "[simple]")
+{
+    const std::string fileName = "simple_test.txt";
+    {
+        std::ofstream out(fileName);
+        out << "# Depth, sound speed\n  % another comment\n// and another\n";
+        out << "0.0, 1500.5\n\n1.5;1501.0  # trailing comment\n  3 \t 1502.25\n";
+    }
+
+    auto cast = ssp::ReadCast(fileName, ssp::eCastType::Simple);
+    REQUIRE(cast);
+    REQUIRE(cast->entries.size() == 3);  // Blank lines no longer end the data
+    REQUIRE(cast->entries[1].depth == Approx(1.5));
+    REQUIRE(cast->entries[2].c == Approx(1502.25));
+
+    // Units after the numbers are skipped
+    {
+        std::ofstream out(fileName);
+        out << "Depth Speed\n10 m 1500 m/s\n20m, 1501.5m/s\n";
+    }
+    cast = ssp::ReadCast(fileName, ssp::eCastType::Simple);
+    REQUIRE(cast);
+    REQUIRE(cast->entries.size() == 2);
+    REQUIRE(cast->entries[0].depth == 10);
+    REQUIRE(cast->entries[1].c == 1501.5);
+
+    {
+        std::ofstream out(fileName);
+        out << "temp|depth|sal\n";
+        out << "10.0|5.0|35.0\n12.0|10.0|34.5\n";
+    }
+
+    ssp::SSimpleFormat format;
+    format.delimiter = '|';
+    format.columns = { ssp::eSimpleColumn::Temperature, ssp::eSimpleColumn::Depth, ssp::eSimpleColumn::Salinity };
+    cast = ssp::ReadSimple(fileName, format);  // The text header line is skipped
+    REQUIRE(cast);
+    REQUIRE(cast->entries.size() == 2);
+
+    {
+        std::ofstream out(fileName);
+        out << "temp|depth|sal\nT|D|S\n";
+    }
+    REQUIRE(!ssp::ReadSimple(fileName, format));  // Nothing but headers
+
+    {
+        std::ofstream out(fileName);
+        out << "% temp|depth|sal\n10.0|5.0|35.0\n12.0|10.0|34.5\n";
+    }
+    cast = ssp::ReadSimple(fileName, format);
+    REQUIRE(cast);
+    REQUIRE(cast->entries.size() == 2);
+    REQUIRE(cast->entries[1].temp == Approx(12.0));
+    REQUIRE(cast->entries[1].depth == Approx(10.0));
+    REQUIRE(cast->entries[1].c == Approx(ssp::WongZhu(12.0, 34.5, ssp::DepthToPressure(10.0, 0.0))));
+
+    std::remove(fileName.c_str());
+    return;
+}
+
+
+TEST_CASE("Writer round trips", "[writers]")
+{
+    ssp::SCast cast;
+    cast.time = ssp::CreateTime(2021, 7, 7, 22, 25, 37);
+    cast.lat = 43.071234567890123;  // More digits than a fixed precision would keep
+    cast.lon = -7.0711234e-5;  // Written with an exponent
+    for (int n = 0; n < 50; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 0.7;
+        entry.c = 1480.123 + n * 0.01;
+        entry.temp = 20 - n * 0.1;
+        entry.salinity = 32.5 + n * 0.01;
+        cast.entries.push_back(entry);
+    }
+
+    const std::vector<std::pair<ssp::eCastType, std::string>> types = {
+        { ssp::eCastType::Asvp, "writer_test.asvp" }, { ssp::eCastType::Hypack, "writer_test.vel" },
+        { ssp::eCastType::SeaBirdTsv, "writer_test.tsv" }, { ssp::eCastType::Sonardyne, "writer_test.pro" },
+        { ssp::eCastType::Unb, "writer_test.unb" } };
+
+    for (const auto& [type, fileName] : types)
+    {
+        {
+            std::ofstream out(fileName, std::ios::binary);
+            REQUIRE(ssp::WriteCast(cast, type, out));
+        }
+
+        auto read = ssp::ReadCast(fileName);
+        REQUIRE(read);
+        REQUIRE(read->entries.size() == cast.entries.size());
+        REQUIRE(read->entries[17].depth == cast.entries[17].depth);
+        REQUIRE(read->entries[17].c == cast.entries[17].c);
+        REQUIRE(read->time.tm_mday == 7);
+        REQUIRE(read->time.tm_hour == 22);
+        REQUIRE(read->time.tm_min == 25);
+        REQUIRE(read->time.tm_sec == (type == ssp::eCastType::Hypack ? 0 : 37));  // Hypack only keeps minutes
+        if (type != ssp::eCastType::Sonardyne)  // No position in this format
+        {
+            REQUIRE(read->lat == cast.lat);
+            REQUIRE(read->lon == cast.lon);
+        }
+        if (type == ssp::eCastType::SeaBirdTsv || type == ssp::eCastType::Unb || type == ssp::eCastType::Sonardyne)
+            REQUIRE(read->entries[17].salinity == cast.entries[17].salinity);
+    }
+
+    // Files with the same name do not overwrite each other when converted
+    const std::filesystem::path outputDir = std::filesystem::temp_directory_path() / "sspcpp_convert_test";
+    std::filesystem::remove_all(outputDir);
+    REQUIRE(ssp::ConvertCasts({ "writer_test.asvp", "writer_test.vel", "writer_test.asvp" }, outputDir.string(),
+        ssp::eCastType::Unb, 2) == 3);
+    for (const char* name : { "writer_test.unb", "writer_test_vel.unb", "writer_test_asvp.unb" })
+    {
+        auto read = ssp::ReadCast((outputDir / name).string());
+        REQUIRE(read);
+        REQUIRE(read->entries.size() == cast.entries.size());
+    }
+    std::filesystem::remove_all(outputDir);
+
+    for (const auto& [type, fileName] : types)
+        std::remove(fileName.c_str());
+
+    return;
+}
+
+
+TEST_CASE("Profile thinning", "[thinning]")
+{
+    ssp::SCast cast;
+    for (int n = 0; n <= 1000; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 0.5;
+        entry.c = 1500.0 + 20.0 * std::exp(-entry.depth / 50.0) + 0.01 * std::sin(n * 0.37);
+        cast.entries.push_back(entry);
+    }
+
+    ssp::SCast dp = cast;
+    const double dpError = ssp::ThinDouglasPeucker(dp, 0.1);
+    REQUIRE(dp.entries.size() < 100);
+    REQUIRE(dp.entries.front().depth == 0.0);
+    REQUIRE(dp.entries.back().depth == 500.0);
+    REQUIRE(dpError < 1e-4);
+
+    ssp::SCast counted = cast;
+    const double countError = ssp::ThinToCount(counted, 20);
+    REQUIRE(counted.entries.size() == 20);
+    REQUIRE(countError == Approx(ssp::MaxTravelTimeError(cast, counted)));
+
+    ssp::SCast binned = cast;
+    ssp::ThinDepthBins(binned, 10.0);
+    REQUIRE(binned.entries.size() == 52);  // 50 bins plus the two end points
+
+    REQUIRE(ssp::MaxTravelTimeError(cast, cast) == 0.0);
+
+    // Entries with a missing depth are dropped rather than stalling the bins
+    for (size_t bad : { size_t(0), size_t(2) })
+    {
+        const size_t numBinned = (bad == 0) ? 3 : 4;  // 0.5 to 2 m is two 1 m bins, 0 to 2 m is three
+        ssp::SCast gappy;
+        gappy.entries.assign(cast.entries.begin(), cast.entries.begin() + 5);
+        gappy.entries[bad].depth = std::numeric_limits<double>::quiet_NaN();
+        ssp::SCast binnedGappy = gappy, dpGappy = gappy, countedGappy = gappy;
+        REQUIRE(std::isfinite(ssp::ThinDepthBins(binnedGappy, 1.0)));
+        REQUIRE(binnedGappy.entries.size() == numBinned);
+        REQUIRE(std::isfinite(ssp::ThinDouglasPeucker(dpGappy, 0.0)));
+        REQUIRE(dpGappy.entries.size() == 4);
+        REQUIRE(std::isfinite(ssp::ThinToCount(countedGappy, 3)));
+        REQUIRE(countedGappy.entries.size() == 3);
+        for (const auto* thinned : { &binnedGappy, &dpGappy, &countedGappy })
+        {
+            for (const auto& entry : thinned->entries)
+                REQUIRE(std::isfinite(entry.depth));
+        }
+    }
+
+    return;
+}
+
+
+TEST_CASE("Depth grid resampling", "[resample]")
+{
+    std::vector<ssp::SCast> casts(3);
+    for (size_t n = 0; n < casts.size(); ++n)
+    {
+        for (int k = 0; k <= 40; ++k)
+        {
+            ssp::SCastEntry entry;
+            entry.depth = k * 0.25;
+            entry.c = 1500.0 + n + entry.depth;
+            entry.temp = 10.0;
+            casts[n].entries.push_back(entry);
+        }
+    }
+    casts[2].entries.resize(21);  // Only to 5 m
+
+    ssp::SDepthGrid grid;
+    grid.start = 0.0;
+    grid.step = 1.0;
+    grid.count = 12;
+
+    auto interp = ssp::ResampleCasts(casts, grid, ssp::eResampleMode::Interpolate, 2);
+    REQUIRE(interp.numCasts == 3);
+    REQUIRE(interp.c.size() == 36);
+    REQUIRE(interp.salinity.empty());
+    REQUIRE(interp.Column(interp.c, 1)[3] == Approx(1504.0));
+    REQUIRE(interp.Column(interp.c, 0)[10] == Approx(1510.0));
+    REQUIRE(std::isnan(interp.Column(interp.c, 0)[11]));
+    REQUIRE(interp.Column(interp.c, 2)[5] == Approx(1507.0));
+    REQUIRE(std::isnan(interp.Column(interp.c, 2)[6]));
+
+    ssp::SCastTable table;
+    for (const auto& cast : casts)
+        ssp::AppendCast(table, cast);
+    auto binned = ssp::ResampleCasts(table, grid, ssp::eResampleMode::BinAverage);
+    REQUIRE(binned.Column(binned.c, 0)[0] == Approx(1500.125));  // 0 and 0.25 m
+    REQUIRE(binned.Column(binned.c, 0)[4] == Approx(1503.875));  // 3.5 to 4.25 m
+    REQUIRE(binned.Column(binned.temp, 1)[4] == Approx(10.0));
+    REQUIRE(std::isnan(binned.Column(binned.c, 0)[11]));
+
+    auto single = ssp::ResampleCast(casts[1], grid, ssp::eResampleMode::Interpolate);
+    REQUIRE(single.c[3] == Approx(1504.0));
+
+    // Bad depths are stepped over, and grids without a positive step are refused
+    ssp::SCast gappy = casts[1];
+    gappy.entries[12].depth = std::numeric_limits<double>::quiet_NaN();
+    auto interpGappy = ssp::ResampleCast(gappy, grid, ssp::eResampleMode::Interpolate);
+    REQUIRE(interpGappy.c[3] == Approx(1504.0));
+    auto binnedGappy = ssp::ResampleCast(gappy, grid, ssp::eResampleMode::BinAverage);
+    REQUIRE(binnedGappy.c[3] == Approx(1501 + (2.5 + 2.75 + 3.25) / 3));
+    for (double step : { 0.0, -1.0, std::numeric_limits<double>::quiet_NaN() })
+    {
+        grid.step = step;
+        auto refused = ssp::ResampleCasts(casts, grid, ssp::eResampleMode::BinAverage);
+        REQUIRE(refused.numCasts == 0);
+        REQUIRE(refused.c.empty());
+    }
+    grid.step = 1.0;
+    grid.count = static_cast<size_t>(std::numeric_limits<int>::max()) + 1;  // Too long for the int run counter
+    REQUIRE(ssp::ResampleCasts(casts, grid, ssp::eResampleMode::Interpolate).numCasts == 0);
+
+    return;
+}
+
+
+TEST_CASE("Climatology extension", "[climatology]")
+{
+    // 2 x 2 degree grid with levels every 500 m to 4000 m, warmer to the east and colder with depth
+    ssp::SClimatologyGrid grid;
+    grid.lat0 = 44.0;
+    grid.numLat = 2;
+    grid.lon0 = -64.0;
+    grid.numLon = 2;
+    for (int n = 0; n <= 8; ++n)
+        grid.depths.push_back(n * 500.0);
+    for (size_t lat = 0; lat < grid.numLat; ++lat)
+    {
+        for (size_t lon = 0; lon < grid.numLon; ++lon)
+        {
+            for (double depth : grid.depths)
+            {
+                grid.temp.push_back(static_cast<float>(10.0 + lon - depth / 1000.0));
+                grid.salinity.push_back(35.0f);
+            }
+        }
+    }
+    grid.temp[grid.temp.size() - 1] = std::numeric_limits<float>::quiet_NaN();  // Last corner stops at 3500 m
+
+    const std::string fileName = "climatology_test.bin";
+    REQUIRE(ssp::WriteClimatology(fileName, grid));
+
+    double temp = 0, salinity = 0;
+    REQUIRE(ssp::ClimatologyAt(fileName, 44.5, -63.5, 250.0, temp, salinity));
+    REQUIRE(temp == Approx(10.25));
+    REQUIRE(salinity == Approx(35.0));
+    REQUIRE(!ssp::ClimatologyAt(fileName, 50.0, -63.5, 250.0, temp, salinity));
+
+    ssp::SCast cast;
+    cast.lat = 44.0;
+    cast.lon = -64.0;
+    for (int n = 0; n <= 100; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 5.0;
+        entry.temp = 12.0 - entry.depth / 1000.0;  // 2 degrees warmer than the climatology
+        entry.salinity = 35.0;
+        entry.pressure = ssp::DepthToPressure(entry.depth, cast.lat);
+        entry.c = ssp::WongZhu(entry.temp, entry.salinity, entry.pressure);
+        cast.entries.push_back(entry);
+    }
+
+    const size_t added = ssp::ExtendCast(cast, fileName, 10.0, 100.0);
+    REQUIRE(added == 350);
+    REQUIRE(cast.entries.back().depth == 4000.0);
+    REQUIRE(cast.entries[101].temp == Approx(9.49 + 0.9 * 2.0));  // 10 m into the blend
+    REQUIRE(cast.entries[120].temp == Approx(10.0 - 0.7));  // Past the blend
+    REQUIRE(cast.entries[101].c - cast.entries[100].c < 0.0);
+    REQUIRE(std::abs(cast.entries[101].c - cast.entries[100].c) < 1.0);
+
+    // A cast ending at exactly 0 C still has its temperature matched
+    cast.entries.resize(101);
+    for (auto& entry : cast.entries)
+        entry.temp = 0.5 - entry.depth / 1000.0;
+    REQUIRE(ssp::ExtendCast(cast, fileName, 10.0, 100.0) == 350);
+    REQUIRE(cast.entries[100].temp == 0.0);
+    REQUIRE(cast.entries[101].temp == Approx(9.49 + 0.9 * (0.0 - 9.5)));
+
+    ssp::ClearClimatologyCache();
+    std::remove(fileName.c_str());
+
+    return;
+}
+
+
+TEST_CASE("Reading into a memory resource", "[pmr]")
+{
+    ssp::SCast cast;
+    cast.lat = 44.5;
+    cast.lon = -63.25;
+    cast.time = ssp::CreateTime(2021, 7, 7, 22, 25, 0);
+    for (int n = 0; n < 100; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 0.5;
+        entry.c = 1480.5 + n * 0.01;
+        cast.entries.push_back(entry);
+    }
+
+    const std::string fileName = "pmr_test.asvp";
+    {
+        std::ofstream out(fileName, std::ios::binary);
+        REQUIRE(ssp::WriteCast(cast, ssp::eCastType::Asvp, out));
+    }
+
+    std::vector<char> buffer(1 << 16);
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    ssp::pmr::SCast pmrCast(&arena);
+    REQUIRE(ssp::ReadCast(fileName, pmrCast));  // Would throw if anything went past the buffer
+    REQUIRE(pmrCast.entries.get_allocator().resource() == &arena);
+
+    auto stdCast = ssp::ReadCast(fileName);
+    REQUIRE(stdCast);
+    REQUIRE(pmrCast.entries.size() == stdCast->entries.size());
+    REQUIRE(pmrCast.entries[42].c == stdCast->entries[42].c);
+    REQUIRE(pmrCast.lat == stdCast->lat);
+    REQUIRE(pmrCast.time.tm_hour == 22);
+
+    // Containers pass their resource on to the casts in them
+    {
+        std::pmr::vector<ssp::pmr::SCast> casts(&arena);
+        casts.reserve(2);
+        REQUIRE(ssp::ReadCast(fileName, casts.emplace_back()));
+        casts.push_back(pmrCast);
+        REQUIRE(casts[0].entries.get_allocator().resource() == &arena);
+        REQUIRE(casts[1].entries.get_allocator().resource() == &arena);
+        REQUIRE(casts[1].entries.size() == pmrCast.entries.size());
+    }
+    REQUIRE(pmrCast.fileName == fileName.c_str());
+
+    std::remove(fileName.c_str());
+
+    return;
+}
+
+
+TEST_CASE("Parse cache", "[cache]")
+{
+    namespace fs = std::filesystem;
+
+    ssp::SCast cast;
+    cast.lat = 44.5;
+    cast.lon = -63.25;
+    cast.time = ssp::CreateTime(2021, 7, 7, 22, 25, 0);
+    for (int n = 0; n < 200; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 0.5;
+        entry.c = 1480.5 + n * 0.01;
+        entry.temp = 12.0 - n * 0.01;
+        entry.salinity = 34.0;
+        cast.entries.push_back(entry);
+    }
+
+    const std::string cacheDir = "parse_cache_test";
+    const std::string fileName = "cache_test.tsv";
+    {
+        std::ofstream out(fileName, std::ios::binary);
+        REQUIRE(ssp::WriteCast(cast, ssp::eCastType::SeaBirdTsv, out));
+    }
+
+    for (auto key : { ssp::eCacheKey::FileInfo, ssp::eCacheKey::ContentHash })
+    {
+        REQUIRE(ssp::EnableParseCache(cacheDir, 1 << 20, key));
+        ssp::ClearParseCache();
+
+        auto first = ssp::ReadCast(fileName);
+        auto second = ssp::ReadCast(fileName);
+        REQUIRE(first);
+        REQUIRE(second);
+        auto stats = ssp::GetParseCacheStats();
+        REQUIRE(stats.misses == 1);
+        REQUIRE(stats.hits == 1);
+        REQUIRE(stats.bytes > 200 * sizeof(ssp::SCastEntry));
+
+        REQUIRE(second->entries.size() == first->entries.size());
+        REQUIRE(second->entries[123].c == first->entries[123].c);
+        REQUIRE(second->entries[123].salinity == first->entries[123].salinity);
+        REQUIRE(second->lat == first->lat);
+        REQUIRE(second->time.tm_hour == first->time.tm_hour);
+        REQUIRE(second->desc == first->desc);
+        REQUIRE(second->fileName == fileName);
+
+        ssp::InvalidateParseCache(fileName);
+        REQUIRE(ssp::ReadCast(fileName));
+        REQUIRE(ssp::GetParseCacheStats().misses == 2);
+    }
+
+    // A tiny limit keeps only the most recent entry
+    REQUIRE(ssp::EnableParseCache(cacheDir, 1, ssp::eCacheKey::FileInfo));
+    REQUIRE(ssp::GetParseCacheStats().bytes == 0);
+    REQUIRE(ssp::ReadCast(fileName));
+    REQUIRE(ssp::GetParseCacheStats().evictions >= 1);
+
+    ssp::DisableParseCache();
+    fs::remove_all(cacheDir);
+    std::remove(fileName.c_str());
+
+    return;
+}
+
+
+TEST_CASE("Shared memory profile", "[shared]")
+{
+    const std::string name = "SspCppTest" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    ssp::ProfileSubscriber subscriber;
+    REQUIRE_FALSE(subscriber.Open(name));
+
+    ssp::ProfilePublisher publisher;
+    REQUIRE(publisher.Open(name, 1000));
+    REQUIRE(subscriber.Open(name));
+
+    ssp::SCast cast;
+    REQUIRE_FALSE(subscriber.Read(cast));  // Nothing published yet
+    REQUIRE_FALSE(subscriber.WaitForUpdate(0, std::chrono::milliseconds(1)));
+
+    ssp::SCast sent;
+    sent.desc = "Shared";
+    sent.fileName = "shared.asvp";
+    sent.lat = 44.5;
+    sent.lon = -63.25;
+    sent.time = ssp::CreateTime(2021, 7, 7, 22, 25, 0);
+    sent.entries.resize(500);
+    for (int n = 0; n < 500; ++n)
+    {
+        sent.entries[n].depth = n;
+        sent.entries[n].c = 1500 + n * 0.01;
+    }
+    REQUIRE(publisher.Publish(sent));
+    REQUIRE(subscriber.WaitForUpdate(0, std::chrono::milliseconds(100)));
+
+    uint64_t version = 0;
+    REQUIRE(subscriber.Read(cast, &version));
+    REQUIRE(version == 1);
+    REQUIRE(cast.desc == "Shared");
+    REQUIRE(cast.fileName == "shared.asvp");
+    REQUIRE(cast.lat == 44.5);
+    REQUIRE(cast.time.tm_hour == 22);
+    REQUIRE(cast.entries.size() == 500);
+    REQUIRE(cast.entries[321].c == sent.entries[321].c);
+
+    sent.entries.resize(1001);
+    REQUIRE_FALSE(publisher.Publish(sent));  // Larger than the region
+
+    // Every entry of one publication carries the same value, so a torn read would show up as a mix
+    std::atomic<bool> done{ false };
+    std::thread writer([&]() {
+        ssp::SCast update;
+        for (int i = 1; i <= 2000; ++i)
+        {
+            update.entries.assign(200 + i % 300, ssp::SCastEntry());
+            for (auto& entry : update.entries)
+                entry.c = i;
+            publisher.Publish(update);
+        }
+        done = true;
+    });
+
+    size_t torn = 0;
+    while (!done)
+    {
+        if (!subscriber.Read(cast, &version) || version == 1)
+            continue;
+        for (const auto& entry : cast.entries)
+            torn += entry.c != cast.entries.front().c;
+    }
+    writer.join();
+    REQUIRE(torn == 0);
+    REQUIRE(subscriber.Version() == 2001);
+
+    publisher.Close();
+    REQUIRE(subscriber.Read(cast));  // Still mapped after the publisher goes away
+    REQUIRE(cast.entries.front().c == 2000);
+
+    return;
+}
+
+
+TEST_CASE("Travel time and harmonic mean", "[active]")
+{
+    // Constant gradient, where the travel time has a closed form
+    ssp::SCast cast;
+    for (int n = 0; n <= 10; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 100.0;
+        entry.c = 1480.0 + 0.05 * entry.depth;
+        cast.entries.push_back(entry);
+    }
+    const auto Time = [](double z0, double z1) { return std::log((1480.0 + 0.05 * z1) / (1480.0 + 0.05 * z0)) / 0.05; };
+
+    auto profile = ssp::CompileProfile(cast);
+    REQUIRE(profile);
+    REQUIRE(profile->travelTime.size() == cast.entries.size());
+    REQUIRE(profile->TravelTime(0, 1000) == Approx(Time(0, 1000)).epsilon(1e-12));
+    REQUIRE(profile->TravelTime(730, 250) == Approx(Time(250, 730)).epsilon(1e-12));
+    REQUIRE(profile->HarmonicMean(0, 1000) == Approx(1000.0 / Time(0, 1000)).epsilon(1e-12));
+    REQUIRE(profile->HarmonicMean(500, 500) == Approx(1505.0));
+    REQUIRE(profile->TravelTime(-10, 0) == Approx(10.0 / 1480.0));  // Outside the cast the end speeds continue
+    REQUIRE(profile->TravelTime(1000, 1100) == Approx(100.0 / 1530.0));
+
+    std::vector<double> from = { 0, 5, 999, 420 }, to = { 1000, 655, 3, 420 }, time(4), mean(4);
+    profile->TravelTime(from.data(), to.data(), time.data(), from.size());
+    profile->HarmonicMean(from.data(), to.data(), mean.data(), from.size());
+    for (size_t n = 0; n < from.size(); ++n)
+    {
+        REQUIRE(time[n] == profile->TravelTime(from[n], to[n]));
+        REQUIRE(mean[n] == profile->HarmonicMean(from[n], to[n]));
+    }
+
+    // Many layers inside one lookup table step are searched rather than scanned
+    ssp::SCast dense;
+    for (int n = 0; n <= 100; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n * 0.01;
+        entry.c = 1500.0 + std::sin(n * 0.3);
+        dense.entries.push_back(entry);
+    }
+    ssp::SCastEntry deep;
+    deep.depth = 500;
+    deep.c = 1490;
+    dense.entries.push_back(deep);
+    auto uneven = ssp::CompileProfile(dense, 10.0);
+    REQUIRE(uneven);
+    for (double depth = 0.0; depth < 1.2; depth += 0.0037)
+    {
+        const size_t layer = uneven->Layer(depth);
+        REQUIRE(uneven->layers[layer].top <= depth);
+        REQUIRE((depth < uneven->layers[layer].bottom || layer + 1 == uneven->layers.size()));
+    }
+    REQUIRE(uneven->TravelTime(0, 500) == Approx(uneven->travelTime.back()));
+
+    return;
+}
+
+
+TEST_CASE("Active profile", "[active]")
+{
+    ssp::SCast cast;
+    for (double depth : { 30.0, 0.0, 10.0, 10.0, 100.0 })  // Out of order, with a repeated depth
+    {
+        ssp::SCastEntry entry;
+        entry.depth = depth;
+        entry.c = 1500 + depth;
+        cast.entries.push_back(entry);
+    }
+    auto compiled = ssp::CompileProfile(cast, 0.5);
+    REQUIRE(compiled);
+    REQUIRE(compiled->layers.size() == 3);
+    REQUIRE(compiled->Layer(-5) == 0);
+    REQUIRE(compiled->Layer(10) == 1);
+    REQUIRE(compiled->Layer(99.9) == 2);
+    REQUIRE(compiled->SoundSpeed(55) == Approx(1555));
+    REQUIRE(compiled->SoundSpeed(500) == Approx(1600));
+
+    ssp::ActiveProfile active;
+    REQUIRE_FALSE(active.Read());
+    REQUIRE(active.Publish(cast));
+    REQUIRE(active.Read()->SoundSpeed(20) == Approx(1520));
+    cast.entries.resize(1);
+    REQUIRE_FALSE(active.Publish(cast));  // Too short, keeps the old one
+    REQUIRE(active.Version() == 1);
+
+    // Every profile has one sound speed everywhere, and is poisoned just before it is freed
+    auto makeProfile = [](int id) {
+        ssp::SCast constant;
+        constant.entries.resize(50);
+        for (size_t n = 0; n < constant.entries.size(); ++n)
+        {
+            constant.entries[n].depth = n * 20.0;
+            constant.entries[n].c = 1400 + id % 200;
+        }
+        return std::shared_ptr<const ssp::SCompiledProfile>(new ssp::SCompiledProfile(*ssp::CompileProfile(constant)),
+            [](const ssp::SCompiledProfile* p) {
+                for (auto& layer : const_cast<ssp::SCompiledProfile*>(p)->layers)
+                    layer.c0 = -1;
+                delete p;
+            });
+    };
+
+    int swaps = 0;
+    active.Publish(makeProfile(swaps));
+
+    constexpr int numReaders = 4;
+    constexpr size_t queriesPerReader = 1000000;
+    std::atomic<int> readersDone{ 0 };
+    std::atomic<size_t> bad{ 0 };
+    std::vector<std::thread> readers;
+    for (int t = 0; t < numReaders; ++t)
+    {
+        readers.emplace_back([&, t]() {
+            size_t wrong = 0;
+            double depth = t;
+            for (size_t n = 0; n < queriesPerReader; n += 16)
+            {
+                auto profile = active.Read();
+                const double c = profile->SoundSpeed(0);
+                for (int q = 0; q < 16; ++q)
+                {
+                    depth = std::fmod(depth + 37.3, 1000);
+                    wrong += profile->SoundSpeed(depth) != c || c < 0;
+                }
+            }
+            bad += wrong;
+            ++readersDone;
+        });
+    }
+
+    while (readersDone < numReaders)
+        active.Publish(makeProfile(++swaps));
+    for (auto& reader : readers)
+        reader.join();
+
+    REQUIRE(bad == 0);
+    REQUIRE(swaps > 100);
+    REQUIRE(active.PendingReclaim() == 0);  // No readers left, so every replaced profile is gone
+    REQUIRE(active.Snapshot()->SoundSpeed(10) == 1400 + swaps % 200);
+
+    // Only threads holding a Reader use a slot, so more live threads than slots can take turns reading
+    {
+        const size_t numThreads = ssp::ActiveProfile::maxReaderThreads + 44;
+        std::mutex mutex;
+        std::condition_variable allRead;
+        size_t numRead = 0;
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            threads.emplace_back([&]() {
+                const bool ok = active.Read()->SoundSpeed(10) > 0;
+                std::unique_lock<std::mutex> lock(mutex);
+                numRead += ok;
+                allRead.notify_all();
+                allRead.wait(lock, [&]() { return numRead == numThreads; });  // Stay alive until everyone has read
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        REQUIRE(numRead == numThreads);
+    }
+
+    return;
+}
+
+
+#ifdef __linux__
+TEST_CASE("Directory watcher", "[watch]")
+{
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / "SspCppWatchTest";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    ssp::SCast cast;
+    for (int n = 0; n < 100; ++n)
+    {
+        ssp::SCastEntry entry;
+        entry.depth = n;
+        entry.c = 1480 + n * 0.1;
+        cast.entries.push_back(entry);
+    }
+    std::string contents;
+    REQUIRE(ssp::WriteCast(cast, ssp::eCastType::Asvp, contents));
+
+    std::mutex mutex;
+    std::condition_variable received;
+    std::map<std::string, size_t> entries;  // Entries read from each file name
+    auto callback = [&](const std::string& fileName, std::vector<ssp::SCast>& casts) {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries[fs::path(fileName).filename().string()] += casts.empty() ? 0 : casts[0].entries.size();
+        received.notify_one();
+    };
+
+    std::ofstream(dir / "existing.asvp") << contents;
+
+    ssp::SWatchOptions options;
+    options.settleTime = std::chrono::milliseconds(100);
+    options.numThreads = 2;
+    options.readExisting = true;
+    ssp::DirectoryWatcher watcher;
+    REQUIRE(watcher.Start(dir.string(), callback, options));
+    REQUIRE_FALSE(watcher.Start(dir.string(), callback, options));
+
+    std::ofstream(dir / "direct.asvp") << contents;
+    std::ofstream(dir / "notes.txt") << "Not a cast";
+
+    // Closed halfway through, then finished shortly after: read once, complete
+    std::ofstream(dir / "partial.asvp") << contents.substr(0, contents.size() / 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::ofstream(dir / "partial.asvp", std::ios::app) << contents.substr(contents.size() / 2);
+
+    // Written under a temporary name and renamed into place
+    std::ofstream(dir / ".renamed.asvp.part") << contents;
+    fs::rename(dir / ".renamed.asvp.part", dir / "renamed.asvp");
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(received.wait_for(lock, std::chrono::seconds(5), [&]() { return entries.size() == 4; }));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));  // Nothing else should show up
+    watcher.Stop();
+    REQUIRE_FALSE(watcher.IsRunning());
+
+    REQUIRE(entries.size() == 4);
+    for (const auto& name : { "existing.asvp", "direct.asvp", "partial.asvp", "renamed.asvp" })
+        REQUIRE(entries[name] == 100);
+    auto stats = watcher.Stats();
+    REQUIRE(stats.files == 4);
+    REQUIRE(stats.casts == 4);
+    REQUIRE(stats.failures == 0);
+
+    // A throwing callback is counted as a failure and does not stop the workers
+    ssp::DirectoryWatcher throwing;
+    options.readExisting = false;
+    REQUIRE(throwing.Start(dir.string(), [](const std::string&, std::vector<ssp::SCast>&) {
+        throw std::runtime_error("Callback failure");
+    }, options));
+    std::ofstream(dir / "throw1.asvp") << contents;
+    std::ofstream(dir / "throw2.asvp") << contents;
+    for (int n = 0; n < 500 && throwing.Stats().files < 2; ++n)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(throwing.IsRunning());
+    throwing.Stop();
+    REQUIRE(throwing.Stats().files == 2);
+    REQUIRE(throwing.Stats().failures == 2);
+
+    fs::remove_all(dir);
+    return;
+}
+#endif